@@ -408,6 +408,20 @@
 #endif
 #endif
 
+// ABSL_HAVE_COROUTINES
+//
+// Checks whether C++20 coroutines, and the <coroutine> header, are available.
+#ifdef ABSL_HAVE_COROUTINES
+#error "ABSL_HAVE_COROUTINES cannot be directly set."
+#endif
+
+#ifdef __has_include
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine) && \
+    __cpp_impl_coroutine >= 201902L
+#define ABSL_HAVE_COROUTINES 1
+#endif
+#endif
+
 // For MSVC, `__has_include` is supported in VS 2017 15.3, which is later than
 // the support for <optional>, <any>, <string_view>, <variant>. So we use
 // _MSC_VER to check whether we have VS 2017 RTM (when <optional>, <any>,
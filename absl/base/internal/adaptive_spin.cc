@@ -0,0 +1,99 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/base/internal/adaptive_spin.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/attributes.h"
+
+namespace absl {
+namespace base_internal {
+
+namespace {
+
+// Number of estimates; must be a power of two.
+constexpr int kTableBits = 10;
+constexpr int kTableSize = 1 << kTableBits;
+
+// Threads always spin at least this long, so that an estimate that has fallen
+// to zero can grow again when hold times become short.
+constexpr int kMinSpins = 16;
+
+// Weight of a new observation in the estimate is 1 / 2^kSmoothingShift.
+constexpr int kSmoothingShift = 3;
+
+ABSL_CONST_INIT std::atomic<bool> adaptive_spinning_enabled(true);
+
+// Estimates are stored relative to `default_spins / 2`, the estimate for
+// which the spin limit equals the non-adaptive one, so that the
+// zero-initialized table starts out with the non-adaptive behavior.
+std::atomic<int32_t> estimate_deltas[kTableSize];
+
+std::atomic<int32_t> &DeltaFor(const void *lock) {
+  // Locks are at least pointer aligned, and nearby locks should not collide.
+  const uint64_t h =
+      static_cast<uint64_t>(reinterpret_cast<uintptr_t>(lock) >> 3) *
+      uint64_t{0x9E3779B97F4A7C15};
+  return estimate_deltas[h >> (64 - kTableBits)];
+}
+
+}  // namespace
+
+int AdaptiveSpinLimit(const void *lock, int default_spins, bool has_waiters) {
+  if (default_spins <= 1 ||
+      !adaptive_spinning_enabled.load(std::memory_order_relaxed)) {
+    return default_spins;
+  }
+  const int estimate =
+      default_spins / 2 + DeltaFor(lock).load(std::memory_order_relaxed);
+  int limit = 2 * estimate + kMinSpins;
+  if (has_waiters) limit /= 2;
+  return std::max(limit, kMinSpins);
+}
+
+void AdaptiveSpinUpdate(const void *lock, int default_spins, int spins,
+                        bool acquired) {
+  if (default_spins <= 1 ||
+      !adaptive_spinning_enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  std::atomic<int32_t> &delta = DeltaFor(lock);
+  const int32_t old_delta = delta.load(std::memory_order_relaxed);
+  const int32_t old_estimate = default_spins / 2 + old_delta;
+  // A failed spin is evidence that spinning does not pay off for this lock.
+  const int32_t observed = acquired ? spins : 0;
+  int32_t estimate =
+      old_estimate + (observed - old_estimate) / (1 << kSmoothingShift);
+  // Without this, an estimate within 2^kSmoothingShift of the observation
+  // would never move.
+  if (estimate == old_estimate && observed != old_estimate) {
+    estimate += observed > old_estimate ? 1 : -1;
+  }
+  // Never spin more than twice as long as without adaptation.
+  estimate = std::min(std::max(estimate, int32_t{0}), int32_t{default_spins});
+  const int32_t new_delta = estimate - default_spins / 2;
+  if (new_delta != old_delta) {
+    delta.store(new_delta, std::memory_order_relaxed);
+  }
+}
+
+void SetAdaptiveSpinning(bool enabled) {
+  adaptive_spinning_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+}  // namespace base_internal
+}  // namespace absl
@@ -0,0 +1,62 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Adaptive spin limits shared by absl::Mutex and base_internal::SpinLock.
+//
+// A thread that finds a lock held spins for a while before going to sleep,
+// since sleeping and waking cost several microseconds. How long is worth
+// spinning depends on how long the lock is typically held: too little and a
+// thread sleeps just before the lock is released, too much and it burns a CPU
+// on a lock that stays held for a long time.
+//
+// Each lock therefore keeps an estimate of the number of spin iterations after
+// which it was recently acquired, and threads spin for about twice that long.
+// Spins that fail pull the estimate down, so locks with long hold times
+// quickly stop being spun on. Threads spin only half as long when the lock
+// already has sleeping waiters, as a released lock is then likely to be handed
+// to one of them.
+//
+// To leave the size of the locks unchanged, estimates are kept in a fixed
+// table indexed by a hash of the lock's address. Locks that collide share an
+// estimate. All accesses are relaxed and may race; a lost update only delays
+// adaptation.
+//
+// This code must not use any lock itself, as it is used by SpinLock.
+
+#ifndef ABSL_BASE_INTERNAL_ADAPTIVE_SPIN_H_
+#define ABSL_BASE_INTERNAL_ADAPTIVE_SPIN_H_
+
+namespace absl {
+namespace base_internal {
+
+// Returns the number of iterations to spin on `lock` before sleeping, for a
+// lock type that without adaptation spins for `default_spins` iterations.
+// `has_waiters` is whether the lock is known to have sleeping waiters.
+int AdaptiveSpinLimit(const void *lock, int default_spins, bool has_waiters);
+
+// Records that a thread spun for `spins` iterations on `lock`, and then either
+// acquired it (or saw it released) if `acquired`, or gave up and went to sleep
+// otherwise. `default_spins` must match the value passed to
+// AdaptiveSpinLimit().
+void AdaptiveSpinUpdate(const void *lock, int default_spins, int spins,
+                        bool acquired);
+
+// Enables or disables adaptation. While disabled, AdaptiveSpinLimit() returns
+// `default_spins` and AdaptiveSpinUpdate() does nothing. Enabled by default.
+void SetAdaptiveSpinning(bool enabled);
+
+}  // namespace base_internal
+}  // namespace absl
+
+#endif  // ABSL_BASE_INTERNAL_ADAPTIVE_SPIN_H_
@@ -0,0 +1,92 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/base/internal/adaptive_spin.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+using absl::base_internal::AdaptiveSpinLimit;
+using absl::base_internal::AdaptiveSpinUpdate;
+using absl::base_internal::SetAdaptiveSpinning;
+using ::testing::AllOf;
+using ::testing::Ge;
+using ::testing::Le;
+
+constexpr int kDefaultSpins = 1000;
+
+// Stands in for a lock; each test uses its own so that they do not share an
+// estimate.
+struct alignas(64) FakeLock {
+  char bytes[64];
+};
+
+TEST(AdaptiveSpin, StartsNearDefault) {
+  static FakeLock lock;
+  EXPECT_THAT(AdaptiveSpinLimit(&lock, kDefaultSpins, false),
+              AllOf(Ge(kDefaultSpins), Le(kDefaultSpins + 32)));
+}
+
+TEST(AdaptiveSpin, FailedSpinsShortenLimit) {
+  static FakeLock lock;
+  for (int i = 0; i < 200; ++i) {
+    const int limit = AdaptiveSpinLimit(&lock, kDefaultSpins, false);
+    AdaptiveSpinUpdate(&lock, kDefaultSpins, limit, false);
+  }
+  EXPECT_LE(AdaptiveSpinLimit(&lock, kDefaultSpins, false), 32);
+}
+
+TEST(AdaptiveSpin, TracksSuccessfulSpins) {
+  static FakeLock lock;
+  for (int i = 0; i < 200; ++i) {
+    AdaptiveSpinUpdate(&lock, kDefaultSpins, 100, true);
+  }
+  EXPECT_THAT(AdaptiveSpinLimit(&lock, kDefaultSpins, false),
+              AllOf(Ge(200), Le(240)));
+
+  // Long successful spins raise the limit, up to twice the default.
+  for (int i = 0; i < 200; ++i) {
+    AdaptiveSpinUpdate(&lock, kDefaultSpins, 10 * kDefaultSpins, true);
+  }
+  EXPECT_THAT(AdaptiveSpinLimit(&lock, kDefaultSpins, false),
+              AllOf(Ge(2 * kDefaultSpins), Le(2 * kDefaultSpins + 32)));
+}
+
+TEST(AdaptiveSpin, WaitersHalveLimit) {
+  static FakeLock lock;
+  EXPECT_EQ(AdaptiveSpinLimit(&lock, kDefaultSpins, true),
+            AdaptiveSpinLimit(&lock, kDefaultSpins, false) / 2);
+}
+
+TEST(AdaptiveSpin, NoSpinningStaysOff) {
+  static FakeLock lock;
+  EXPECT_EQ(AdaptiveSpinLimit(&lock, 0, false), 0);
+  EXPECT_EQ(AdaptiveSpinLimit(&lock, 1, true), 1);
+}
+
+TEST(AdaptiveSpin, Disable) {
+  static FakeLock lock;
+  SetAdaptiveSpinning(false);
+  for (int i = 0; i < 200; ++i) {
+    AdaptiveSpinUpdate(&lock, kDefaultSpins, 0, false);
+  }
+  EXPECT_EQ(AdaptiveSpinLimit(&lock, kDefaultSpins, true), kDefaultSpins);
+  SetAdaptiveSpinning(true);
+  EXPECT_THAT(AdaptiveSpinLimit(&lock, kDefaultSpins, false),
+              AllOf(Ge(kDefaultSpins), Le(kDefaultSpins + 32)));
+}
+
+}  // namespace
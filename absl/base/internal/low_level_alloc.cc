@@ -24,6 +24,7 @@
 #include "absl/base/call_once.h"
 #include "absl/base/config.h"
 #include "absl/base/internal/direct_mmap.h"
+#include "absl/base/internal/per_thread_tls.h"
 #include "absl/base/internal/scheduling_mode.h"
 #include "absl/base/macros.h"
 #include "absl/base/thread_annotations.h"
@@ -52,6 +53,7 @@
 #include "absl/base/dynamic_annotations.h"
 #include "absl/base/internal/raw_logging.h"
 #include "absl/base/internal/spinlock.h"
+#include "absl/base/optimization.h"
 
 // MAP_ANONYMOUS
 #if defined(__APPLE__)
@@ -193,6 +195,50 @@ static void LLA_SkiplistDelete(AllocList *head, AllocList *e,
   }
 }
 
+// ---------------------------------------------------------------------------
+// Block caches
+
+// Small blocks are kept in caches in front of each arena's free list, so
+// that threads allocating and freeing them mostly take their own cache's
+// lock instead of the arena's.  A block of up to kMaxCachedUnits times the
+// arena's roundup bytes, header included, stays allocated as far as the
+// free list is concerned while it is cached.
+static const int kMaxCachedUnits = 16;
+
+// The number of caches per arena.  Each thread uses one of them, chosen
+// round-robin when it first allocates, so threads share a cache only when
+// there are more than kNumBlockCaches of them.
+static const int kNumBlockCaches = 16;
+
+// A cache holds at most this many bytes of blocks of each size, and fetches
+// or returns half as much at a time, under one acquisition of the arena lock.
+static const size_t kMaxCachedBytes = 4096;
+
+namespace {
+struct BlockCacheState {
+  BlockCacheState()
+      : mu(base_internal::SCHEDULE_KERNEL_ONLY), blocks(), count() {}
+
+  // Acquired with TryLock() by Alloc() and Free(), so that a signal handler
+  // interrupting a thread that holds it goes to the arena instead of
+  // deadlocking.
+  base_internal::SpinLock mu;
+  // Lists of cached blocks, indexed by size in units of the arena's roundup,
+  // and linked through next[0].
+  AllocList *blocks[kMaxCachedUnits + 1] GUARDED_BY(mu);
+  int32_t count[kMaxCachedUnits + 1] GUARDED_BY(mu);
+};
+
+// A BlockCache padded so that no two caches in an arena share a cache line.
+// Arenas are not cache-line aligned, so the padding is at least a line long
+// rather than rounding up to the next boundary.
+struct BlockCache : BlockCacheState {
+  char padding[(sizeof(BlockCacheState) + 2 * ABSL_CACHELINE_SIZE - 1) /
+                   ABSL_CACHELINE_SIZE * ABSL_CACHELINE_SIZE -
+               sizeof(BlockCacheState)];
+};
+}  // namespace
+
 // ---------------------------------------------------------------------------
 // Arena implementation
 
@@ -216,6 +262,13 @@ struct LowLevelAlloc::Arena {
   const size_t min_size;
   // PRNG state
   uint32_t random GUARDED_BY(mu);
+  // Bytes mapped, and bytes in blocks not on the free list
+  size_t bytes_mapped GUARDED_BY(mu);
+  size_t bytes_allocated GUARDED_BY(mu);
+  // Keeps the first cache off the cache line of the fields above.
+  char caches_padding[ABSL_CACHELINE_SIZE];
+  // Caches of small blocks; see BlockCache.
+  BlockCache caches[kNumBlockCaches];
 };
 
 namespace {
@@ -273,6 +326,8 @@ LowLevelAlloc::Arena *LowLevelAlloc::DefaultArena() {
 // magic numbers to identify allocated and unallocated blocks
 static const uintptr_t kMagicAllocated = 0x4c833e95U;
 static const uintptr_t kMagicUnallocated = ~kMagicAllocated;
+// Marks allocated blocks held in a BlockCache, to catch double frees.
+static const uintptr_t kMagicCached = 0x1bd5a7c3U;
 
 namespace {
 class SCOPED_LOCKABLE ArenaLock {
@@ -347,7 +402,9 @@ LowLevelAlloc::Arena::Arena(uint32_t flags_value)
       pagesize(GetPageSize()),
       roundup(RoundedUpBlockSize()),
       min_size(2 * roundup),
-      random(0) {
+      random(0),
+      bytes_mapped(0),
+      bytes_allocated(0) {
   freelist.header.size = 0;
   freelist.header.magic =
       Magic(kMagicUnallocated, &freelist.header);
@@ -372,11 +429,48 @@ LowLevelAlloc::Arena *LowLevelAlloc::NewArena(int32_t flags) {
   return result;
 }
 
+static void DrainBlockCache(LowLevelAlloc::Arena *arena, BlockCache *cache,
+                            int units, int n);
+
+#ifndef _WIN32
+// Maps or unmaps anonymous memory for "arena", bypassing any mmap hooks if
+// the arena must be async-signal-safe.
+static void *MmapForArena(LowLevelAlloc::Arena *arena, size_t size,
+                          int extra_flags) {
+#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+  if ((arena->flags & LowLevelAlloc::kAsyncSignalSafe) != 0) {
+    return base_internal::DirectMmap(nullptr, size, PROT_WRITE | PROT_READ,
+                                     MAP_ANONYMOUS | MAP_PRIVATE | extra_flags,
+                                     -1, 0);
+  }
+#endif  // ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+  return mmap(nullptr, size, PROT_WRITE | PROT_READ,
+              MAP_ANONYMOUS | MAP_PRIVATE | extra_flags, -1, 0);
+}
+
+static int MunmapForArena(LowLevelAlloc::Arena *arena, void *region,
+                          size_t size) {
+#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+  if ((arena->flags & LowLevelAlloc::kAsyncSignalSafe) != 0) {
+    return base_internal::DirectMunmap(region, size);
+  }
+#endif  // ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+  return munmap(region, size);
+}
+#endif  // _WIN32
+
 // L < arena->mu, L < arena->arena->mu
 bool LowLevelAlloc::DeleteArena(Arena *arena) {
   ABSL_RAW_CHECK(
       arena != nullptr && arena != DefaultArena() && arena != UnhookedArena(),
       "may not delete default arena");
+  for (BlockCache &cache : arena->caches) {
+    cache.mu.Lock();
+    for (int units = 0; units <= kMaxCachedUnits; units++) {
+      DrainBlockCache(arena, &cache, units, cache.count[units]);
+    }
+    cache.mu.Unlock();
+  }
   ArenaLock section(arena);
   if (arena->allocation_count != 0) {
     section.Leave();
@@ -401,15 +495,7 @@ bool LowLevelAlloc::DeleteArena(Arena *arena) {
     ABSL_RAW_CHECK(munmap_result != 0,
                    "LowLevelAlloc::DeleteArena: VitualFree failed");
 #else
-#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
-    if ((arena->flags & LowLevelAlloc::kAsyncSignalSafe) == 0) {
-      munmap_result = munmap(region, size);
-    } else {
-      munmap_result = base_internal::DirectMunmap(region, size);
-    }
-#else
-    munmap_result = munmap(region, size);
-#endif  // ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+    munmap_result = MunmapForArena(arena, region, size);
     if (munmap_result != 0) {
       ABSL_RAW_LOG(FATAL, "LowLevelAlloc::DeleteArena: munmap failed: %d",
                    errno);
@@ -497,6 +583,223 @@ static void AddToFreelist(void *v, LowLevelAlloc::Arena *arena) {
   Coalesce(prev[0]);            // maybe coalesce with predecessor
 }
 
+// Returns the index of the BlockCache used by the calling thread.
+static int ThisThreadsBlockCache() {
+#if ABSL_PER_THREAD_TLS
+  ABSL_CONST_INIT static std::atomic<uint32_t> next_cache(0);
+  // One more than the index, or zero if not yet chosen.
+  static ABSL_PER_THREAD_TLS_KEYWORD uint32_t thread_cache = 0;
+  uint32_t c = thread_cache;
+  if (ABSL_PREDICT_FALSE(c == 0)) {
+    c = next_cache.fetch_add(1, std::memory_order_relaxed) % kNumBlockCaches +
+        1;
+    thread_cache = c;
+  }
+  return static_cast<int>(c - 1);
+#else
+  // Threads run on distinct stacks.
+  char here;
+  const uintptr_t sp = reinterpret_cast<uintptr_t>(&here);
+  return static_cast<int>(((sp >> 16) ^ (sp >> 24)) % kNumBlockCaches);
+#endif
+}
+
+// The size of the huge pages requested by kTransparentHugePages and
+// kExplicitHugePages.
+static const size_t kHugePageSize = 2 << 20;
+static const int32_t kHugePageFlags =
+    LowLevelAlloc::kTransparentHugePages | LowLevelAlloc::kExplicitHugePages;
+
+// Maps "size" bytes of new memory for "arena", which must be a multiple of
+// kHugePageSize if the arena asks for huge pages.
+// L < arena->mu
+static void *MapPages(LowLevelAlloc::Arena *arena, size_t size) {
+  void *new_pages;
+#ifdef _WIN32
+  new_pages = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  ABSL_RAW_CHECK(new_pages != nullptr, "VirtualAlloc failed");
+#else
+  new_pages = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if ((arena->flags & LowLevelAlloc::kExplicitHugePages) != 0) {
+    // Fails unless huge pages have been reserved for the pool.
+    new_pages = MmapForArena(arena, size, MAP_HUGETLB);
+  }
+#endif  // MAP_HUGETLB
+  if (new_pages == MAP_FAILED && (arena->flags & kHugePageFlags) != 0) {
+    // Map one huge page more than needed, and unmap the ends so that what
+    // remains is aligned to a huge page.
+    char *p = static_cast<char *>(MmapForArena(arena, size + kHugePageSize, 0));
+    if (p != MAP_FAILED) {
+      char *aligned = reinterpret_cast<char *>(
+          RoundUp(reinterpret_cast<uintptr_t>(p), kHugePageSize));
+      if (aligned != p) {
+        ABSL_RAW_CHECK(MunmapForArena(arena, p, aligned - p) == 0,
+                       "munmap failed");
+      }
+      ABSL_RAW_CHECK(
+          MunmapForArena(arena, aligned + size, p + kHugePageSize - aligned) ==
+              0,
+          "munmap failed");
+#ifdef MADV_HUGEPAGE
+      // Only advice; the kernel may not support transparent huge pages.
+      madvise(aligned, size, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+      new_pages = aligned;
+    }
+  }
+  if (new_pages == MAP_FAILED) {
+    new_pages = MmapForArena(arena, size, 0);
+  }
+  if (new_pages == MAP_FAILED) {
+    ABSL_RAW_LOG(FATAL, "mmap error: %d", errno);
+  }
+#endif  // _WIN32
+  return new_pages;
+}
+
+// Removes a region of at least req_rnd bytes from the free list, mapping
+// more pages if none is big enough, and returns it marked allocated.
+// L >= arena->mu; releases and reacquires it while mapping pages.
+static AllocList *AllocFromFreelist(LowLevelAlloc::Arena *arena,
+                                    size_t req_rnd) {
+  AllocList *s;       // will point to region that satisfies request
+  for (;;) {      // loop until we find a suitable region
+    // find the minimum levels that a block of this size must have
+    int i = LLA_SkiplistLevels(req_rnd, arena->min_size, nullptr) - 1;
+    if (i < arena->freelist.levels) {   // potential blocks exist
+      AllocList *before = &arena->freelist;  // predecessor of s
+      while ((s = Next(i, before, arena)) != nullptr &&
+             s->header.size < req_rnd) {
+        before = s;
+      }
+      if (s != nullptr) {       // we found a region
+        break;
+      }
+    }
+    // we unlock before mmap() both because mmap() may call a callback hook,
+    // and because it may be slow.
+    arena->mu.Unlock();
+    // mmap generous 64K chunks, or whole huge pages, to decrease
+    // the chances/impact of fragmentation:
+    size_t new_pages_size =
+        RoundUp(req_rnd, (arena->flags & kHugePageFlags) != 0
+                             ? kHugePageSize
+                             : arena->pagesize * 16);
+    void *new_pages = MapPages(arena, new_pages_size);
+    arena->mu.Lock();
+    arena->bytes_mapped += new_pages_size;
+    s = reinterpret_cast<AllocList *>(new_pages);
+    s->header.size = new_pages_size;
+    // Pretend the block is allocated; call AddToFreelist() to free it.
+    s->header.magic = Magic(kMagicAllocated, &s->header);
+    s->header.arena = arena;
+    AddToFreelist(&s->levels, arena);  // insert new region into free list
+  }
+  AllocList *prev[kMaxLevel];
+  LLA_SkiplistDelete(&arena->freelist, s, prev);    // remove from free list
+  // s points to the first free region that's big enough
+  if (CheckedAdd(req_rnd, arena->min_size) <= s->header.size) {
+    // big enough to split
+    AllocList *n = reinterpret_cast<AllocList *>
+                      (req_rnd + reinterpret_cast<char *>(s));
+    n->header.size = s->header.size - req_rnd;
+    n->header.magic = Magic(kMagicAllocated, &n->header);
+    n->header.arena = arena;
+    s->header.size = req_rnd;
+    AddToFreelist(&n->levels, arena);
+  }
+  s->header.magic = Magic(kMagicAllocated, &s->header);
+  ABSL_RAW_CHECK(s->header.arena == arena, "");
+  arena->allocation_count++;
+  arena->bytes_allocated += s->header.size;
+  return s;
+}
+
+// Returns the n most recently cached blocks of the given size to the free
+// list.
+// L >= cache->mu, L < arena->mu
+static void DrainBlockCache(LowLevelAlloc::Arena *arena, BlockCache *cache,
+                            int units, int n) {
+  if (n == 0) return;
+  ArenaLock section(arena);
+  for (int i = 0; i != n; i++) {
+    AllocList *f = cache->blocks[units];
+    cache->blocks[units] = f->next[0];
+    f->header.magic = Magic(kMagicAllocated, &f->header);
+    arena->bytes_allocated -= f->header.size;
+    AddToFreelist(&f->levels, arena);
+  }
+  cache->count[units] -= n;
+  ABSL_RAW_CHECK(arena->allocation_count >= n, "nothing in arena to free");
+  arena->allocation_count -= n;
+  section.Leave();
+}
+
+// Allocates a block of req_rnd bytes from the calling thread's cache,
+// refilling it from the arena with blocks carved from a single region if it
+// is empty, or from the arena directly if the cache is in use.
+// L < arena->mu
+static AllocList *AllocFromBlockCache(LowLevelAlloc::Arena *arena,
+                                      size_t req_rnd) {
+  BlockCache *cache = &arena->caches[ThisThreadsBlockCache()];
+  if (!cache->mu.TryLock()) {
+    ArenaLock section(arena);
+    AllocList *s = AllocFromFreelist(arena, req_rnd);
+    section.Leave();
+    return s;
+  }
+  const int units = static_cast<int>(req_rnd / arena->roundup);
+  AllocList *s = cache->blocks[units];
+  if (s != nullptr) {
+    cache->blocks[units] = s->next[0];
+    cache->count[units]--;
+  } else {
+    const int n = std::max<int>(1, kMaxCachedBytes / 2 / req_rnd);
+    ArenaLock section(arena);
+    s = AllocFromFreelist(arena, n * req_rnd);
+    arena->allocation_count += n - 1;
+    section.Leave();
+    // s may be a little larger than asked for, which stays with the block
+    // returned to the caller.
+    char *block = reinterpret_cast<char *>(s) + s->header.size;
+    s->header.size -= (n - 1) * req_rnd;
+    for (int i = 1; i != n; i++) {
+      block -= req_rnd;
+      AllocList *b = reinterpret_cast<AllocList *>(block);
+      b->header.size = req_rnd;
+      b->header.magic = Magic(kMagicCached, &b->header);
+      b->header.arena = arena;
+      b->next[0] = cache->blocks[units];
+      cache->blocks[units] = b;
+    }
+    cache->count[units] += n - 1;
+  }
+  cache->mu.Unlock();
+  s->header.magic = Magic(kMagicAllocated, &s->header);
+  return s;
+}
+
+// Adds the allocated block f to the calling thread's cache, returning half
+// of the cached blocks of its size to the arena if there are too many.
+// Returns false if the cache is in use.
+// L < arena->mu
+static bool FreeToBlockCache(LowLevelAlloc::Arena *arena, AllocList *f) {
+  BlockCache *cache = &arena->caches[ThisThreadsBlockCache()];
+  if (!cache->mu.TryLock()) {
+    return false;
+  }
+  const int units = static_cast<int>(f->header.size / arena->roundup);
+  f->header.magic = Magic(kMagicCached, &f->header);
+  f->next[0] = cache->blocks[units];
+  cache->blocks[units] = f;
+  if (++cache->count[units] * f->header.size > kMaxCachedBytes) {
+    DrainBlockCache(arena, cache, units, cache->count[units] / 2);
+  }
+  cache->mu.Unlock();
+  return true;
+}
+
 // Frees storage allocated by LowLevelAlloc::Alloc().
 // L < arena->mu
 void LowLevelAlloc::Free(void *v) {
@@ -506,7 +809,12 @@ void LowLevelAlloc::Free(void *v) {
     ABSL_RAW_CHECK(f->header.magic == Magic(kMagicAllocated, &f->header),
                    "bad magic number in Free()");
     LowLevelAlloc::Arena *arena = f->header.arena;
+    if (f->header.size <= kMaxCachedUnits * arena->roundup &&
+        FreeToBlockCache(arena, f)) {
+      return;
+    }
     ArenaLock section(arena);
+    arena->bytes_allocated -= f->header.size;
     AddToFreelist(v, arena);
     ABSL_RAW_CHECK(arena->allocation_count > 0, "nothing in arena to free");
     arena->allocation_count--;
@@ -520,83 +828,45 @@ static void *DoAllocWithArena(size_t request, LowLevelAlloc::Arena *arena) {
   void *result = nullptr;
   if (request != 0) {
     AllocList *s;       // will point to region that satisfies request
-    ArenaLock section(arena);
     // round up with header
     size_t req_rnd = RoundUp(CheckedAdd(request, sizeof (s->header)),
                              arena->roundup);
-    for (;;) {      // loop until we find a suitable region
-      // find the minimum levels that a block of this size must have
-      int i = LLA_SkiplistLevels(req_rnd, arena->min_size, nullptr) - 1;
-      if (i < arena->freelist.levels) {   // potential blocks exist
-        AllocList *before = &arena->freelist;  // predecessor of s
-        while ((s = Next(i, before, arena)) != nullptr &&
-               s->header.size < req_rnd) {
-          before = s;
-        }
-        if (s != nullptr) {       // we found a region
-          break;
-        }
-      }
-      // we unlock before mmap() both because mmap() may call a callback hook,
-      // and because it may be slow.
-      arena->mu.Unlock();
-      // mmap generous 64K chunks to decrease
-      // the chances/impact of fragmentation:
-      size_t new_pages_size = RoundUp(req_rnd, arena->pagesize * 16);
-      void *new_pages;
-#ifdef _WIN32
-      new_pages = VirtualAlloc(0, new_pages_size,
-                               MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
-      ABSL_RAW_CHECK(new_pages != nullptr, "VirtualAlloc failed");
-#else
-#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
-      if ((arena->flags & LowLevelAlloc::kAsyncSignalSafe) != 0) {
-        new_pages = base_internal::DirectMmap(nullptr, new_pages_size,
-            PROT_WRITE|PROT_READ, MAP_ANONYMOUS|MAP_PRIVATE, -1, 0);
-      } else {
-        new_pages = mmap(nullptr, new_pages_size, PROT_WRITE | PROT_READ,
-                         MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
-      }
-#else
-      new_pages = mmap(nullptr, new_pages_size, PROT_WRITE | PROT_READ,
-                       MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
-#endif  // ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
-      if (new_pages == MAP_FAILED) {
-        ABSL_RAW_LOG(FATAL, "mmap error: %d", errno);
-      }
-
-#endif  // _WIN32
-      arena->mu.Lock();
-      s = reinterpret_cast<AllocList *>(new_pages);
-      s->header.size = new_pages_size;
-      // Pretend the block is allocated; call AddToFreelist() to free it.
-      s->header.magic = Magic(kMagicAllocated, &s->header);
-      s->header.arena = arena;
-      AddToFreelist(&s->levels, arena);  // insert new region into free list
-    }
-    AllocList *prev[kMaxLevel];
-    LLA_SkiplistDelete(&arena->freelist, s, prev);    // remove from free list
-    // s points to the first free region that's big enough
-    if (CheckedAdd(req_rnd, arena->min_size) <= s->header.size) {
-      // big enough to split
-      AllocList *n = reinterpret_cast<AllocList *>
-                        (req_rnd + reinterpret_cast<char *>(s));
-      n->header.size = s->header.size - req_rnd;
-      n->header.magic = Magic(kMagicAllocated, &n->header);
-      n->header.arena = arena;
-      s->header.size = req_rnd;
-      AddToFreelist(&n->levels, arena);
+    if (req_rnd <= kMaxCachedUnits * arena->roundup) {
+      s = AllocFromBlockCache(arena, req_rnd);
+    } else {
+      ArenaLock section(arena);
+      s = AllocFromFreelist(arena, req_rnd);
+      section.Leave();
     }
-    s->header.magic = Magic(kMagicAllocated, &s->header);
-    ABSL_RAW_CHECK(s->header.arena == arena, "");
-    arena->allocation_count++;
-    section.Leave();
     result = &s->levels;
   }
   ANNOTATE_MEMORY_IS_UNINITIALIZED(result, request);
   return result;
 }
 
+LowLevelAlloc::ArenaStats LowLevelAlloc::GetArenaStats(Arena *arena) {
+  ArenaStats stats = {};
+  for (BlockCache &cache : arena->caches) {
+    cache.mu.Lock();
+    for (int units = 0; units <= kMaxCachedUnits; units++) {
+      stats.bytes_cached += cache.count[units] * units * arena->roundup;
+    }
+    cache.mu.Unlock();
+  }
+  ArenaLock section(arena);
+  stats.bytes_mapped = arena->bytes_mapped;
+  stats.bytes_in_use = arena->bytes_allocated -
+                       std::min(stats.bytes_cached, arena->bytes_allocated);
+  for (AllocList *f = arena->freelist.next[0]; f != nullptr; f = f->next[0]) {
+    stats.bytes_free += f->header.size;
+    stats.free_blocks++;
+    stats.largest_free_block =
+        std::max<size_t>(stats.largest_free_block, f->header.size);
+  }
+  section.Leave();
+  return stats;
+}
+
 void *LowLevelAlloc::Alloc(size_t request) {
   void *result = DoAllocWithArena(request, DefaultArena());
   return result;
@@ -96,6 +96,15 @@ class LowLevelAlloc {
     // DefaultArena(). Not supported on all platforms.
     kAsyncSignalSafe = 0x0002,
 #endif
+
+    // Map memory in 2 MiB chunks aligned to 2 MiB, and ask the kernel to back
+    // them with transparent huge pages where it supports them, to reduce TLB
+    // misses in large arenas.
+    kTransparentHugePages = 0x0004,
+
+    // Map memory from the explicit huge page pool (MAP_HUGETLB) where
+    // available, and as with kTransparentHugePages if the pool is empty.
+    kExplicitHugePages = 0x0008,
   };
   // Construct a new arena.  The allocation of the underlying metadata honors
   // the provided flags.  For example, the call NewArena(kAsyncSignalSafe)
@@ -113,6 +122,29 @@ class LowLevelAlloc {
   // The default arena that always exists.
   static Arena *DefaultArena();
 
+  // Memory usage of an arena, in bytes unless noted otherwise.  Blocks are
+  // counted with their headers and rounding, so that bytes_mapped is the sum
+  // of bytes_in_use, bytes_cached and bytes_free.
+  struct ArenaStats {
+    // Memory mapped from the operating system.
+    size_t bytes_mapped;
+    // Blocks allocated and not yet freed.
+    size_t bytes_in_use;
+    // Freed small blocks held by the arena's per-thread caches for reuse.
+    size_t bytes_cached;
+    // Blocks on the free list, how many there are, and the largest one; a
+    // large number of blocks or a small largest block relative to
+    // bytes_free indicates fragmentation.
+    size_t bytes_free;
+    size_t free_blocks;
+    size_t largest_free_block;
+  };
+
+  // Returns the memory usage of "arena".  The statistics are consistent only
+  // while no other thread allocates from or frees to the arena.  Not
+  // async-signal-safe.
+  static ArenaStats GetArenaStats(Arena *arena);
+
  private:
   LowLevelAlloc();      // no instances
 };
@@ -0,0 +1,62 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/base/internal/low_level_alloc.h"
+
+namespace {
+
+using absl::base_internal::LowLevelAlloc;
+
+// Every thread allocates state.range(1) blocks of state.range(0) bytes from
+// one arena, then frees them, in a loop.
+void BM_AllocFree(benchmark::State& state, int32_t flags) {
+  static LowLevelAlloc::Arena* arena;
+  if (state.thread_index == 0) arena = LowLevelAlloc::NewArena(flags);
+  const size_t size = state.range(0);
+  void* blocks[16];
+  const int n = state.range(1);
+  for (auto _ : state) {
+    for (int i = 0; i != n; i++) {
+      blocks[i] = LowLevelAlloc::AllocWithArena(size, arena);
+    }
+    benchmark::DoNotOptimize(blocks);
+    for (int i = 0; i != n; i++) {
+      LowLevelAlloc::Free(blocks[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+  if (state.thread_index == 0) LowLevelAlloc::DeleteArena(arena);
+}
+
+void SetUpAllocFree(benchmark::internal::Benchmark* bm) {
+  // Sizes that the block caches hold, and one that they do not.
+  for (int size : {16, 128, 1024}) {
+    bm->Args({size, 1})->Args({size, 16});
+  }
+  bm->ThreadRange(1, 64);
+  bm->UseRealTime();
+}
+
+BENCHMARK_CAPTURE(BM_AllocFree, plain, 0)->Apply(SetUpAllocFree);
+#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+BENCHMARK_CAPTURE(BM_AllocFree, async_signal_safe,
+                  LowLevelAlloc::kAsyncSignalSafe)
+    ->Apply(SetUpAllocFree);
+#endif
+
+}  // namespace
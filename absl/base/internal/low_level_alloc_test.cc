@@ -20,6 +20,7 @@
 #include <thread>  // NOLINT(build/c++11)
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace absl {
 namespace base_internal {
@@ -137,12 +138,85 @@ static void Test(bool use_new_arena, bool call_malloc_hook, int n) {
     TEST_ASSERT(LowLevelAlloc::DeleteArena(arena));
   }
 }
+
+// num_threads threads each allocate and free n blocks of sizes around the
+// largest that the per-thread block caches hold, in one arena.  The blocks
+// each thread still holds at the end are freed by the calling thread.
+static void ThreadedTest(int32_t flags, int num_threads, int n) {
+  LowLevelAlloc::Arena *arena = LowLevelAlloc::NewArena(flags);
+  std::vector<std::vector<BlockDesc>> held(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i != num_threads; i++) {
+    threads.emplace_back([arena, n, &held, i] {
+      std::vector<BlockDesc> &blocks = held[i];
+      blocks.resize(64, BlockDesc{nullptr, 0, 0});
+      for (int j = 0; j != n; j++) {
+        BlockDesc &d = blocks[rand() % blocks.size()];
+        if (d.ptr != nullptr) {
+          CheckBlockDesc(d);
+          LowLevelAlloc::Free(d.ptr);
+        }
+        d.len = rand() % 1024;
+        d.ptr = reinterpret_cast<char *>(
+            LowLevelAlloc::AllocWithArena(d.len, arena));
+        RandomizeBlockDesc(&d);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  for (const std::vector<BlockDesc> &blocks : held) {
+    for (const BlockDesc &d : blocks) {
+      CheckBlockDesc(d);
+      LowLevelAlloc::Free(d.ptr);
+    }
+  }
+  TEST_ASSERT(LowLevelAlloc::DeleteArena(arena));
+}
+
+// Checks that GetArenaStats() accounts for every byte an arena maps as the
+// arena's blocks are allocated and freed.
+static void StatsTest(int32_t flags) {
+  LowLevelAlloc::Arena *arena = LowLevelAlloc::NewArena(flags);
+  LowLevelAlloc::ArenaStats stats = LowLevelAlloc::GetArenaStats(arena);
+  TEST_ASSERT(stats.bytes_mapped == 0);
+  TEST_ASSERT(stats.bytes_in_use == 0);
+  TEST_ASSERT(stats.free_blocks == 0);
+
+  void *small = LowLevelAlloc::AllocWithArena(100, arena);
+  void *large = LowLevelAlloc::AllocWithArena(100000, arena);
+  stats = LowLevelAlloc::GetArenaStats(arena);
+  TEST_ASSERT(stats.bytes_in_use >= 100100);
+  TEST_ASSERT(stats.bytes_mapped ==
+              stats.bytes_in_use + stats.bytes_cached + stats.bytes_free);
+  TEST_ASSERT(stats.largest_free_block <= stats.bytes_free);
+  TEST_ASSERT((stats.free_blocks == 0) == (stats.bytes_free == 0));
+  if ((flags & (LowLevelAlloc::kTransparentHugePages |
+                LowLevelAlloc::kExplicitHugePages)) != 0) {
+    TEST_ASSERT(stats.bytes_mapped % (2 << 20) == 0);
+  }
+
+  LowLevelAlloc::Free(large);
+  stats = LowLevelAlloc::GetArenaStats(arena);
+  TEST_ASSERT(stats.bytes_in_use < 100000);
+  TEST_ASSERT(stats.largest_free_block >= 100000);
+  LowLevelAlloc::Free(small);
+  stats = LowLevelAlloc::GetArenaStats(arena);
+  TEST_ASSERT(stats.bytes_in_use == 0);
+  TEST_ASSERT(stats.bytes_mapped == stats.bytes_cached + stats.bytes_free);
+  TEST_ASSERT(LowLevelAlloc::DeleteArena(arena));
+}
+
 // LowLevelAlloc is designed to be safe to call before main().
 static struct BeforeMain {
   BeforeMain() {
     Test(false, false, 50000);
     Test(true, false, 50000);
     Test(true, true, 50000);
+    StatsTest(0);
+    StatsTest(LowLevelAlloc::kTransparentHugePages);
+    StatsTest(LowLevelAlloc::kExplicitHugePages);
   }
 } before_main;
 
@@ -151,7 +225,15 @@ static struct BeforeMain {
 }  // namespace absl
 
 int main(int argc, char *argv[]) {
-  // The actual test runs in the global constructor of `before_main`.
+  // The single-threaded tests run in the global constructor of
+  // `before_main`.
+  absl::base_internal::ThreadedTest(0, 8, 20000);
+#ifndef ABSL_LOW_LEVEL_ALLOC_ASYNC_SIGNAL_SAFE_MISSING
+  absl::base_internal::ThreadedTest(
+      absl::base_internal::LowLevelAlloc::kAsyncSignalSafe, 8, 20000);
+#endif
+  absl::base_internal::ThreadedTest(
+      absl::base_internal::LowLevelAlloc::kTransparentHugePages, 8, 20000);
   printf("PASS\n");
   return 0;
 }
@@ -0,0 +1,233 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The queue is that of the MCS lock, in the variant where the holder keeps no
+// node (Scott, "Shared-Memory Synchronization", 4.3.1).  A thread that finds
+// the lock held swaps a node on its stack into tail_, links it behind the
+// previous tail, and polls its state until the previous holder grants it the
+// lock.  It then records its successor in holder_.next, or swings tail_ back
+// to &holder_ if it has none, after which its node is no longer referenced.
+//
+// The cohort mode follows the compact NUMA-aware lock of Dice and Kogan: the
+// releasing thread scans the queue for a waiter on its own node and moves the
+// waiters it skips to a secondary queue, which is spliced back in front of
+// the main queue when no local waiter is found or the local handoff limit is
+// reached.  Only nodes with a successor are moved, so the tail is never
+// touched.
+
+#include "absl/base/internal/queue_spinlock.h"
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+
+#include "absl/base/call_once.h"
+#include "absl/base/internal/cycleclock.h"
+#include "absl/base/internal/scheduling_mode.h"
+#include "absl/base/internal/spinlock.h"
+#include "absl/base/internal/spinlock_wait.h"
+#include "absl/base/internal/sysinfo.h"
+
+namespace absl {
+namespace base_internal {
+
+namespace {
+
+// Values of Node::state.
+enum : uint32_t {
+  kWaiting = 0,   // polling for the lock
+  kSleeping = 1,  // in SpinLockDelay(); the granter must wake it
+  kGranted = 2,   // now holds the lock
+};
+
+// The number of consecutive handoffs within a NUMA node after which waiters
+// from other nodes are served.
+constexpr int kMaxLocalHandoffs = 64;
+
+int SystemNumaNode() {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu, node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+ABSL_CONST_INIT std::atomic<int (*)()> numa_node_function(SystemNumaNode);
+
+int CurrentNumaNode() {
+  return numa_node_function.load(std::memory_order_relaxed)();
+}
+
+// The number of times a waiter polls its node before it goes to sleep.
+int SpinIterations() {
+  ABSL_CONST_INIT static absl::once_flag init_spin_iterations;
+  ABSL_CONST_INIT static int spin_iterations = 0;
+  base_internal::LowLevelCallOnce(&init_spin_iterations, []() {
+    spin_iterations = base_internal::NumCPUs() > 1 ? 1000 : 1;
+  });
+  return spin_iterations;
+}
+
+}  // namespace
+
+void QueueSpinLock::SetNumaNodeFunction(int (*fn)()) {
+  numa_node_function.store(fn == nullptr ? SystemNumaNode : fn,
+                           std::memory_order_relaxed);
+}
+
+void QueueSpinLock::SlowLock() {
+  const int64_t wait_start_time = CycleClock::Now();
+  Node n;
+  if (mode_ == QUEUE_SPINLOCK_NUMA_COHORT) {
+    n.numa_node = CurrentNumaNode();
+  }
+  Node* prev = tail_.exchange(&n, std::memory_order_acq_rel);
+  if (prev != nullptr) {
+    // Either a waiter's node, or &holder_ if the holder had no successor.
+    prev->next.store(&n, std::memory_order_release);
+
+    uint32_t state;
+    int c = SpinIterations();
+    do {
+      state = n.state.load(std::memory_order_acquire);
+    } while (state == kWaiting && --c > 0);
+    if (state == kWaiting &&
+        n.state.compare_exchange_strong(state, kSleeping,
+                                        std::memory_order_acquire,
+                                        std::memory_order_acquire)) {
+      state = kSleeping;
+    }
+    int lock_wait_call_count = 0;
+    while (state == kSleeping) {
+      ABSL_TSAN_MUTEX_PRE_DIVERT(this, 0);
+      base_internal::SpinLockDelay(&n.state, kSleeping, ++lock_wait_call_count,
+                                   SCHEDULE_COOPERATIVE_AND_KERNEL);
+      ABSL_TSAN_MUTEX_POST_DIVERT(this, 0);
+      state = n.state.load(std::memory_order_acquire);
+    }
+  }
+
+  // This thread holds the lock.  Hand n's place in the queue to holder_.
+  Node* succ = n.next.load(std::memory_order_acquire);
+  if (succ == nullptr) {
+    holder_.next.store(nullptr, std::memory_order_relaxed);
+    Node* expected = &n;
+    if (!tail_.compare_exchange_strong(expected, &holder_,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_relaxed)) {
+      // A new waiter has swapped itself into tail_, and will soon link
+      // itself behind n.
+      while ((succ = n.next.load(std::memory_order_acquire)) == nullptr) {
+      }
+    }
+  }
+  if (succ != nullptr) {
+    holder_.next.store(succ, std::memory_order_relaxed);
+  }
+  wait_cycles_ = CycleClock::Now() - wait_start_time;
+}
+
+void QueueSpinLock::SlowUnlock() {
+  const int64_t wait_cycles = wait_cycles_;
+  wait_cycles_ = 0;
+
+  Node* succ = holder_.next.load(std::memory_order_acquire);
+  if (succ == nullptr) {
+    // Without waiters in the main queue, the set-aside ones become the queue,
+    // and are served in order.
+    Node* head = secondary_head_;
+    Node* expected = &holder_;
+    if (tail_.compare_exchange_strong(
+            expected, head == nullptr ? nullptr : secondary_tail_,
+            std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      if (head != nullptr) {
+        secondary_head_ = nullptr;
+        secondary_tail_ = nullptr;
+        local_handoffs_ = 0;
+        Grant(head);
+      }
+      succ = nullptr;
+    } else {
+      // A new waiter has swapped itself into tail_, and will soon link
+      // itself behind holder_.
+      while ((succ = holder_.next.load(std::memory_order_acquire)) ==
+             nullptr) {
+      }
+    }
+  }
+  if (succ != nullptr) {
+    if (mode_ == QUEUE_SPINLOCK_NUMA_COHORT) {
+      succ = CohortSuccessor(succ);
+    }
+    Grant(succ);
+  }
+
+  if (wait_cycles != 0) {
+    ABSL_TSAN_MUTEX_PRE_DIVERT(this, 0);
+    SubmitSpinLockProfileData(this, wait_cycles);
+    ABSL_TSAN_MUTEX_POST_DIVERT(this, 0);
+  }
+}
+
+QueueSpinLock::Node* QueueSpinLock::CohortSuccessor(Node* succ) {
+  if (local_handoffs_ < kMaxLocalHandoffs) {
+    const int numa_node = CurrentNumaNode();
+    Node* last_skipped = nullptr;
+    Node* n = succ;
+    while (n != nullptr && n->numa_node != numa_node) {
+      last_skipped = n;
+      n = n->next.load(std::memory_order_acquire);
+    }
+    if (n != nullptr) {
+      if (last_skipped != nullptr) {
+        last_skipped->next.store(nullptr, std::memory_order_relaxed);
+        if (secondary_head_ == nullptr) {
+          secondary_head_ = succ;
+        } else {
+          secondary_tail_->next.store(succ, std::memory_order_relaxed);
+        }
+        secondary_tail_ = last_skipped;
+      }
+      local_handoffs_++;
+      return n;
+    }
+  }
+  // Serve the set-aside waiters, which have waited longest, then the rest.
+  local_handoffs_ = 0;
+  if (secondary_head_ != nullptr) {
+    secondary_tail_->next.store(succ, std::memory_order_relaxed);
+    succ = secondary_head_;
+    secondary_head_ = nullptr;
+    secondary_tail_ = nullptr;
+  }
+  return succ;
+}
+
+void QueueSpinLock::Grant(Node* n) {
+  // The waiter may return, and its node go away, as soon as it sees kGranted.
+  // A wakeup of an address that has since been reused is harmless, since
+  // SpinLockDelay() callers must tolerate spurious wakeups anyway.
+  std::atomic<uint32_t>* state = &n->state;
+  if (state->exchange(kGranted, std::memory_order_release) == kSleeping) {
+    base_internal::SpinLockWake(state, false);
+  }
+}
+
+}  // namespace base_internal
+}  // namespace absl
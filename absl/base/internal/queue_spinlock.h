@@ -0,0 +1,190 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// QueueSpinLock is a SpinLock for locks that are heavily contended.
+//
+// SpinLock waiters all poll, and compete for, the same lock word, so every
+// release sends that cache line to every waiting CPU.  QueueSpinLock is an
+// MCS lock: waiters form a queue, each polls a flag on its own stack, and the
+// releasing thread hands the lock directly to the next waiter.  A release
+// therefore touches one waiter's cache line, and waiters are served in FIFO
+// order.  In exchange, an uncontended release needs an atomic
+// compare-and-swap, and a lock handed to a waiter that has gone to sleep or
+// been preempted stays unused until that waiter runs again.  QueueSpinLock
+// therefore suits locks contended by up to about as many threads as there are
+// CPUs; SpinLock remains the better choice for lightly contended locks, and
+// for locks contended by many more threads than CPUs.
+//
+// In QUEUE_SPINLOCK_NUMA_COHORT mode, a releasing thread prefers waiters on
+// its own NUMA node, so that the lock and the data it protects stay in that
+// node's caches.  Waiters from other nodes are set aside, and are served first
+// once there are no more local waiters, or after a bounded number of
+// consecutive local handoffs.
+//
+// Contended acquisitions are reported to the profiler registered with
+// RegisterSpinLockProfiler().  Like SpinLock, QueueSpinLock is async signal
+// safe under the same conditions.  It must not be used inside thread
+// schedulers, as waiters always wait cooperatively.
+
+#ifndef ABSL_BASE_INTERNAL_QUEUE_SPINLOCK_H_
+#define ABSL_BASE_INTERNAL_QUEUE_SPINLOCK_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "absl/base/attributes.h"
+#include "absl/base/internal/tsan_mutex_interface.h"
+#include "absl/base/thread_annotations.h"
+
+namespace absl {
+namespace base_internal {
+
+// Selects the order in which a QueueSpinLock serves its waiters.
+enum QueueSpinLockMode {
+  // Strictly in the order in which they started waiting.
+  QUEUE_SPINLOCK_FIFO,
+  // Waiters on the releasing thread's NUMA node first.
+  QUEUE_SPINLOCK_NUMA_COHORT,
+};
+
+class LOCKABLE QueueSpinLock {
+ public:
+  QueueSpinLock() : QueueSpinLock(QUEUE_SPINLOCK_FIFO) {}
+  explicit QueueSpinLock(QueueSpinLockMode mode)
+      : tail_(nullptr),
+        mode_(mode),
+        wait_cycles_(0),
+        secondary_head_(nullptr),
+        secondary_tail_(nullptr),
+        local_handoffs_(0) {
+    ABSL_TSAN_MUTEX_CREATE(this, __tsan_mutex_not_static);
+  }
+
+  ~QueueSpinLock() { ABSL_TSAN_MUTEX_DESTROY(this, __tsan_mutex_not_static); }
+
+  // Acquire this QueueSpinLock.
+  inline void Lock() EXCLUSIVE_LOCK_FUNCTION() {
+    ABSL_TSAN_MUTEX_PRE_LOCK(this, 0);
+    if (!TryLockImpl()) {
+      SlowLock();
+    }
+    ABSL_TSAN_MUTEX_POST_LOCK(this, 0, 0);
+  }
+
+  // Try to acquire this QueueSpinLock without blocking and return true if the
+  // acquisition was successful.  Fails if the lock is held or has waiters.
+  inline bool TryLock() EXCLUSIVE_TRYLOCK_FUNCTION(true) {
+    ABSL_TSAN_MUTEX_PRE_LOCK(this, __tsan_mutex_try_lock);
+    bool res = TryLockImpl();
+    ABSL_TSAN_MUTEX_POST_LOCK(
+        this, __tsan_mutex_try_lock | (res ? 0 : __tsan_mutex_try_lock_failed),
+        0);
+    return res;
+  }
+
+  // Release this QueueSpinLock, which must be held by the calling thread.
+  inline void Unlock() UNLOCK_FUNCTION() {
+    ABSL_TSAN_MUTEX_PRE_UNLOCK(this, 0);
+    Node* expected = &holder_;
+    if (wait_cycles_ != 0 || secondary_head_ != nullptr ||
+        holder_.next.load(std::memory_order_relaxed) != nullptr ||
+        !tail_.compare_exchange_strong(expected, nullptr,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+      SlowUnlock();
+    }
+    ABSL_TSAN_MUTEX_POST_UNLOCK(this, 0);
+  }
+
+  // Determine if the lock is held.  When the lock is held by the invoking
+  // thread, true will always be returned. Intended to be used as
+  // CHECK(lock.IsHeld()).
+  inline bool IsHeld() const {
+    return tail_.load(std::memory_order_relaxed) != nullptr;
+  }
+
+ protected:
+  // Makes QUEUE_SPINLOCK_NUMA_COHORT locks call `fn` instead of asking the
+  // system for the NUMA node of the calling thread.  Use for testing only.
+  static void SetNumaNodeFunction(int (*fn)());
+
+  // Provide access to protected method above.  Use for testing only.
+  friend struct QueueSpinLockTest;
+
+ private:
+  // A place in the queue.  The node of a waiting thread lives on its stack in
+  // SlowLock().  The lock holder needs no node of its own: its successor is
+  // kept in holder_.next, and tail_ points to holder_ while the lock is held
+  // without waiters.
+  struct Node {
+    Node() : state(0), numa_node(0), next(nullptr) {}
+
+    std::atomic<uint32_t> state;  // of a waiter; see queue_spinlock.cc
+    int numa_node;                // of a waiter, in cohort mode
+    std::atomic<Node*> next;
+  };
+
+  void SlowLock() ABSL_ATTRIBUTE_COLD;
+  void SlowUnlock() ABSL_ATTRIBUTE_COLD;
+  Node* CohortSuccessor(Node* succ) EXCLUSIVE_LOCKS_REQUIRED(this);
+  static void Grant(Node* n);
+
+  inline bool TryLockImpl() {
+    Node* expected = nullptr;
+    return tail_.compare_exchange_strong(expected, &holder_,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  // The last waiter, &holder_ if the lock is held without waiters, or nullptr
+  // if it is free.
+  std::atomic<Node*> tail_;
+  Node holder_;
+  const QueueSpinLockMode mode_;
+
+  // The time the holder took to acquire the lock, to be reported on release.
+  int64_t wait_cycles_ GUARDED_BY(this);
+
+  // Waiters set aside in cohort mode, oldest first.
+  Node* secondary_head_ GUARDED_BY(this);
+  Node* secondary_tail_ GUARDED_BY(this);
+  int local_handoffs_ GUARDED_BY(this);
+
+  QueueSpinLock(const QueueSpinLock&) = delete;
+  QueueSpinLock& operator=(const QueueSpinLock&) = delete;
+};
+
+// Corresponding locker object that arranges to acquire a QueueSpinLock for
+// the duration of a C++ scope, as SpinLockHolder does for SpinLock.
+class SCOPED_LOCKABLE QueueSpinLockHolder {
+ public:
+  inline explicit QueueSpinLockHolder(QueueSpinLock* l)
+      EXCLUSIVE_LOCK_FUNCTION(l)
+      : lock_(l) {
+    l->Lock();
+  }
+  inline ~QueueSpinLockHolder() UNLOCK_FUNCTION() { lock_->Unlock(); }
+
+  QueueSpinLockHolder(const QueueSpinLockHolder&) = delete;
+  QueueSpinLockHolder& operator=(const QueueSpinLockHolder&) = delete;
+
+ private:
+  QueueSpinLock* lock_;
+};
+
+}  // namespace base_internal
+}  // namespace absl
+
+#endif  // ABSL_BASE_INTERNAL_QUEUE_SPINLOCK_H_
@@ -0,0 +1,60 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/base/internal/queue_spinlock.h"
+#include "absl/base/internal/spinlock.h"
+
+namespace {
+
+// All threads repeatedly take one lock, and update a few cache lines of data
+// under it.
+template <typename Lock, typename Holder>
+void BM_Contended(benchmark::State& state, Lock* lock) {
+  static int64_t data[4 * 8];
+  for (auto _ : state) {
+    Holder h(lock);
+    for (int i = 0; i < 4 * 8; i += 8) {
+      data[i]++;
+    }
+  }
+  benchmark::DoNotOptimize(data);
+}
+
+void BM_SpinLock(benchmark::State& state) {
+  static absl::base_internal::SpinLock lock(
+      absl::base_internal::kLinkerInitialized);
+  BM_Contended<absl::base_internal::SpinLock,
+               absl::base_internal::SpinLockHolder>(state, &lock);
+}
+BENCHMARK(BM_SpinLock)->ThreadRange(1, 64)->UseRealTime();
+
+void BM_QueueSpinLock(benchmark::State& state) {
+  static absl::base_internal::QueueSpinLock lock;
+  BM_Contended<absl::base_internal::QueueSpinLock,
+               absl::base_internal::QueueSpinLockHolder>(state, &lock);
+}
+BENCHMARK(BM_QueueSpinLock)->ThreadRange(1, 64)->UseRealTime();
+
+void BM_QueueSpinLockNumaCohort(benchmark::State& state) {
+  static absl::base_internal::QueueSpinLock lock(
+      absl::base_internal::QUEUE_SPINLOCK_NUMA_COHORT);
+  BM_Contended<absl::base_internal::QueueSpinLock,
+               absl::base_internal::QueueSpinLockHolder>(state, &lock);
+}
+BENCHMARK(BM_QueueSpinLockNumaCohort)->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,168 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/base/internal/queue_spinlock.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/base/internal/spinlock.h"
+#include "absl/base/internal/sysinfo.h"
+
+namespace absl {
+namespace base_internal {
+
+// This is defined outside of anonymous namespace so that it can be
+// a friend of QueueSpinLock to access protected methods for testing.
+struct QueueSpinLockTest {
+  static void SetNumaNodeFunction(int (*fn)()) {
+    QueueSpinLock::SetNumaNodeFunction(fn);
+  }
+};
+
+namespace {
+
+using ::testing::ElementsAre;
+
+// The NUMA node that threads claim to be on, while FakeNumaNodes is alive.
+thread_local int fake_numa_node = 0;
+
+class FakeNumaNodes {
+ public:
+  FakeNumaNodes() {
+    QueueSpinLockTest::SetNumaNodeFunction([] { return fake_numa_node; });
+  }
+  ~FakeNumaNodes() { QueueSpinLockTest::SetNumaNodeFunction(nullptr); }
+};
+
+TEST(QueueSpinLock, LockAndTryLock) {
+  QueueSpinLock lock;
+  EXPECT_FALSE(lock.IsHeld());
+  lock.Lock();
+  EXPECT_TRUE(lock.IsHeld());
+  EXPECT_FALSE(lock.TryLock());
+  lock.Unlock();
+  EXPECT_FALSE(lock.IsHeld());
+  ASSERT_TRUE(lock.TryLock());
+  EXPECT_TRUE(lock.IsHeld());
+  lock.Unlock();
+  {
+    QueueSpinLockHolder h(&lock);
+    EXPECT_TRUE(lock.IsHeld());
+  }
+  EXPECT_FALSE(lock.IsHeld());
+}
+
+// Threads increment a counter non-atomically under the lock.
+void ThreadedTest(QueueSpinLock* lock, int num_threads) {
+  constexpr int kIters = 20000;
+  int64_t counter = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([lock, &counter, i] {
+      fake_numa_node = i % 3;
+      for (int j = 0; j < kIters; j++) {
+        QueueSpinLockHolder h(lock);
+        int64_t value = counter;
+        if (j % 64 == 0) std::this_thread::yield();
+        counter = value + 1;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  QueueSpinLockHolder h(lock);
+  EXPECT_EQ(counter, int64_t{kIters} * num_threads);
+}
+
+TEST(QueueSpinLockWithThreads, Fifo) {
+  QueueSpinLock lock;
+  ThreadedTest(&lock, 2);
+  ThreadedTest(&lock, NumCPUs() * 2 + 1);
+}
+
+TEST(QueueSpinLockWithThreads, NumaCohort) {
+  FakeNumaNodes fake;
+  QueueSpinLock lock(QUEUE_SPINLOCK_NUMA_COHORT);
+  ThreadedTest(&lock, 2);
+  ThreadedTest(&lock, NumCPUs() * 2 + 1);
+}
+
+// Starts threads on the given NUMA nodes, one at a time, each of which waits
+// for `lock` and appends its index to the returned order.  The caller holds
+// `lock`, and the threads are queued behind it in index order.
+std::vector<int> AcquisitionOrder(QueueSpinLock* lock,
+                                  const std::vector<int>& numa_nodes) {
+  std::vector<int> order;
+  std::vector<std::thread> threads;
+  lock->Lock();
+  for (size_t i = 0; i < numa_nodes.size(); ++i) {
+    const int numa_node = numa_nodes[i];
+    threads.emplace_back([lock, &order, i, numa_node] {
+      fake_numa_node = numa_node;
+      QueueSpinLockHolder h(lock);
+      order.push_back(static_cast<int>(i));
+    });
+    // Give the thread time to join the queue.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  lock->Unlock();
+  for (std::thread& thread : threads) thread.join();
+  return order;
+}
+
+TEST(QueueSpinLockWithThreads, FifoServesWaitersInOrder) {
+  FakeNumaNodes fake;
+  QueueSpinLock lock;
+  EXPECT_THAT(AcquisitionOrder(&lock, {1, 0, 1, 0}), ElementsAre(0, 1, 2, 3));
+}
+
+TEST(QueueSpinLockWithThreads, NumaCohortPrefersLocalWaiters) {
+  FakeNumaNodes fake;
+  QueueSpinLock lock(QUEUE_SPINLOCK_NUMA_COHORT);
+  // This thread, on node 0, hands the lock to 1, which hands it to 3.  The
+  // node 1 waiters are then served in order.
+  EXPECT_THAT(AcquisitionOrder(&lock, {1, 0, 1, 0}), ElementsAre(1, 3, 0, 2));
+  // When there is no local waiter, the waiters that were set aside are served
+  // before newer ones.
+  EXPECT_THAT(AcquisitionOrder(&lock, {1, 0, 2}), ElementsAre(1, 0, 2));
+}
+
+std::atomic<const void*> profiled_lock(nullptr);
+std::atomic<int64_t> profiled_wait_cycles(0);
+
+void Profile(const void* lock, int64_t wait_cycles) {
+  if (lock == profiled_lock.load()) profiled_wait_cycles += wait_cycles;
+}
+
+TEST(QueueSpinLockWithThreads, ReportsContentionToProfiler) {
+  RegisterSpinLockProfiler(Profile);
+  QueueSpinLock lock;
+  profiled_lock.store(&lock);
+  lock.Lock();
+  std::thread waiter([&lock] { QueueSpinLockHolder h(&lock); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(profiled_wait_cycles.load(), 0);
+  lock.Unlock();
+  waiter.join();
+  EXPECT_GT(profiled_wait_cycles.load(), 0);
+  profiled_lock.store(nullptr);
+}
+
+}  // namespace
+}  // namespace base_internal
+}  // namespace absl
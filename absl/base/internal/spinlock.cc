@@ -19,6 +19,7 @@
 #include <limits>
 
 #include "absl/base/attributes.h"
+#include "absl/base/internal/adaptive_spin.h"
 #include "absl/base/internal/atomic_hook.h"
 #include "absl/base/internal/cycleclock.h"
 #include "absl/base/internal/spinlock_wait.h"
@@ -65,6 +66,10 @@ void RegisterSpinLockProfiler(void (*fn)(const void *contendedlock,
   submit_profile_data.Store(fn);
 }
 
+void SubmitSpinLockProfileData(const void *lock, int64_t wait_cycles) {
+  submit_profile_data(lock, wait_cycles);
+}
+
 // Uncommon constructors.
 SpinLock::SpinLock(base_internal::SchedulingMode mode)
     : lockword_(IsCooperative(mode) ? kSpinLockCooperative : 0) {
@@ -95,7 +100,8 @@ void SpinLock::InitLinkerInitializedAndCooperative() {
 }
 
 // Monitor the lock to see if its value changes within some time period
-// (adaptive_spin_count loop iterations).  A timestamp indicating
+// (about adaptive_spin_count loop iterations, tuned per lock by
+// AdaptiveSpinLimit()).  A timestamp indicating
 // when the thread initially started waiting for the lock is passed in via
 // the initial_wait_timestamp value.  The total wait time in cycles for the
 // lock is returned in the wait_cycles parameter.  The last value read
@@ -110,11 +116,16 @@ uint32_t SpinLock::SpinLoop(int64_t initial_wait_timestamp,
     adaptive_spin_count = base_internal::NumCPUs() > 1 ? 1000 : 1;
   });
 
-  int c = adaptive_spin_count;
+  const int limit = AdaptiveSpinLimit(
+      this, adaptive_spin_count,
+      (lockword_.load(std::memory_order_relaxed) & kWaitTimeMask) != 0);
+  int c = limit;
   uint32_t lock_value;
   do {
     lock_value = lockword_.load(std::memory_order_relaxed);
   } while ((lock_value & kSpinLockHeld) != 0 && --c > 0);
+  AdaptiveSpinUpdate(this, adaptive_spin_count, limit - c,
+                     (lock_value & kSpinLockHeld) == 0);
   uint32_t spin_loop_wait_cycles =
       EncodeWaitCycles(initial_wait_timestamp, CycleClock::Now());
   *wait_cycles = spin_loop_wait_cycles;
@@ -201,6 +201,11 @@ class SCOPED_LOCKABLE SpinLockHolder {
 void RegisterSpinLockProfiler(void (*fn)(const void* lock,
                                          int64_t wait_cycles));
 
+// Calls the profiler registered above, if any, for a contended acquisition of
+// `lock` that took `wait_cycles`.  For other spinlock types that report to the
+// same profiler, such as QueueSpinLock.
+void SubmitSpinLockProfileData(const void* lock, int64_t wait_cycles);
+
 //------------------------------------------------------------------------------
 // Public interface ends here.
 //------------------------------------------------------------------------------
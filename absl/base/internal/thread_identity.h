@@ -156,6 +156,22 @@ struct ThreadIdentity {
   std::atomic<bool> is_idle;    // Has thread become idle yet?
 
   ThreadIdentity* next;
+
+  // Used by synchronization_internal::EpochEnter() and EpochExit() to count
+  // the thread's nested read-side sections.
+  int epoch_nesting;
+
+  // The fields from here on are not cleared when a ThreadIdentity is reused
+  // for a new thread, as other threads may read them at any time.
+
+  // Used by synchronization_internal epoch-based reclamation: the epoch in
+  // which the thread entered its outermost read-side section, or 0 if it is
+  // not in one.
+  std::atomic<uint64_t> epoch;
+
+  // The next older ThreadIdentity in the list of all those ever allocated.
+  // See synchronization_internal::AllThreadIdentities().
+  ThreadIdentity* next_allocated;
 };
 
 // Returns the ThreadIdentity object representing the calling thread; guaranteed
@@ -0,0 +1,224 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// CRCs are computed here in the usual bit-reflected representation: bit 31 of
+// a 32-bit value holds the coefficient of x^0 and bit 0 that of x^31.
+//
+// The hardware path is limited by the latency of the `crc32` instruction
+// (3 cycles) rather than its throughput (1 per cycle), so large buffers are
+// split into three equal stripes that are checksummed in parallel. The three
+// partial CRCs are then combined by multiplying the first two by the
+// appropriate power of x, which is done with a carry-less multiply (PCLMULQDQ)
+// followed by a `crc32` to reduce the product.
+
+#include "absl/crc/crc32c.h"
+
+#include "absl/base/internal/endian.h"
+#include "absl/crc/internal/crc32c.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ABSL_CRC_INTERNAL_HAVE_X86_CRC32C 1
+#include <cpuid.h>
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#define ABSL_CRC_INTERNAL_TARGET __attribute__((target("sse4.2,pclmul")))
+#endif
+
+namespace absl {
+namespace crc_internal {
+
+namespace {
+
+// The reflected Castagnoli polynomial.
+constexpr uint32_t kPoly = 0x82F63B78;
+
+// Slicing-by-8 tables: `table[k][b]` is the CRC register after feeding byte
+// `b` followed by `k` zero bytes into a zero register.
+struct Tables {
+  uint32_t table[8][256];
+
+  Tables() {
+    for (uint32_t b = 0; b < 256; ++b) {
+      uint32_t crc = b;
+      for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ (kPoly & (0 - (crc & 1)));
+      table[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+      for (int b = 0; b < 256; ++b) {
+        const uint32_t prev = table[k - 1][b];
+        table[k][b] = (prev >> 8) ^ table[0][prev & 0xff];
+      }
+    }
+  }
+};
+
+const Tables& GetTables() {
+  // Tables is trivially destructible, so this registers no exit-time
+  // destructor.
+  static const Tables tables;
+  return tables;
+}
+
+// Returns the product of `a` and `b` modulo the polynomial.
+uint32_t MultiplyModP(uint32_t a, uint32_t b) {
+  uint32_t product = 0;
+  for (uint32_t m = uint32_t{1} << 31; m != 0; m >>= 1) {
+    if (a & m) {
+      product ^= b;
+      if ((a & (m - 1)) == 0) break;
+    }
+    b = (b >> 1) ^ (kPoly & (0 - (b & 1)));
+  }
+  return product;
+}
+
+// `kPowersOfX[k]` is x^(2^k) modulo the polynomial. These repeat with period
+// 31: x^(2^31) is congruent to x.
+constexpr uint32_t kPowersOfX[31] = {
+    0x40000000, 0x20000000, 0x08000000, 0x00800000, 0x00008000, 0x82f63b78,
+    0x6ea2d55c, 0x18b8ea18, 0x510ac59a, 0xb82be955, 0xb8fdb1e7, 0x88e56f72,
+    0x74c360a4, 0xe4172b16, 0x0d65762a, 0x35d73a62, 0x28461564, 0xbf455269,
+    0xe2ea32dc, 0xfe7740e6, 0xf946610b, 0x3c204f8f, 0x538586e3, 0x59726915,
+    0x734d5309, 0xbc1ac763, 0x7d0722cc, 0xd289cabe, 0xe94ca9bc, 0x05b74f3f,
+    0xa51e1f42,
+};
+
+// Returns x^(8 * n) modulo the polynomial, i.e. the factor by which a CRC
+// register is multiplied when `n` zero bytes are fed into it.
+uint32_t PowerOfXForBytes(size_t n) {
+  uint32_t result = uint32_t{1} << 31;  // x^0
+  int k = 3;                            // 8 * n == n * 2^3
+  for (; n != 0; n >>= 1) {
+    if (n & 1) result = MultiplyModP(kPowersOfX[k], result);
+    if (++k == 31) k = 0;
+  }
+  return result;
+}
+
+#ifdef ABSL_CRC_INTERNAL_HAVE_X86_CRC32C
+
+// Stripe lengths for the three-way parallel loop, with the multipliers that
+// shift a partial CRC across one and two stripes. Buffers are processed with
+// long stripes while at least three remain, then with short ones, so that the
+// cost of combining (a few dozen cycles) stays small relative to the data.
+//
+// For a stripe of `n` bytes the multiplier is x^(8n - 33) modulo the
+// polynomial: the carry-less product of two reflected 32-bit values is
+// shifted down by one bit, and the `crc32` reducing it multiplies by x^32.
+struct Stripe {
+  size_t length;
+  uint32_t shift_one;
+  uint32_t shift_two;
+};
+
+constexpr Stripe kStripes[] = {
+    {4096, 0x82f89c77, 0x54a86326},
+    {256, 0xb9e02b86, 0xdd7e3b0c},
+};
+
+ABSL_CRC_INTERNAL_TARGET inline uint64_t Shift(uint64_t crc,
+                                               uint32_t multiplier) {
+  const __m128i product =
+      _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<int64_t>(crc)),
+                           _mm_cvtsi32_si128(static_cast<int>(multiplier)), 0);
+  return _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(product)));
+}
+
+#endif  // ABSL_CRC_INTERNAL_HAVE_X86_CRC32C
+
+}  // namespace
+
+uint32_t ExtendPortable(uint32_t crc, const char* p, size_t n) {
+  const auto& t = GetTables().table;
+  const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+  for (; n >= 8; n -= 8, u += 8) {
+    const uint32_t lo = little_endian::Load32(u) ^ crc;
+    const uint32_t hi = little_endian::Load32(u + 4);
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^
+          t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+          t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+  }
+  for (; n > 0; --n, ++u) crc = (crc >> 8) ^ t[0][(crc ^ *u) & 0xff];
+  return crc;
+}
+
+#ifdef ABSL_CRC_INTERNAL_HAVE_X86_CRC32C
+
+bool HaveHardwareCrc32c() {
+  static const bool have = [] {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    return (ecx & bit_SSE4_2) != 0 && (ecx & bit_PCLMUL) != 0;
+  }();
+  return have;
+}
+
+ABSL_CRC_INTERNAL_TARGET uint32_t ExtendHardware(uint32_t crc, const char* p,
+                                                 size_t n) {
+  uint64_t c = crc;
+  for (const Stripe& stripe : kStripes) {
+    const size_t len = stripe.length;
+    for (; n >= 3 * len; n -= 3 * len, p += 3 * len) {
+      uint64_t c0 = c;
+      uint64_t c1 = 0;
+      uint64_t c2 = 0;
+      for (size_t i = 0; i < len; i += 8) {
+        c0 = _mm_crc32_u64(c0, little_endian::Load64(p + i));
+        c1 = _mm_crc32_u64(c1, little_endian::Load64(p + len + i));
+        c2 = _mm_crc32_u64(c2, little_endian::Load64(p + 2 * len + i));
+      }
+      c = Shift(c0, stripe.shift_two) ^ Shift(c1, stripe.shift_one) ^ c2;
+    }
+  }
+  for (; n >= 8; n -= 8, p += 8) {
+    c = _mm_crc32_u64(c, little_endian::Load64(p));
+  }
+  uint32_t c32 = static_cast<uint32_t>(c);
+  for (; n > 0; --n, ++p) {
+    c32 = _mm_crc32_u8(c32, static_cast<unsigned char>(*p));
+  }
+  return c32;
+}
+
+#else  // ABSL_CRC_INTERNAL_HAVE_X86_CRC32C
+
+bool HaveHardwareCrc32c() { return false; }
+
+uint32_t ExtendHardware(uint32_t crc, const char* p, size_t n) {
+  return ExtendPortable(crc, p, n);
+}
+
+#endif  // ABSL_CRC_INTERNAL_HAVE_X86_CRC32C
+
+}  // namespace crc_internal
+
+uint32_t ComputeCrc32c(absl::string_view buf) { return Crc32cExtend(0, buf); }
+
+uint32_t Crc32cExtend(uint32_t crc, absl::string_view buf) {
+  crc = ~crc;
+  if (crc_internal::HaveHardwareCrc32c()) {
+    crc = crc_internal::ExtendHardware(crc, buf.data(), buf.size());
+  } else {
+    crc = crc_internal::ExtendPortable(crc, buf.data(), buf.size());
+  }
+  return ~crc;
+}
+
+uint32_t Crc32cConcat(uint32_t crc_a, uint32_t crc_b, size_t len_b) {
+  return crc_internal::MultiplyModP(crc_internal::PowerOfXForBytes(len_b),
+                                    crc_a) ^
+         crc_b;
+}
+
+}  // namespace absl
@@ -0,0 +1,70 @@
+//
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: crc32c.h
+// -----------------------------------------------------------------------------
+//
+// This file defines functions for computing CRC32C checksums: the 32-bit CRC
+// with the Castagnoli polynomial (0x1EDC6F41) used by iSCSI, SCTP, ext4 and
+// many storage formats. The values computed are the standard ones, e.g.
+//
+//   absl::ComputeCrc32c("123456789") == 0xE3069283
+//
+// On x86-64 processors supporting SSE4.2 the checksum is computed with the
+// `crc32` instruction; otherwise a portable table-driven implementation is
+// used. Both produce identical results.
+//
+// Checksums of adjacent buffers can be combined without touching the data
+// again:
+//
+//   uint32_t crc = absl::ComputeCrc32c(header);
+//   crc = absl::Crc32cExtend(crc, payload);    // == ComputeCrc32c(header +
+//                                              //                  payload)
+//
+//   uint32_t a = absl::ComputeCrc32c(first_half);
+//   uint32_t b = absl::ComputeCrc32c(second_half);
+//   uint32_t whole = absl::Crc32cConcat(a, b, second_half.size());
+#ifndef ABSL_CRC_CRC32C_H_
+#define ABSL_CRC_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+namespace absl {
+
+// ComputeCrc32c()
+//
+// Returns the CRC32C checksum of `buf`.
+uint32_t ComputeCrc32c(absl::string_view buf);
+
+// Crc32cExtend()
+//
+// Given `crc`, the CRC32C checksum of some data `A`, returns the checksum of
+// `A` followed by `buf`. `Crc32cExtend(0, buf)` is `ComputeCrc32c(buf)`.
+uint32_t Crc32cExtend(uint32_t crc, absl::string_view buf);
+
+// Crc32cConcat()
+//
+// Given `crc_a` and `crc_b`, the CRC32C checksums of some data `A` and `B`,
+// and `len_b`, the length of `B` in bytes, returns the checksum of `A`
+// followed by `B`. This takes time logarithmic in `len_b`.
+uint32_t Crc32cConcat(uint32_t crc_a, uint32_t crc_b, size_t len_b);
+
+}  // namespace absl
+
+#endif  // ABSL_CRC_CRC32C_H_
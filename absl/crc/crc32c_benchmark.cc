@@ -0,0 +1,66 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/crc/crc32c.h"
+
+#include <cstdint>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "absl/crc/internal/crc32c.h"
+
+namespace {
+
+std::string MakeData(size_t n) {
+  std::string data(n, '\0');
+  uint32_t x = 1;
+  for (char& c : data) {
+    x = x * 1103515245 + 12345;
+    c = static_cast<char>(x >> 24);
+  }
+  return data;
+}
+
+void BM_ComputeCrc32c(benchmark::State& state) {
+  const std::string data = MakeData(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(absl::ComputeCrc32c(data));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          data.size());
+}
+BENCHMARK(BM_ComputeCrc32c)->Range(8, 1 << 20);
+
+void BM_Portable(benchmark::State& state) {
+  const std::string data = MakeData(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        absl::crc_internal::ExtendPortable(0, data.data(), data.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          data.size());
+}
+BENCHMARK(BM_Portable)->Range(8, 1 << 20);
+
+void BM_Crc32cConcat(benchmark::State& state) {
+  const size_t len_b = state.range(0);
+  uint32_t crc = 0;
+  for (auto _ : state) {
+    crc = absl::Crc32cConcat(crc, 0x12345678, len_b);
+    benchmark::DoNotOptimize(crc);
+  }
+}
+BENCHMARK(BM_Crc32cConcat)->Range(8, 1 << 30);
+
+}  // namespace
@@ -0,0 +1,141 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/crc/crc32c.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/crc/internal/crc32c.h"
+
+namespace {
+
+// Bit-at-a-time reference implementation.
+uint32_t ReferenceCrc32c(absl::string_view buf) {
+  uint32_t crc = 0xffffffff;
+  for (unsigned char c : buf) {
+    crc ^= c;
+    for (int i = 0; i < 8; ++i) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78 : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+std::string RandomBytes(size_t n, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::string s(n, '\0');
+  for (char& c : s) c = static_cast<char>(rng());
+  return s;
+}
+
+TEST(Crc32c, KnownValues) {
+  EXPECT_EQ(0u, absl::ComputeCrc32c(""));
+  EXPECT_EQ(0xE3069283u, absl::ComputeCrc32c("123456789"));
+  EXPECT_EQ(0x22620404u,
+            absl::ComputeCrc32c("The quick brown fox jumps over the lazy dog"));
+
+  // Test vectors from RFC 3720, section B.4.
+  EXPECT_EQ(0x8A9136AAu, absl::ComputeCrc32c(std::string(32, '\0')));
+  EXPECT_EQ(0x62A8AB43u, absl::ComputeCrc32c(std::string(32, '\xff')));
+  std::string ascending;
+  std::string descending;
+  for (int i = 0; i < 32; ++i) {
+    ascending.push_back(static_cast<char>(i));
+    descending.push_back(static_cast<char>(31 - i));
+  }
+  EXPECT_EQ(0x46DD794Eu, absl::ComputeCrc32c(ascending));
+  EXPECT_EQ(0x113FDB5Cu, absl::ComputeCrc32c(descending));
+}
+
+TEST(Crc32c, MatchesReference) {
+  // Cover every code path: short tails, one and several short-stripe blocks,
+  // and long-stripe blocks, at many lengths relative to each boundary.
+  const std::string data = RandomBytes(3 * 4096 * 2 + 3 * 256 * 2 + 64, 1);
+  for (size_t len = 0; len <= data.size();
+       len += (len < 1024 ? 1 : 61)) {
+    const absl::string_view s(data.data(), len);
+    const uint32_t expected = ReferenceCrc32c(s);
+    ASSERT_EQ(expected, absl::ComputeCrc32c(s)) << len;
+    ASSERT_EQ(~expected,
+              absl::crc_internal::ExtendPortable(0xffffffff, s.data(), len))
+        << len;
+    if (absl::crc_internal::HaveHardwareCrc32c()) {
+      ASSERT_EQ(~expected,
+                absl::crc_internal::ExtendHardware(0xffffffff, s.data(), len))
+          << len;
+    }
+  }
+}
+
+TEST(Crc32c, Alignment) {
+  const std::string data = RandomBytes(3 * 4096 + 64, 2);
+  for (size_t offset = 0; offset < 16; ++offset) {
+    const absl::string_view s(data.data() + offset, 3 * 4096 + 17);
+    EXPECT_EQ(ReferenceCrc32c(s), absl::ComputeCrc32c(s)) << offset;
+  }
+}
+
+TEST(Crc32c, Extend) {
+  const std::string data = RandomBytes(20000, 3);
+  const uint32_t whole = absl::ComputeCrc32c(data);
+  for (size_t split : {0, 1, 7, 8, 100, 767, 768, 12288, 19999, 20000}) {
+    const absl::string_view s(data);
+    const uint32_t crc = absl::ComputeCrc32c(s.substr(0, split));
+    EXPECT_EQ(whole, absl::Crc32cExtend(crc, s.substr(split))) << split;
+  }
+  EXPECT_EQ(absl::ComputeCrc32c(data), absl::Crc32cExtend(0, data));
+}
+
+TEST(Crc32c, Concat) {
+  const std::string data = RandomBytes(20000, 4);
+  const uint32_t whole = absl::ComputeCrc32c(data);
+  for (size_t split : {0, 1, 7, 8, 100, 767, 768, 12288, 19999, 20000}) {
+    const absl::string_view s(data);
+    const uint32_t a = absl::ComputeCrc32c(s.substr(0, split));
+    const uint32_t b = absl::ComputeCrc32c(s.substr(split));
+    EXPECT_EQ(whole, absl::Crc32cConcat(a, b, data.size() - split)) << split;
+  }
+}
+
+TEST(Crc32c, ConcatLargeLengths) {
+  // Concatenating the checksum of N zero bytes must agree with extending by
+  // them.
+  const std::string zeros(1 << 20, '\0');
+  const uint32_t crc_zeros = absl::ComputeCrc32c(zeros);
+  const uint32_t a = absl::ComputeCrc32c("prefix");
+  uint32_t expected = a;
+  for (int i = 0; i < 4; ++i) expected = absl::Crc32cExtend(expected, zeros);
+  uint32_t concat = a;
+  for (int i = 0; i < 4; ++i) {
+    concat = absl::Crc32cConcat(concat, crc_zeros, zeros.size());
+  }
+  EXPECT_EQ(expected, concat);
+
+  // Concatenation is associative. These lengths run past the point where the
+  // table of powers of x wraps around.
+  const uint32_t x = absl::ComputeCrc32c("x");
+  const uint32_t y = absl::ComputeCrc32c("y");
+  for (size_t len : {size_t{1} << 31, size_t{1} << 40, (size_t{1} << 62) + 5}) {
+    const uint32_t left =
+        absl::Crc32cConcat(absl::Crc32cConcat(x, 0, len), y, 1);
+    const uint32_t right =
+        absl::Crc32cConcat(x, absl::Crc32cConcat(0, y, 1), len + 1);
+    EXPECT_EQ(left, right) << len;
+  }
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// The individual CRC32C implementations behind absl/crc/crc32c.h, exposed so
+// that tests and benchmarks can exercise each of them on any machine.
+//
+// These functions operate on the raw CRC register: the public functions
+// complement the register before and after calling them.
+
+#ifndef ABSL_CRC_INTERNAL_CRC32C_H_
+#define ABSL_CRC_INTERNAL_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace absl {
+namespace crc_internal {
+
+// Updates `crc` with `n` bytes at `p` using slicing-by-8 lookup tables.
+uint32_t ExtendPortable(uint32_t crc, const char* p, size_t n);
+
+// Returns true if ExtendHardware() may be called on this machine.
+bool HaveHardwareCrc32c();
+
+// Updates `crc` with `n` bytes at `p` using the `crc32` instruction. Must only
+// be called if HaveHardwareCrc32c() returns true.
+uint32_t ExtendHardware(uint32_t crc, const char* p, size_t n);
+
+}  // namespace crc_internal
+}  // namespace absl
+
+#endif  // ABSL_CRC_INTERNAL_CRC32C_H_
@@ -0,0 +1,146 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/memory/arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+#include "absl/base/internal/throw_delegate.h"
+
+namespace absl {
+
+constexpr size_t Arena::kDefaultAlignment;
+
+// A block obtained from the heap, whose memory follows the header.
+struct Arena::Block {
+  Block* next;
+  size_t size;
+
+  char* begin() { return reinterpret_cast<char*>(this + 1); }
+  char* end() { return begin() + size; }
+};
+
+// An object whose destructor runs when the arena is reset or destroyed.
+struct Arena::Cleanup {
+  void* object;
+  void (*destroy)(void*);
+  Cleanup* next;
+};
+
+Arena::Arena(void* initial_block, size_t size, const Options& options)
+    : ptr_(static_cast<char*>(initial_block)),
+      limit_(static_cast<char*>(initial_block) + size),
+      initial_block_(static_cast<char*>(initial_block)),
+      initial_block_size_(size),
+      options_(options),
+      next_block_size_(options.initial_block_size),
+      space_allocated_(0),
+      blocks_(nullptr),
+      spare_(nullptr),
+      cleanups_(nullptr) {}
+
+Arena::~Arena() {
+  RunCleanups();
+  for (Block* b = blocks_; b != nullptr;) {
+    Block* next = b->next;
+    ::operator delete(b);
+    b = next;
+  }
+  ::operator delete(spare_);
+}
+
+void Arena::Reset() {
+  RunCleanups();
+  // Keep the largest block, so that an arena reused for similar workloads
+  // soon stops allocating from the heap.
+  Block* keep = spare_;
+  for (Block* b = blocks_; b != nullptr;) {
+    Block* next = b->next;
+    if (keep == nullptr || b->size > keep->size) std::swap(b, keep);
+    ::operator delete(b);
+    b = next;
+  }
+  blocks_ = nullptr;
+  spare_ = keep;
+  space_allocated_ = keep != nullptr ? keep->size : 0;
+  ptr_ = initial_block_;
+  limit_ = initial_block_ + initial_block_size_;
+  next_block_size_ = options_.initial_block_size;
+}
+
+Arena::Block* Arena::NewBlock(size_t size) {
+  if (size > std::numeric_limits<size_t>::max() - sizeof(Block)) {
+    base_internal::ThrowStdBadAlloc();
+  }
+  Block* b = static_cast<Block*>(::operator new(sizeof(Block) + size));
+  b->size = size;
+  space_allocated_ += size;
+  return b;
+}
+
+void* Arena::AllocateSlow(size_t bytes, size_t alignment) {
+  if (bytes > std::numeric_limits<size_t>::max() - alignment) {
+    base_internal::ThrowStdBadAlloc();
+  }
+  // Enough for the allocation however its block's memory is aligned.
+  const size_t needed = bytes + alignment - 1;
+
+  Block* b;
+  if (needed > options_.max_block_size / 4) {
+    // Give a large allocation a block of its own, so that what is left of the
+    // current block still serves the small allocations that follow.
+    b = NewBlock(needed);
+    b->next = blocks_;
+    blocks_ = b;
+    const uintptr_t p = (reinterpret_cast<uintptr_t>(b->begin()) +
+                         alignment - 1) & ~(alignment - 1);
+    return reinterpret_cast<char*>(p);
+  }
+  if (spare_ != nullptr && spare_->size >= needed) {
+    b = spare_;
+    spare_ = nullptr;
+  } else {
+    b = NewBlock(std::max(next_block_size_, needed));
+    next_block_size_ = std::min(2 * next_block_size_, options_.max_block_size);
+  }
+  b->next = blocks_;
+  blocks_ = b;
+  ptr_ = b->begin();
+  limit_ = b->end();
+  return Allocate(bytes, alignment);
+}
+
+void Arena::AddCleanup(void* object, void (*destroy)(void*)) {
+  Cleanup* c = static_cast<Cleanup*>(Allocate(sizeof(Cleanup),
+                                              alignof(Cleanup)));
+  c->object = object;
+  c->destroy = destroy;
+  c->next = cleanups_;
+  cleanups_ = c;
+}
+
+void Arena::RunCleanups() {
+  // A destructor may create more objects in the arena, and so add cleanups.
+  while (cleanups_ != nullptr) {
+    Cleanup* c = cleanups_;
+    cleanups_ = c->next;
+    c->destroy(c->object);
+  }
+}
+
+}  // namespace absl
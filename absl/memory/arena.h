@@ -0,0 +1,240 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: arena.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::Arena`, a monotonic allocator that hands out
+// memory by bumping a pointer through large blocks and frees it all at once,
+// and `absl::ArenaAllocator<T>`, which lets standard and Abseil containers
+// allocate from an `Arena`:
+//
+//   void HandleRequest(const Request& request) {
+//     absl::InlinedArena<4096> arena;
+//     absl::ArenaAllocator<Field> alloc(&arena);
+//     absl::InlinedVector<Field, 8, absl::ArenaAllocator<Field>> fields(alloc);
+//     ...
+//   }  // Everything allocated for the request is released here.
+//
+// Allocating from an `Arena` is a pointer increment in the common case, and
+// freeing individual allocations does nothing: their memory is reclaimed only
+// when the arena is reset or destroyed, in time proportional to the number of
+// blocks it obtained from the heap rather than the number of allocations.
+//
+// An `Arena` is not thread-safe.
+
+#ifndef ABSL_MEMORY_ARENA_H_
+#define ABSL_MEMORY_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/internal/throw_delegate.h"
+#include "absl/base/optimization.h"
+
+namespace absl {
+
+// Arena
+//
+// Allocates memory first from an optional caller-provided initial block, then
+// from blocks obtained from the heap with `::operator new`. The first heap
+// block has `Options::initial_block_size` bytes, and each later one is twice
+// as large as the one before, up to `Options::max_block_size`; setting both
+// to the same value makes every block the same size. An allocation too large
+// to fit comfortably in a block gets a heap block of its own.
+class Arena {
+ public:
+  struct Options {
+    Options() : initial_block_size(1024), max_block_size(64 * 1024) {}
+
+    size_t initial_block_size;
+    size_t max_block_size;
+  };
+
+  // The alignment of `Allocate()` when none is given.
+  static constexpr size_t kDefaultAlignment = alignof(std::max_align_t);
+
+  Arena() : Arena(Options()) {}
+  explicit Arena(const Options& options) : Arena(nullptr, 0, options) {}
+
+  // Constructs an arena that allocates from the `size` bytes at
+  // `initial_block` before using the heap. The initial block must outlive the
+  // arena, which never frees it.
+  Arena(void* initial_block, size_t size, const Options& options = Options());
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Runs the destructors of the objects made by `Create()`, in the reverse
+  // order of their creation, and frees the heap blocks.
+  ~Arena();
+
+  // Arena::Allocate()
+  //
+  // Returns `bytes` bytes of uninitialized memory aligned to `alignment`,
+  // which must be a power of two. The memory remains valid until the arena is
+  // reset or destroyed. `Allocate(0)` may return a null pointer.
+  void* Allocate(size_t bytes, size_t alignment = kDefaultAlignment) {
+    const uintptr_t p = (reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) &
+                        ~(alignment - 1);
+    const uintptr_t limit = reinterpret_cast<uintptr_t>(limit_);
+    if (ABSL_PREDICT_TRUE(p <= limit && bytes <= limit - p)) {
+      ptr_ = reinterpret_cast<char*>(p) + bytes;
+      return reinterpret_cast<char*>(p);
+    }
+    return AllocateSlow(bytes, alignment);
+  }
+
+  // Arena::Create()
+  //
+  // Constructs a `T` from `args` in memory allocated from the arena. Unless
+  // `T` is trivially destructible, its destructor runs when the arena is reset
+  // or destroyed.
+  template <typename T, typename... Args>
+  T* Create(Args&&... args) {
+    T* object = new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value) {
+      AddCleanup(object, &Destroy<T>);
+    }
+    return object;
+  }
+
+  // Arena::Reset()
+  //
+  // Runs the destructors of the objects made by `Create()`, and releases all
+  // the memory allocated from the arena for reuse. The arena keeps its largest
+  // heap block, which it uses once the initial block, if any, is full.
+  void Reset();
+
+  // Arena::SpaceAllocated()
+  //
+  // Returns the number of bytes in the heap blocks that the arena holds,
+  // excluding the initial block.
+  size_t SpaceAllocated() const { return space_allocated_; }
+
+ private:
+  struct Block;
+  struct Cleanup;
+
+  template <typename T>
+  static void Destroy(void* object) {
+    static_cast<T*>(object)->~T();
+  }
+
+  void* AllocateSlow(size_t bytes, size_t alignment);
+  void AddCleanup(void* object, void (*destroy)(void*));
+  void RunCleanups();
+  Block* NewBlock(size_t size);
+
+  // The unused part of the current block.
+  char* ptr_;
+  char* limit_;
+  char* const initial_block_;
+  const size_t initial_block_size_;
+  const Options options_;
+  // The size of the next heap block that is not for a single allocation.
+  size_t next_block_size_;
+  size_t space_allocated_;
+  // Heap blocks allocated from since the last Reset(), newest first.
+  Block* blocks_;
+  // A heap block kept by Reset(), not yet used again.
+  Block* spare_;
+  // Objects to destroy, most recently created first.
+  Cleanup* cleanups_;
+};
+
+// InlinedArena
+//
+// An `Arena` whose initial block of `N` bytes is part of the object, so that
+// an arena on the stack serves small workloads without touching the heap.
+template <size_t N>
+class InlinedArena : public Arena {
+ public:
+  explicit InlinedArena(const Options& options = Options())
+      : Arena(storage_, N, options) {}
+
+ private:
+  alignas(Arena::kDefaultAlignment) char storage_[N];
+};
+
+// ArenaAllocator
+//
+// A standard allocator that allocates from an `Arena`, for use with standard
+// containers, `absl::InlinedVector` and `absl::FixedArray`. Its
+// `deallocate()` does nothing, so the memory of a container that grows is
+// released only with the arena, and a container must not be used after its
+// arena is reset or destroyed. Copies of an allocator, including rebound
+// ones, compare equal and allocate from the same arena.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+
+  template <typename U>
+  struct rebind {
+    using other = ArenaAllocator<U>;
+  };
+
+  // Containers move and swap their memory, and so must keep its arena.
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept  // NOLINT
+      : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if (ABSL_PREDICT_FALSE(n > max_size())) {
+      base_internal::ThrowStdBadAlloc();
+    }
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, size_t) noexcept {}
+
+  size_t max_size() const noexcept {
+    return std::numeric_limits<size_t>::max() / sizeof(T);
+  }
+
+  Arena* arena() const { return arena_; }
+
+  friend bool operator==(const ArenaAllocator& a, const ArenaAllocator& b) {
+    return a.arena_ == b.arena_;
+  }
+  friend bool operator!=(const ArenaAllocator& a, const ArenaAllocator& b) {
+    return a.arena_ != b.arena_;
+  }
+
+ private:
+  Arena* arena_;
+};
+
+}  // namespace absl
+
+#endif  // ABSL_MEMORY_ARENA_H_
@@ -0,0 +1,65 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/memory/arena.h"
+
+namespace {
+
+// Builds a request-like structure of state.range(0) fields, each holding a
+// few values that spill out of its inline storage, and then frees it.
+template <typename Alloc>
+void BuildRequest(int num_fields, const Alloc& alloc) {
+  using Field = absl::InlinedVector<int, 2, Alloc>;
+  using FieldAlloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Field>;
+  std::vector<Field, FieldAlloc> fields{FieldAlloc(alloc)};
+  for (int i = 0; i < num_fields; i++) {
+    fields.emplace_back(alloc);
+    for (int j = 0; j < 6; j++) fields.back().push_back(j);
+  }
+  benchmark::DoNotOptimize(fields.data());
+}
+
+void BM_RequestWithHeap(benchmark::State& state) {
+  for (auto _ : state) {
+    BuildRequest(state.range(0), std::allocator<int>());
+  }
+}
+BENCHMARK(BM_RequestWithHeap)->Range(8, 1024);
+
+void BM_RequestWithArena(benchmark::State& state) {
+  absl::InlinedArena<4096> arena;
+  for (auto _ : state) {
+    BuildRequest(state.range(0), absl::ArenaAllocator<int>(&arena));
+    arena.Reset();
+  }
+}
+BENCHMARK(BM_RequestWithArena)->Range(8, 1024);
+
+void BM_Allocate(benchmark::State& state) {
+  absl::Arena arena;
+  const size_t size = state.range(0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(arena.Allocate(size));
+    if (arena.SpaceAllocated() > (1 << 20)) arena.Reset();
+  }
+}
+BENCHMARK(BM_Allocate)->Arg(8)->Arg(64)->Arg(512);
+
+}  // namespace
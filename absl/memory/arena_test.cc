@@ -0,0 +1,221 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/memory/arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/fixed_array.h"
+#include "absl/container/inlined_vector.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(ArenaTest, AllocationsAreAlignedAndDisjoint) {
+  absl::Arena arena;
+  std::vector<std::pair<char*, size_t>> blocks;
+  for (size_t alignment = 1; alignment <= 256; alignment *= 2) {
+    for (size_t bytes : {1, 7, 64, 300, 5000, 100000}) {
+      char* p = static_cast<char*>(arena.Allocate(bytes, alignment));
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % alignment, 0);
+      memset(p, static_cast<int>(blocks.size()), bytes);
+      blocks.emplace_back(p, bytes);
+    }
+  }
+  for (size_t i = 0; i < blocks.size(); i++) {
+    for (size_t j = 0; j < blocks[i].second; j++) {
+      ASSERT_EQ(blocks[i].first[j], static_cast<char>(i));
+    }
+  }
+}
+
+TEST(ArenaTest, DefaultAlignment) {
+  absl::Arena arena;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.Allocate(i + 1)) %
+                  absl::Arena::kDefaultAlignment,
+              0);
+  }
+}
+
+TEST(ArenaTest, InitialBlockIsUsedFirst) {
+  alignas(absl::Arena::kDefaultAlignment) char buffer[1024];
+  absl::Arena arena(buffer, sizeof(buffer));
+  char* p = static_cast<char*>(arena.Allocate(1000, 1));
+  EXPECT_TRUE(p >= buffer && p + 1000 <= buffer + sizeof(buffer));
+  EXPECT_EQ(arena.SpaceAllocated(), 0);
+  arena.Allocate(100);
+  EXPECT_GT(arena.SpaceAllocated(), 0);
+
+  absl::InlinedArena<4096> inlined;
+  inlined.Allocate(4000, 1);
+  EXPECT_EQ(inlined.SpaceAllocated(), 0);
+}
+
+TEST(ArenaTest, BlocksGrowGeometrically) {
+  absl::Arena::Options options;
+  options.initial_block_size = 1024;
+  options.max_block_size = 4096;
+  absl::Arena arena(options);
+  std::vector<size_t> sizes;
+  for (int i = 0; i < 200; i++) {
+    arena.Allocate(64);
+    if (sizes.empty() || sizes.back() != arena.SpaceAllocated()) {
+      sizes.push_back(arena.SpaceAllocated());
+    }
+  }
+  ASSERT_GE(sizes.size(), 4);
+  EXPECT_EQ(sizes[0], 1024);
+  EXPECT_EQ(sizes[1], 1024 + 2048);
+  EXPECT_EQ(sizes[2], 1024 + 2048 + 4096);
+  EXPECT_EQ(sizes[3], 1024 + 2048 + 4096 + 4096);
+}
+
+TEST(ArenaTest, FixedBlockSize) {
+  absl::Arena::Options options;
+  options.initial_block_size = 2048;
+  options.max_block_size = 2048;
+  absl::Arena arena(options);
+  for (int i = 0; i < 200; i++) {
+    arena.Allocate(64);
+    EXPECT_EQ(arena.SpaceAllocated() % 2048, 0);
+  }
+}
+
+// A large allocation gets its own block, and does not waste what is left of
+// the current one.
+TEST(ArenaTest, LargeAllocation) {
+  absl::Arena::Options options;
+  options.initial_block_size = 4096;
+  options.max_block_size = 4096;
+  absl::Arena arena(options);
+  arena.Allocate(64);
+  EXPECT_EQ(arena.SpaceAllocated(), 4096);
+  arena.Allocate(100000);
+  const size_t with_large = arena.SpaceAllocated();
+  EXPECT_GE(with_large, 4096 + 100000);
+  arena.Allocate(64);
+  EXPECT_EQ(arena.SpaceAllocated(), with_large);
+}
+
+TEST(ArenaTest, ResetKeepsLargestBlock) {
+  absl::Arena::Options options;
+  options.initial_block_size = 1024;
+  options.max_block_size = 8192;
+  absl::Arena arena(options);
+  for (int i = 0; i < 200; i++) arena.Allocate(64);
+  arena.Reset();
+  EXPECT_EQ(arena.SpaceAllocated(), 8192);
+  // The kept block serves the first allocations after the reset.
+  arena.Allocate(64);
+  EXPECT_EQ(arena.SpaceAllocated(), 8192);
+}
+
+TEST(ArenaTest, ResetReusesInitialBlock) {
+  absl::InlinedArena<1024> arena;
+  void* first = arena.Allocate(64);
+  arena.Allocate(4096);
+  arena.Reset();
+  EXPECT_EQ(arena.Allocate(64), first);
+}
+
+class Recorder {
+ public:
+  Recorder(std::vector<int>* destroyed, int id)
+      : destroyed_(destroyed), id_(id) {}
+  ~Recorder() { destroyed_->push_back(id_); }
+
+ private:
+  std::vector<int>* destroyed_;
+  int id_;
+};
+
+TEST(ArenaTest, CreateRunsDestructorsInReverseOrder) {
+  std::vector<int> destroyed;
+  {
+    absl::Arena arena;
+    arena.Create<Recorder>(&destroyed, 1);
+    arena.Create<Recorder>(&destroyed, 2);
+    int* i = arena.Create<int>(42);
+    EXPECT_EQ(*i, 42);
+    arena.Reset();
+    EXPECT_THAT(destroyed, ElementsAre(2, 1));
+    arena.Create<Recorder>(&destroyed, 3);
+    arena.Create<Recorder>(&destroyed, 4);
+  }
+  EXPECT_THAT(destroyed, ElementsAre(2, 1, 4, 3));
+}
+
+TEST(ArenaAllocatorTest, StandardContainers) {
+  absl::Arena arena;
+  {
+    std::vector<int, absl::ArenaAllocator<int>> v{
+        absl::ArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 1000; i++) v.push_back(i);
+    EXPECT_EQ(v[999], 999);
+
+    using Map = std::map<int, int, std::less<int>,
+                         absl::ArenaAllocator<std::pair<const int, int>>>;
+    Map m{absl::ArenaAllocator<std::pair<const int, int>>(&arena)};
+    for (int i = 0; i < 100; i++) m[i] = i * i;
+    EXPECT_EQ(m[9], 81);
+
+    using String =
+        std::basic_string<char, std::char_traits<char>,
+                          absl::ArenaAllocator<char>>;
+    String s{absl::ArenaAllocator<char>(&arena)};
+    s.assign(100, 'x');
+    EXPECT_EQ(s.size(), 100);
+  }
+  EXPECT_GT(arena.SpaceAllocated(), 1000 * sizeof(int));
+}
+
+TEST(ArenaAllocatorTest, AbseilContainers) {
+  absl::InlinedArena<256> arena;
+  absl::ArenaAllocator<int> alloc(&arena);
+
+  absl::InlinedVector<int, 4, absl::ArenaAllocator<int>> v(alloc);
+  for (int i = 0; i < 100; i++) v.push_back(i);
+  EXPECT_EQ(v.size(), 100);
+  EXPECT_EQ(v[99], 99);
+  EXPECT_EQ(v.get_allocator(), alloc);
+
+  absl::FixedArray<int, 4, absl::ArenaAllocator<int>> a(1000, 7, alloc);
+  EXPECT_EQ(a[999], 7);
+  EXPECT_GE(arena.SpaceAllocated(), 1000 * sizeof(int));
+}
+
+TEST(ArenaAllocatorTest, RebindAndEquality) {
+  absl::Arena arena1;
+  absl::Arena arena2;
+  absl::ArenaAllocator<int> a(&arena1);
+  absl::ArenaAllocator<double> b(a);
+  EXPECT_EQ(b.arena(), &arena1);
+  EXPECT_TRUE(absl::ArenaAllocator<int>(b) == a);
+  EXPECT_TRUE(absl::ArenaAllocator<int>(&arena2) != a);
+  double* d = b.allocate(3);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(d) % alignof(double), 0);
+  b.deallocate(d, 3);
+}
+
+}  // namespace
@@ -0,0 +1,258 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The fingerprint is computed in three regimes, chosen by input length:
+//
+//   * Up to 16 bytes, the input is loaded directly (with overlapping loads)
+//     into two 64-bit words.
+//   * Up to kLongThreshold bytes, 32-byte chunks are folded into two 64-bit
+//     chains with 64x64->128 bit multiplies, and the final 16 bytes supply
+//     the two words.
+//   * Longer inputs first run through eight 64-bit accumulator lanes, 64
+//     bytes per step, which are folded into the two chains before the tail
+//     is handled as above. The lane arithmetic only uses 32x32->64 bit
+//     multiplies and 64-bit adds, so it has an exact SIMD implementation.
+//
+// The two words are then mixed with the input length into the result. All
+// loads are little-endian so that the output does not depend on the host.
+//
+// DO NOT change any constant or step below: the output is frozen.
+
+#include "absl/strings/fingerprint.h"
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "absl/base/internal/endian.h"
+
+namespace absl {
+
+namespace {
+
+constexpr uint64_t kMul0 = uint64_t{0xa0761d6478bd642f};
+constexpr uint64_t kMul1 = uint64_t{0xe7037ed1a0b428db};
+constexpr uint64_t kMul2 = uint64_t{0x8ebc6af09c88c6e3};
+constexpr uint64_t kMul3 = uint64_t{0x589965cc75374cc3};
+
+// Inputs longer than this take the striped accumulator path.
+constexpr size_t kLongThreshold = 256;
+
+// The striped path consumes 64-byte stripes; every kStripesPerBlock stripes
+// the accumulators are scrambled.
+constexpr size_t kStripeSize = 64;
+constexpr size_t kStripesPerBlock = 16;
+constexpr uint64_t kScrambleMul = 0x9E3779B1;  // 32 bits, see Scramble().
+
+// Per-lane keys. Stripe `i` of a block is keyed with `kSecret[i, i + 8)`, and
+// the scramble step with `kSecret[16, 24)`.
+alignas(16) constexpr uint64_t kSecret[24] = {
+    uint64_t{0x2cb0f69f4abea221}, uint64_t{0x9417034723148989},
+    uint64_t{0xdd555950609dfe03}, uint64_t{0xdbafb150deb12800},
+    uint64_t{0x7e789b2e6c442cb6}, uint64_t{0xf41e5636c7e4f8c4},
+    uint64_t{0x0959d150f8fba7e4}, uint64_t{0xa97316f13cdb9eea},
+    uint64_t{0x74cd8258f9520068}, uint64_t{0x55c74a62e116868b},
+    uint64_t{0xd2f4c799a2023cbd}, uint64_t{0xdf98cb79a37b51b9},
+    uint64_t{0x396f5885524f3905}, uint64_t{0xaf1d56386ca3b276},
+    uint64_t{0xa9ffbe6b5104e85a}, uint64_t{0x6bd0c51b9fd533b3},
+    uint64_t{0x980ce91c50ab4b56}, uint64_t{0x28ac395780fe62c5},
+    uint64_t{0x768912e3a6bcedc7}, uint64_t{0x50b3e8c9332c7c88},
+    uint64_t{0xce3bbfe520bd47da}, uint64_t{0xcba6c8e8e0bb7c4f},
+    uint64_t{0xbf194db8434a346d}, uint64_t{0x7d8f2a7b60416d7f},
+};
+
+inline uint64_t Load64(const char* p) { return little_endian::Load64(p); }
+inline uint64_t Load32(const char* p) { return little_endian::Load32(p); }
+
+// Multiplies `a` and `b` into 128 bits and folds the halves together.
+inline uint64_t MulFold(uint64_t a, uint64_t b) {
+  const uint128 product = uint128(a) * b;
+  return Uint128Low64(product) ^ Uint128High64(product);
+}
+
+// Portable implementation of the striped accumulator path.
+struct ScalarLanes {
+  uint64_t acc[8];
+
+  explicit ScalarLanes(const uint64_t* init) {
+    memcpy(acc, init, sizeof(acc));
+  }
+
+  void Accumulate(const char* p, const uint64_t* key) {
+    uint64_t data[8];
+    for (int i = 0; i < 8; ++i) data[i] = Load64(p + 8 * i);
+    for (int i = 0; i < 8; ++i) {
+      const uint64_t keyed = data[i] ^ key[i];
+      acc[i] += (keyed & 0xffffffff) * (keyed >> 32) + data[i ^ 1];
+    }
+  }
+
+  void Scramble(const uint64_t* key) {
+    for (int i = 0; i < 8; ++i) {
+      acc[i] = ((acc[i] ^ (acc[i] >> 47)) ^ key[i]) * kScrambleMul;
+    }
+  }
+
+  void Store(uint64_t* out) const { memcpy(out, acc, sizeof(acc)); }
+};
+
+#ifdef __SSE2__
+
+// SSE2 implementation of the striped accumulator path, computing exactly what
+// ScalarLanes does two lanes per register. `_mm_mul_epu32` multiplies the low
+// 32 bits of each 64-bit lane, which gives both the lo*hi product of
+// Accumulate() and, applied to each half, the multiply by a 32-bit constant
+// of Scramble().
+struct Sse2Lanes {
+  __m128i acc[4];
+
+  explicit Sse2Lanes(const uint64_t* init) {
+    for (int i = 0; i < 4; ++i) {
+      acc[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(init + 2 * i));
+    }
+  }
+
+  void Accumulate(const char* p, const uint64_t* key) {
+    for (int i = 0; i < 4; ++i) {
+      const __m128i data =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+      const __m128i k =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 2 * i));
+      const __m128i keyed = _mm_xor_si128(data, k);
+      const __m128i product = _mm_mul_epu32(
+          keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(2, 3, 0, 1)));
+      const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+      acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+    }
+  }
+
+  void Scramble(const uint64_t* key) {
+    const __m128i mul = _mm_set1_epi32(static_cast<int>(kScrambleMul));
+    for (int i = 0; i < 4; ++i) {
+      const __m128i k =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 2 * i));
+      __m128i a = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+      a = _mm_xor_si128(a, k);
+      const __m128i lo = _mm_mul_epu32(a, mul);
+      const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), mul);
+      acc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+    }
+  }
+
+  void Store(uint64_t* out) const {
+    for (int i = 0; i < 4; ++i) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), acc[i]);
+    }
+  }
+};
+
+using Lanes = Sse2Lanes;
+
+#else  // __SSE2__
+
+using Lanes = ScalarLanes;
+
+#endif  // __SSE2__
+
+// Runs `stripes` 64-byte stripes starting at `p` through the accumulator
+// lanes and folds the result into `s0` and `s1`.
+void HashStripes(const char* p, size_t stripes, uint64_t* s0, uint64_t* s1) {
+  Lanes lanes(kSecret + 4);
+  for (size_t i = 0; i < stripes; ++i) {
+    const size_t in_block = i % kStripesPerBlock;
+    lanes.Accumulate(p + i * kStripeSize, kSecret + in_block);
+    if (in_block == kStripesPerBlock - 1) {
+      lanes.Scramble(kSecret + kStripesPerBlock);
+    }
+  }
+  uint64_t acc[8];
+  lanes.Store(acc);
+  *s0 = MulFold(acc[0] ^ *s0, acc[1] ^ kMul1) ^
+        MulFold(acc[2] ^ kMul2, acc[3] ^ kMul3);
+  *s1 = MulFold(acc[4] ^ *s1, acc[5] ^ kMul1) ^
+        MulFold(acc[6] ^ kMul2, acc[7] ^ kMul3);
+}
+
+// Reduces `s` to two 64-bit words, from which the 64- and 128-bit results are
+// derived.
+struct Words {
+  uint64_t a;
+  uint64_t b;
+};
+
+Words Reduce(absl::string_view s) {
+  const char* p = s.data();
+  const size_t len = s.size();
+  uint64_t s0 = kMul0;
+  uint64_t s1 = kMul1;
+  uint64_t a;
+  uint64_t b;
+  if (len <= 16) {
+    if (len >= 4) {
+      // Two overlapping pairs of 32-bit loads cover every byte.
+      const size_t mid = (len >> 3) << 2;
+      a = (Load32(p) << 32) | Load32(p + mid);
+      b = (Load32(p + len - 4) << 32) | Load32(p + len - 4 - mid);
+    } else if (len > 0) {
+      a = (uint64_t{static_cast<unsigned char>(p[0])} << 16) |
+          (uint64_t{static_cast<unsigned char>(p[len >> 1])} << 8) |
+          static_cast<unsigned char>(p[len - 1]);
+      b = 0;
+    } else {
+      a = 0;
+      b = 0;
+    }
+  } else {
+    const char* end = p + len;
+    if (len > kLongThreshold) {
+      // Leave at least one byte for the tail below.
+      const size_t stripes = (len - 1) / kStripeSize;
+      HashStripes(p, stripes, &s0, &s1);
+      p += stripes * kStripeSize;
+    }
+    while (end - p > 32) {
+      s0 = MulFold(Load64(p) ^ kMul1, Load64(p + 8) ^ s0);
+      s1 = MulFold(Load64(p + 16) ^ kMul2, Load64(p + 24) ^ s1);
+      p += 32;
+    }
+    if (end - p > 16) {
+      s0 = MulFold(Load64(p) ^ kMul1, Load64(p + 8) ^ s0);
+    }
+    a = Load64(end - 16);
+    b = Load64(end - 8);
+  }
+  return Words{a ^ s0, b ^ s1};
+}
+
+}  // namespace
+
+uint64_t Fingerprint64(absl::string_view s) {
+  const Words w = Reduce(s);
+  const uint128 m = uint128(w.a ^ kMul1) * (w.b ^ kMul2);
+  return MulFold(Uint128Low64(m) ^ kMul0 ^ s.size(),
+                 Uint128High64(m) ^ kMul3);
+}
+
+uint128 Fingerprint128(absl::string_view s) {
+  const Words w = Reduce(s);
+  const uint64_t x = MulFold(w.a ^ kMul1, w.b ^ kMul2 ^ s.size());
+  const uint64_t y = MulFold(w.b ^ kMul3, w.a ^ kMul0 ^ s.size());
+  return MakeUint128(MulFold(x ^ kMul0, y ^ kMul1),
+                     MulFold(y ^ kMul2, x ^ kMul3));
+}
+
+}  // namespace absl
@@ -0,0 +1,62 @@
+//
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: fingerprint.h
+// -----------------------------------------------------------------------------
+//
+// This file defines `absl::Fingerprint64()` and `absl::Fingerprint128()`,
+// fast non-cryptographic hashes of byte strings whose output is stable: the
+// value computed for a given input is the same on every platform, in every
+// build mode, and in every future release. Fingerprints are therefore suitable
+// for persisting to disk, sending across the network, or choosing a shard.
+//
+// Example:
+//
+//   uint64_t shard = absl::Fingerprint64(key) % num_shards;
+//
+// Fingerprints are not suitable where an adversary may choose the inputs: they
+// are not cryptographic and make no guarantees against deliberately
+// constructed collisions. Because their output is frozen, they should also not
+// be used for in-memory hash tables, which benefit from hashes that are free
+// to change.
+//
+// The output of these functions is frozen. Changing the value returned for any
+// input is a breaking change; `fingerprint_test.cc` pins known values.
+#ifndef ABSL_STRINGS_FINGERPRINT_H_
+#define ABSL_STRINGS_FINGERPRINT_H_
+
+#include <cstdint>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+
+namespace absl {
+
+// Fingerprint64()
+//
+// Returns a stable 64-bit fingerprint of the bytes of `s`.
+uint64_t Fingerprint64(absl::string_view s);
+
+// Fingerprint128()
+//
+// Returns a stable 128-bit fingerprint of the bytes of `s`. Prefer this over
+// `Fingerprint64()` when fingerprints of many (on the order of 2^32 or more)
+// distinct inputs must be distinct.
+absl::uint128 Fingerprint128(absl::string_view s);
+
+}  // namespace absl
+
+#endif  // ABSL_STRINGS_FINGERPRINT_H_
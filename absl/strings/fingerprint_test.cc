@@ -0,0 +1,163 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/strings/fingerprint.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// Returns `n` bytes of deterministic test data.
+std::string TestData(size_t n) {
+  std::string s(n, '\0');
+  for (size_t i = 0; i < n; ++i) s[i] = static_cast<char>(i * 7 + n);
+  return s;
+}
+
+// The fingerprint output is frozen. If this test fails, the change that
+// caused it must be reverted rather than the expected values updated.
+TEST(FingerprintTest, GoldenValues) {
+  const struct {
+    size_t length;
+    uint64_t fp64;
+    uint64_t fp128_high;
+    uint64_t fp128_low;
+  } kGolden[] = {
+      {0, uint64_t{0x22ba40fc4872519d},
+       uint64_t{0x31deafa6bb056872}, uint64_t{0x07a18882b4f1e11c}},
+      {1, uint64_t{0x0dc1d6a9ef518328},
+       uint64_t{0x79cca97ed9db2d57}, uint64_t{0xac0ddabeb9d50ba0}},
+      {2, uint64_t{0x0140917c4cffac9f},
+       uint64_t{0x679de672035d6345}, uint64_t{0x9642e33d39941483}},
+      {3, uint64_t{0x2ee3f5e06de50f6b},
+       uint64_t{0x6f7a39cc35ae43e0}, uint64_t{0x27b0ef0c37e86710}},
+      {4, uint64_t{0x106206e1545ab360},
+       uint64_t{0xd3470303957a26d6}, uint64_t{0x1e86f20c9b106e5e}},
+      {5, uint64_t{0x68c7a10fb8a7fd1a},
+       uint64_t{0x9ffcc6439fece7a5}, uint64_t{0xcc9d27b11fcc77d1}},
+      {7, uint64_t{0x06b39c9c8bcf1737},
+       uint64_t{0xf0c76e2e9317ec84}, uint64_t{0xa7148ec212079354}},
+      {8, uint64_t{0x651c717cbceca9c5},
+       uint64_t{0xb753ba37607a368f}, uint64_t{0x300767a77a90d517}},
+      {9, uint64_t{0x118f7cd011ac0f87},
+       uint64_t{0x03984167507a3102}, uint64_t{0x4099f180634ee5ab}},
+      {15, uint64_t{0x39f36afe3967e95a},
+       uint64_t{0x0652226dd25f7f65}, uint64_t{0x0fd91f953e6a7993}},
+      {16, uint64_t{0xbccc80856e93c286},
+       uint64_t{0x10a3ecfb13477b45}, uint64_t{0x098ce9d4e1db2937}},
+      {17, uint64_t{0x398d3532815eab6d},
+       uint64_t{0xffd4fcd2ea823c26}, uint64_t{0x4ee2db467266f977}},
+      {31, uint64_t{0x4b861f9a1b012941},
+       uint64_t{0x0c2d2440cd9544c3}, uint64_t{0x9c0595cdfda36352}},
+      {32, uint64_t{0x784ef29bc2cf7c78},
+       uint64_t{0xeffcc3e937878d1f}, uint64_t{0x17b3338481f2abbd}},
+      {33, uint64_t{0x04eeb1ad70ef9adf},
+       uint64_t{0x745e0bed76730114}, uint64_t{0x4cdc64f200a434a7}},
+      {63, uint64_t{0xf0f8823cd3fddfd6},
+       uint64_t{0xc86106af3bda33b0}, uint64_t{0x0ea08216c58a52ff}},
+      {64, uint64_t{0xe2c4864a0067a77f},
+       uint64_t{0x66dc1dc880670f0a}, uint64_t{0xe5d31770c949d20e}},
+      {65, uint64_t{0x047ebd2a96ff19ba},
+       uint64_t{0x3f50e9624ef8e3ec}, uint64_t{0xf6fc6b1ab11f1cb7}},
+      {100, uint64_t{0xa83b7cadc51ac739},
+       uint64_t{0xcc1afeb4a22e4c27}, uint64_t{0x118836c3134df38f}},
+      {255, uint64_t{0xda0ebc2fc091acb3},
+       uint64_t{0xa8181bcf886c746b}, uint64_t{0x5ff3684eea34ad16}},
+      {256, uint64_t{0x1ce67f1036c38e93},
+       uint64_t{0x1c2a93480d5960fd}, uint64_t{0x338f6711274e7734}},
+      {257, uint64_t{0x49fa3ab9b9a8e613},
+       uint64_t{0x3541f0e88c304530}, uint64_t{0xdbdfa584cd895342}},
+      {1000, uint64_t{0xfe0fb20a1fc16ec0},
+       uint64_t{0xb193898881addf23}, uint64_t{0x62d3a6eebd7d35ae}},
+      {1024, uint64_t{0x640df75fd6bcd715},
+       uint64_t{0x1f8242cd469c7f59}, uint64_t{0xe80e945219f4b0a0}},
+      {1025, uint64_t{0x6915ff52fd718e04},
+       uint64_t{0x37fe67dd84f9acd7}, uint64_t{0x3b1fc5e4a4690515}},
+      {4096, uint64_t{0x199e40737058d3ba},
+       uint64_t{0xe43dbb87e343b9ec}, uint64_t{0x2ebe3c12bf2205cf}},
+      {65536, uint64_t{0xa58bbf6be77886b8},
+       uint64_t{0x32a4f3f343fd1181}, uint64_t{0x6df5ec0f4e8307f2}},
+      {100000, uint64_t{0xc8f5226944c65bea},
+       uint64_t{0x1cd4a1e5b2e6af3f}, uint64_t{0x9e0c5498372adefc}},
+  };
+  for (const auto& golden : kGolden) {
+    SCOPED_TRACE(golden.length);
+    const std::string data = TestData(golden.length);
+    EXPECT_EQ(golden.fp64, absl::Fingerprint64(data));
+    EXPECT_EQ(absl::MakeUint128(golden.fp128_high, golden.fp128_low),
+              absl::Fingerprint128(data));
+  }
+}
+
+TEST(FingerprintTest, IndependentOfAlignment) {
+  const std::string data = TestData(3000);
+  std::string buffer(data.size() + 16, 'x');
+  for (size_t offset = 0; offset < 16; ++offset) {
+    for (size_t len : {3, 15, 40, 300, 3000}) {
+      buffer.replace(offset, len, data, 0, len);
+      absl::string_view view(buffer.data() + offset, len);
+      EXPECT_EQ(absl::Fingerprint64(absl::string_view(data).substr(0, len)),
+                absl::Fingerprint64(view));
+      EXPECT_EQ(absl::Fingerprint128(absl::string_view(data).substr(0, len)),
+                absl::Fingerprint128(view));
+    }
+  }
+}
+
+TEST(FingerprintTest, DistinctForSmallInputs) {
+  // Every string of up to two bytes, and every length of a run of zeros,
+  // which exercise the short-input and length-mixing paths.
+  std::unordered_set<uint64_t> fp64;
+  std::unordered_set<uint64_t> fp128_high;
+  size_t count = 0;
+  for (int len = 0; len <= 2; ++len) {
+    for (int v = 0; v < (1 << (8 * len)); ++v) {
+      std::string s(len, '\0');
+      for (int i = 0; i < len; ++i) s[i] = static_cast<char>(v >> (8 * i));
+      fp64.insert(absl::Fingerprint64(s));
+      fp128_high.insert(absl::Uint128High64(absl::Fingerprint128(s)));
+      ++count;
+    }
+  }
+  for (size_t len = 3; len <= 2000; ++len) {
+    const std::string zeros(len, '\0');
+    fp64.insert(absl::Fingerprint64(zeros));
+    fp128_high.insert(absl::Uint128High64(absl::Fingerprint128(zeros)));
+    ++count;
+  }
+  EXPECT_EQ(count, fp64.size());
+  EXPECT_EQ(count, fp128_high.size());
+}
+
+// Flipping any single input bit changes the fingerprint, including in long
+// inputs where the bit is consumed by the striped accumulator path.
+TEST(FingerprintTest, SensitiveToEveryBit) {
+  for (size_t len : {1, 9, 33, 257, 1500}) {
+    std::string data = TestData(len);
+    const uint64_t fp64 = absl::Fingerprint64(data);
+    const absl::uint128 fp128 = absl::Fingerprint128(data);
+    for (size_t bit = 0; bit < len * 8; ++bit) {
+      data[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+      EXPECT_NE(fp64, absl::Fingerprint64(data)) << len << " " << bit;
+      EXPECT_NE(fp128, absl::Fingerprint128(data)) << len << " " << bit;
+      data[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,177 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/strings/prefix_matcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <deque>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/internal/memutil.h"
+
+namespace absl {
+
+constexpr size_t PrefixMatcher::npos;
+constexpr uint32_t PrefixMatcher::kNoMatch;
+
+namespace {
+
+// A distinct (possibly case-folded) prefix and the index of its first
+// occurrence in the input.
+struct Key {
+  std::string text;
+  uint32_t index;
+};
+
+// Length of the common prefix of `a` and `b`.
+size_t CommonPrefixLength(absl::string_view a, absl::string_view b) {
+  size_t n = std::min(a.size(), b.size());
+  size_t i = 0;
+  while (i < n && a[i] == b[i]) ++i;
+  return i;
+}
+
+// A node awaiting layout: the sorted keys `[begin, end)` of `keys` all share
+// their first `depth` bytes, and the node itself lives at `nodes_[slot]`.
+struct PendingNode {
+  uint32_t slot;
+  size_t begin;
+  size_t end;
+  size_t depth;
+};
+
+}  // namespace
+
+PrefixMatcher::PrefixMatcher(const std::vector<absl::string_view>& prefixes,
+                             CaseMode mode)
+    : mode_(mode), prefixes_(prefixes.begin(), prefixes.end()) {
+  std::vector<Key> keys;
+  keys.reserve(prefixes.size());
+  for (size_t i = 0; i < prefixes.size(); ++i) {
+    Key key = {std::string(prefixes[i]), static_cast<uint32_t>(i)};
+    if (mode_ == kIgnoreCase) absl::AsciiStrToLower(&key.text);
+    keys.push_back(std::move(key));
+  }
+  // Sort so that keys sharing a prefix are adjacent, keeping the earliest
+  // occurrence of each duplicate first so that it is the one retained.
+  std::stable_sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+    return a.text < b.text;
+  });
+  keys.erase(std::unique(keys.begin(), keys.end(),
+                         [](const Key& a, const Key& b) {
+                           return a.text == b.text;
+                         }),
+             keys.end());
+
+  // Lay the radix trie out breadth-first so that the children of each node
+  // are contiguous. Every node owns a range of sorted keys sharing its path;
+  // a key exactly as long as the path terminates at the node, and the rest
+  // are grouped by their next byte into one child per group, whose edge
+  // label extends as far as the group's common prefix.
+  nodes_.push_back(Node{0, 0, 0, 0, kNoMatch});
+  first_bytes_.push_back('\0');
+  std::deque<PendingNode> pending;
+  pending.push_back(PendingNode{0, 0, keys.size(), 0});
+  while (!pending.empty()) {
+    PendingNode p = pending.front();
+    pending.pop_front();
+    size_t i = p.begin;
+    if (i < p.end && keys[i].text.size() == p.depth) {
+      nodes_[p.slot].match = keys[i].index;
+      ++i;
+    }
+    nodes_[p.slot].first_child = static_cast<uint32_t>(nodes_.size());
+    while (i < p.end) {
+      const char c = keys[i].text[p.depth];
+      size_t j = i + 1;
+      while (j < p.end && keys[j].text[p.depth] == c) ++j;
+      // Keys are sorted, so the common prefix of the whole group is the
+      // common prefix of its first and last members.
+      const size_t depth =
+          CommonPrefixLength(keys[i].text, keys[j - 1].text);
+      assert(depth > p.depth);
+      Node child;
+      child.label_offset = static_cast<uint32_t>(labels_.size());
+      child.label_size = static_cast<uint32_t>(depth - p.depth);
+      child.first_child = 0;
+      child.num_children = 0;
+      child.match = kNoMatch;
+      labels_.append(keys[i].text, p.depth, depth - p.depth);
+      pending.push_back(
+          PendingNode{static_cast<uint32_t>(nodes_.size()), i, j, depth});
+      nodes_.push_back(child);
+      first_bytes_.push_back(c);
+      ++nodes_[p.slot].num_children;
+      i = j;
+    }
+  }
+}
+
+template <typename Fn>
+void PrefixMatcher::Walk(absl::string_view text, Fn fn) const {
+  const char* bytes = first_bytes_.data();
+  const char* labels = labels_.data();
+  const bool ignore_case = mode_ == kIgnoreCase;
+  const Node* node = &nodes_[0];
+  size_t pos = 0;
+  for (;;) {
+    if (node->match != kNoMatch && fn(node->match)) return;
+    if (node->num_children == 0 || pos == text.size()) return;
+    char c = text[pos];
+    if (ignore_case) c = absl::ascii_tolower(static_cast<unsigned char>(c));
+    const void* hit =
+        memchr(bytes + node->first_child, c, node->num_children);
+    if (hit == nullptr) return;
+    const Node* child = &nodes_[static_cast<const char*>(hit) - bytes];
+    const size_t len = child->label_size;
+    if (text.size() - pos < len) return;
+    // The first byte of the label has already been matched above.
+    const char* label = labels + child->label_offset + 1;
+    const char* input = text.data() + pos + 1;
+    if (ignore_case ? strings_internal::memcasecmp(label, input, len - 1) != 0
+                    : memcmp(label, input, len - 1) != 0) {
+      return;
+    }
+    pos += len;
+    node = child;
+  }
+}
+
+bool PrefixMatcher::Matches(absl::string_view text) const {
+  bool matched = false;
+  Walk(text, [&matched](uint32_t) { return matched = true; });
+  return matched;
+}
+
+size_t PrefixMatcher::LongestMatch(absl::string_view text) const {
+  size_t longest = npos;
+  Walk(text, [&longest](uint32_t index) {
+    longest = index;
+    return false;
+  });
+  return longest;
+}
+
+std::vector<size_t> PrefixMatcher::AllMatches(absl::string_view text) const {
+  std::vector<size_t> matches;
+  Walk(text, [&matches](uint32_t index) {
+    matches.push_back(index);
+    return false;
+  });
+  return matches;
+}
+
+}  // namespace absl
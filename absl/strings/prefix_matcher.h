@@ -0,0 +1,163 @@
+//
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// File: prefix_matcher.h
+// -----------------------------------------------------------------------------
+//
+// This file defines `absl::PrefixMatcher`, a precompiled set of prefixes that
+// can be tested against a string in a single pass. It is intended to replace
+// loops of the form
+//
+//   for (absl::string_view prefix : prefixes) {
+//     if (absl::StartsWith(path, prefix)) ...
+//   }
+//
+// whose cost grows with the number of prefixes. A `PrefixMatcher` stores its
+// prefixes in a flattened radix trie, so a lookup costs time proportional to
+// the length of the matched portion of the input regardless of how many
+// prefixes the matcher holds.
+//
+// Example:
+//
+//   absl::PrefixMatcher routes({"/api/", "/api/v2/", "/static/"});
+//   size_t i = routes.LongestMatch("/api/v2/users");
+//   // i == 1, routes.prefix(i) == "/api/v2/"
+//
+// A `PrefixMatcher` is immutable once constructed and may be used concurrently
+// from multiple threads.
+#ifndef ABSL_STRINGS_PREFIX_MATCHER_H_
+#define ABSL_STRINGS_PREFIX_MATCHER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace absl {
+
+// PrefixMatcher
+//
+// A compiled set of prefixes supporting longest-match and all-matches lookups.
+// Prefixes are identified by their index in the sequence the matcher was
+// constructed from. If the same prefix (or, for `kIgnoreCase` matchers, the
+// same prefix up to ASCII case) appears more than once, lookups report the
+// index of its first occurrence.
+class PrefixMatcher {
+ public:
+  // Controls how prefixes are compared against input text. `kIgnoreCase`
+  // matches the semantics of `absl::StartsWithIgnoreCase()`, folding ASCII
+  // letters only.
+  enum CaseMode {
+    kCaseSensitive,
+    kIgnoreCase,
+  };
+
+  // Value returned by `LongestMatch()` when no prefix matches.
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  // Constructs an empty matcher that matches nothing.
+  PrefixMatcher() : PrefixMatcher(std::vector<absl::string_view>()) {}
+
+  PrefixMatcher(std::initializer_list<absl::string_view> prefixes,
+                CaseMode mode = kCaseSensitive)
+      : PrefixMatcher(std::vector<absl::string_view>(prefixes), mode) {}
+
+  // Constructs a matcher from any range of values convertible to
+  // `absl::string_view`, such as a `std::vector<std::string>`.
+  template <typename Container,
+            typename = decltype(absl::string_view(
+                *std::begin(std::declval<const Container&>())))>
+  explicit PrefixMatcher(const Container& prefixes,
+                         CaseMode mode = kCaseSensitive)
+      : PrefixMatcher(std::vector<absl::string_view>(std::begin(prefixes),
+                                                     std::end(prefixes)),
+                      mode) {}
+
+  explicit PrefixMatcher(const std::vector<absl::string_view>& prefixes,
+                         CaseMode mode = kCaseSensitive);
+
+  PrefixMatcher(const PrefixMatcher&) = default;
+  PrefixMatcher(PrefixMatcher&&) = default;
+  PrefixMatcher& operator=(const PrefixMatcher&) = default;
+  PrefixMatcher& operator=(PrefixMatcher&&) = default;
+
+  // PrefixMatcher::Matches()
+  //
+  // Returns whether any prefix in the set is a prefix of `text`.
+  bool Matches(absl::string_view text) const;
+
+  // PrefixMatcher::LongestMatch()
+  //
+  // Returns the index of the longest prefix in the set that `text` starts
+  // with, or `PrefixMatcher::npos` if there is none.
+  size_t LongestMatch(absl::string_view text) const;
+
+  // PrefixMatcher::AllMatches()
+  //
+  // Returns the indices of every prefix in the set that `text` starts with,
+  // ordered from shortest to longest prefix.
+  std::vector<size_t> AllMatches(absl::string_view text) const;
+
+  // PrefixMatcher::prefix()
+  //
+  // Returns the `i`th prefix the matcher was constructed from.
+  absl::string_view prefix(size_t i) const { return prefixes_[i]; }
+
+  // PrefixMatcher::size()
+  //
+  // Returns the number of prefixes the matcher was constructed from, including
+  // duplicates.
+  size_t size() const { return prefixes_.size(); }
+
+  bool empty() const { return prefixes_.empty(); }
+
+  CaseMode case_mode() const { return mode_; }
+
+ private:
+  static constexpr uint32_t kNoMatch = static_cast<uint32_t>(-1);
+
+  // A trie node. The children of a node occupy the contiguous range
+  // `[first_child, first_child + num_children)` of `nodes_`, and the first byte
+  // of each child's edge label is mirrored in `first_bytes_` so that selecting
+  // a child is a single `memchr()` over adjacent bytes.
+  struct Node {
+    uint32_t label_offset;  // Edge label leading into this node, in `labels_`.
+    uint32_t label_size;
+    uint32_t first_child;
+    uint32_t num_children;
+    uint32_t match;  // Index of the prefix ending here, or `kNoMatch`.
+  };
+
+  // Walks the trie along `text`, invoking `fn(index)` for every prefix
+  // matched, shortest first, and stopping early once `fn` returns true.
+  template <typename Fn>
+  void Walk(absl::string_view text, Fn fn) const;
+
+  CaseMode mode_;
+  std::vector<std::string> prefixes_;
+  std::vector<Node> nodes_;
+  std::string first_bytes_;
+  std::string labels_;
+};
+
+}  // namespace absl
+
+#endif  // ABSL_STRINGS_PREFIX_MATCHER_H_
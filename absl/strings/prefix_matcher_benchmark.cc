@@ -0,0 +1,118 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/strings/prefix_matcher.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+
+namespace {
+
+// Builds `n` URL-like route prefixes of the form "/service<k>/v<j>/" that
+// share leading bytes the way real routing tables do.
+std::vector<std::string> MakePrefixes(int n) {
+  std::vector<std::string> prefixes;
+  prefixes.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    prefixes.push_back(absl::StrCat("/service", i / 4, "/v", i % 4, "/"));
+  }
+  return prefixes;
+}
+
+// Request paths, about half of which match one of the prefixes.
+std::vector<std::string> MakePaths(int n) {
+  std::minstd_rand rng(17);
+  std::vector<std::string> paths;
+  for (int i = 0; i < 64; ++i) {
+    const int k = rng() % (n * 2);
+    paths.push_back(
+        absl::StrCat("/service", k / 4, "/v", k % 4, "/resource/", i));
+  }
+  return paths;
+}
+
+void BM_LinearStartsWith(benchmark::State& state) {
+  const std::vector<std::string> prefixes = MakePrefixes(state.range(0));
+  const std::vector<std::string> paths = MakePaths(state.range(0));
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::string& path = paths[i++ % paths.size()];
+    size_t longest = absl::PrefixMatcher::npos;
+    for (size_t p = 0; p < prefixes.size(); ++p) {
+      if (absl::StartsWith(path, prefixes[p]) &&
+          (longest == absl::PrefixMatcher::npos ||
+           prefixes[p].size() > prefixes[longest].size())) {
+        longest = p;
+      }
+    }
+    benchmark::DoNotOptimize(longest);
+  }
+}
+BENCHMARK(BM_LinearStartsWith)->Range(1, 1 << 12);
+
+void BM_LinearStartsWithIgnoreCase(benchmark::State& state) {
+  const std::vector<std::string> prefixes = MakePrefixes(state.range(0));
+  const std::vector<std::string> paths = MakePaths(state.range(0));
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::string& path = paths[i++ % paths.size()];
+    size_t longest = absl::PrefixMatcher::npos;
+    for (size_t p = 0; p < prefixes.size(); ++p) {
+      if (absl::StartsWithIgnoreCase(path, prefixes[p]) &&
+          (longest == absl::PrefixMatcher::npos ||
+           prefixes[p].size() > prefixes[longest].size())) {
+        longest = p;
+      }
+    }
+    benchmark::DoNotOptimize(longest);
+  }
+}
+BENCHMARK(BM_LinearStartsWithIgnoreCase)->Range(1, 1 << 12);
+
+void BM_PrefixMatcher(benchmark::State& state) {
+  const absl::PrefixMatcher matcher(MakePrefixes(state.range(0)));
+  const std::vector<std::string> paths = MakePaths(state.range(0));
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher.LongestMatch(paths[i++ % paths.size()]));
+  }
+}
+BENCHMARK(BM_PrefixMatcher)->Range(1, 1 << 12);
+
+void BM_PrefixMatcherIgnoreCase(benchmark::State& state) {
+  const absl::PrefixMatcher matcher(MakePrefixes(state.range(0)),
+                                    absl::PrefixMatcher::kIgnoreCase);
+  const std::vector<std::string> paths = MakePaths(state.range(0));
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(matcher.LongestMatch(paths[i++ % paths.size()]));
+  }
+}
+BENCHMARK(BM_PrefixMatcherIgnoreCase)->Range(1, 1 << 12);
+
+void BM_PrefixMatcherBuild(benchmark::State& state) {
+  const std::vector<std::string> prefixes = MakePrefixes(state.range(0));
+  for (auto _ : state) {
+    absl::PrefixMatcher matcher(prefixes);
+    benchmark::DoNotOptimize(matcher);
+  }
+}
+BENCHMARK(BM_PrefixMatcherBuild)->Range(1, 1 << 12);
+
+}  // namespace
@@ -0,0 +1,153 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/strings/prefix_matcher.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/match.h"
+
+namespace {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+TEST(PrefixMatcherTest, Empty) {
+  absl::PrefixMatcher m;
+  EXPECT_TRUE(m.empty());
+  EXPECT_EQ(0, m.size());
+  EXPECT_FALSE(m.Matches(""));
+  EXPECT_FALSE(m.Matches("foo"));
+  EXPECT_EQ(absl::PrefixMatcher::npos, m.LongestMatch("foo"));
+  EXPECT_THAT(m.AllMatches("foo"), IsEmpty());
+}
+
+TEST(PrefixMatcherTest, EmptyPrefixMatchesEverything) {
+  absl::PrefixMatcher m({""});
+  EXPECT_TRUE(m.Matches(""));
+  EXPECT_TRUE(m.Matches("anything"));
+  EXPECT_EQ(0, m.LongestMatch("anything"));
+}
+
+TEST(PrefixMatcherTest, LongestMatch) {
+  absl::PrefixMatcher m({"/api/", "/api/v2/", "/static/", "/", "/api/v2"});
+  EXPECT_EQ(1, m.LongestMatch("/api/v2/users"));
+  EXPECT_EQ(4, m.LongestMatch("/api/v2"));
+  EXPECT_EQ(0, m.LongestMatch("/api/v1/users"));
+  EXPECT_EQ(2, m.LongestMatch("/static/app.js"));
+  EXPECT_EQ(3, m.LongestMatch("/stat"));
+  EXPECT_EQ(absl::PrefixMatcher::npos, m.LongestMatch("api/"));
+  EXPECT_EQ(absl::PrefixMatcher::npos, m.LongestMatch(""));
+  EXPECT_EQ("/api/v2/", m.prefix(m.LongestMatch("/api/v2/users")));
+}
+
+TEST(PrefixMatcherTest, AllMatches) {
+  absl::PrefixMatcher m({"/api/", "/api/v2/", "/static/", "/", "/api/v2"});
+  EXPECT_THAT(m.AllMatches("/api/v2/users"), ElementsAre(3, 0, 4, 1));
+  EXPECT_THAT(m.AllMatches("/api"), ElementsAre(3));
+  EXPECT_THAT(m.AllMatches("x"), IsEmpty());
+}
+
+TEST(PrefixMatcherTest, Duplicates) {
+  absl::PrefixMatcher m({"foo", "bar", "foo"});
+  EXPECT_EQ(3, m.size());
+  EXPECT_EQ(0, m.LongestMatch("foobar"));
+  EXPECT_THAT(m.AllMatches("foobar"), ElementsAre(0));
+}
+
+TEST(PrefixMatcherTest, EmbeddedNul) {
+  const std::string with_nul("a\0b", 3);
+  absl::PrefixMatcher m({with_nul, "a"});
+  EXPECT_EQ(0, m.LongestMatch(std::string("a\0bc", 4)));
+  EXPECT_EQ(1, m.LongestMatch(std::string("a\0c", 3)));
+}
+
+TEST(PrefixMatcherTest, IgnoreCase) {
+  absl::PrefixMatcher m({"Content-", "content-type", "X-"},
+                        absl::PrefixMatcher::kIgnoreCase);
+  EXPECT_EQ(absl::PrefixMatcher::kIgnoreCase, m.case_mode());
+  EXPECT_EQ(1, m.LongestMatch("CONTENT-TYPE: text/plain"));
+  EXPECT_EQ(0, m.LongestMatch("content-length: 5"));
+  EXPECT_EQ(2, m.LongestMatch("x-forwarded-for"));
+  EXPECT_FALSE(m.Matches("Accept"));
+
+  absl::PrefixMatcher sensitive({"Content-"});
+  EXPECT_FALSE(sensitive.Matches("content-length"));
+  EXPECT_TRUE(sensitive.Matches("Content-Length"));
+}
+
+TEST(PrefixMatcherTest, IgnoreCaseDuplicates) {
+  absl::PrefixMatcher m({"ABC", "abc"}, absl::PrefixMatcher::kIgnoreCase);
+  EXPECT_EQ(0, m.LongestMatch("aBcD"));
+}
+
+TEST(PrefixMatcherTest, FromContainer) {
+  std::vector<std::string> prefixes = {"alpha", "beta"};
+  absl::PrefixMatcher m(prefixes);
+  EXPECT_EQ(2, m.size());
+  EXPECT_EQ(1, m.LongestMatch("betamax"));
+  EXPECT_EQ("alpha", m.prefix(0));
+}
+
+// Cross-checks the trie against a linear scan with StartsWith() and
+// StartsWithIgnoreCase() over randomly generated prefixes and inputs drawn
+// from a small alphabet, so that shared prefixes are common.
+TEST(PrefixMatcherTest, MatchesLinearScan) {
+  std::minstd_rand rng(42);
+  auto random_string = [&rng](size_t max_len) {
+    std::string s(rng() % (max_len + 1), ' ');
+    for (char& c : s) c = "abAB/"[rng() % 5];
+    return s;
+  };
+  for (int round = 0; round < 50; ++round) {
+    std::vector<std::string> prefixes;
+    const int num_prefixes = 1 + rng() % 40;
+    for (int i = 0; i < num_prefixes; ++i) {
+      prefixes.push_back(random_string(6));
+    }
+    for (auto mode : {absl::PrefixMatcher::kCaseSensitive,
+                      absl::PrefixMatcher::kIgnoreCase}) {
+      absl::PrefixMatcher m(prefixes, mode);
+      for (int t = 0; t < 50; ++t) {
+        std::string text = random_string(10);
+        size_t expected = absl::PrefixMatcher::npos;
+        for (size_t i = 0; i < prefixes.size(); ++i) {
+          bool starts = mode == absl::PrefixMatcher::kIgnoreCase
+                            ? absl::StartsWithIgnoreCase(text, prefixes[i])
+                            : absl::StartsWith(text, prefixes[i]);
+          if (starts && (expected == absl::PrefixMatcher::npos ||
+                         prefixes[i].size() > prefixes[expected].size())) {
+            expected = i;
+          }
+        }
+        size_t actual = m.LongestMatch(text);
+        EXPECT_EQ(expected == absl::PrefixMatcher::npos,
+                  actual == absl::PrefixMatcher::npos)
+            << text;
+        EXPECT_EQ(expected != absl::PrefixMatcher::npos, m.Matches(text));
+        if (expected != absl::PrefixMatcher::npos &&
+            actual != absl::PrefixMatcher::npos) {
+          EXPECT_EQ(prefixes[expected].size(), prefixes[actual].size())
+              << text;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
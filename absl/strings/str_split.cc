@@ -23,6 +23,11 @@
 #include <limits>
 #include <memory>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "absl/base/internal/bits.h"
 #include "absl/base/internal/raw_logging.h"
 #include "absl/strings/ascii.h"
 
@@ -74,6 +79,73 @@ struct AnyOfPolicy {
   size_t Length(absl::string_view /* delimiter */) { return 1; }
 };
 
+#ifdef __SSE2__
+
+// Returns a 64-bit mask with bit `i` set if `p[i] == c`.
+inline uint64_t MatchMask64(const char* p, __m128i c) {
+  uint64_t mask = 0;
+  for (int i = 0; i < 4; ++i) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+    const uint32_t bits =
+        static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, c)));
+    mask |= static_cast<uint64_t>(bits) << (16 * i);
+  }
+  return mask;
+}
+
+// Returns a mask in which bit `i` is the parity of the bits `[0, i]` of
+// `quotes`, i.e. set for bytes following an unmatched opening quote.
+inline uint64_t PrefixXor(uint64_t quotes) {
+  quotes ^= quotes << 1;
+  quotes ^= quotes << 2;
+  quotes ^= quotes << 4;
+  quotes ^= quotes << 8;
+  quotes ^= quotes << 16;
+  quotes ^= quotes << 32;
+  return quotes;
+}
+
+#endif  // __SSE2__
+
+// Returns the position of the first `target` at or after `pos` in `text` that
+// is not enclosed in double quotes, or `absl::string_view::npos`. `pos` must
+// not be inside a quoted section.
+//
+// Quote state is the parity of the quotes seen so far. On SSE2 targets the
+// input is processed 64 bytes at a time: the quote and target positions are
+// extracted as bitmasks, a prefix XOR over the quote mask yields the bytes
+// that are inside quotes, and the first target outside them is the answer.
+size_t FindUnquoted(absl::string_view text, size_t pos, char target) {
+  const char* p = text.data();
+  const size_t n = text.size();
+  bool in_quotes = false;
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i wanted = _mm_set1_epi8(target);
+  uint64_t carry = 0;  // All ones if the previous block ended inside quotes.
+  for (; pos + 64 <= n; pos += 64) {
+    const uint64_t targets = MatchMask64(p + pos, wanted);
+    const uint64_t quotes = MatchMask64(p + pos, quote);
+    const uint64_t quoted = PrefixXor(quotes) ^ carry;
+    const uint64_t hits = targets & ~quoted;
+    if (hits != 0) {
+      return pos + base_internal::CountTrailingZerosNonZero64(hits);
+    }
+    carry = static_cast<uint64_t>(0) - (quoted >> 63);
+  }
+  in_quotes = carry != 0;
+#endif
+  for (; pos < n; ++pos) {
+    if (p[pos] == '"') {
+      in_quotes = !in_quotes;
+    } else if (p[pos] == target && !in_quotes) {
+      return pos;
+    }
+  }
+  return absl::string_view::npos;
+}
+
 }  // namespace
 
 //
@@ -134,4 +206,53 @@ absl::string_view ByLength::Find(absl::string_view text,
   return absl::string_view(substr.data() + length_, 0);
 }
 
+//
+// ByCsvRecord
+//
+
+absl::string_view ByCsvRecord::Find(absl::string_view text, size_t pos) const {
+  const size_t found_pos = FindUnquoted(text, pos, '\n');
+  if (found_pos == absl::string_view::npos)
+    return absl::string_view(text.data() + text.size(), 0);
+  if (found_pos > pos && text[found_pos - 1] == '\r')
+    return text.substr(found_pos - 1, 2);
+  return text.substr(found_pos, 1);
+}
+
+//
+// ByCsvField
+//
+
+ByCsvField::ByCsvField(char separator) : separator_(separator) {
+  ABSL_RAW_CHECK(separator != '"',
+                 "ByCsvField separator may not be the quote character");
+}
+
+absl::string_view ByCsvField::Find(absl::string_view text, size_t pos) const {
+  const size_t found_pos = FindUnquoted(text, pos, separator_);
+  if (found_pos == absl::string_view::npos)
+    return absl::string_view(text.data() + text.size(), 0);
+  return text.substr(found_pos, 1);
+}
+
+absl::string_view UnquoteCsvField(absl::string_view field,
+                                  std::string* scratch) {
+  if (field.size() < 2 || field.front() != '"' || field.back() != '"') {
+    return field;
+  }
+  field.remove_prefix(1);
+  field.remove_suffix(1);
+  size_t quote = field.find('"');
+  if (quote == absl::string_view::npos) return field;
+  // Collapse each escaped quote pair into a single quote.
+  scratch->clear();
+  while (quote != absl::string_view::npos) {
+    scratch->append(field.data(), quote + 1);
+    field.remove_prefix(std::min(quote + 2, field.size()));
+    quote = field.find('"');
+  }
+  scratch->append(field.data(), field.size());
+  return *scratch;
+}
+
 }  // namespace absl
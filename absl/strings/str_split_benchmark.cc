@@ -116,6 +116,47 @@ void BM_SplitStringAllowEmpty(benchmark::State& state) {
 }
 BENCHMARK_RANGE(BM_SplitStringAllowEmpty, 0, 1 << 20);
 
+// Builds `records` CSV records of four fields each, where every other record
+// has a quoted field containing separators, escaped quotes and a newline.
+std::string MakeCsvTestString(int records) {
+  std::string csv;
+  for (int i = 0; i < records; ++i) {
+    csv += "12345,some text value,";
+    csv += (i % 2 == 0) ? "\"quoted, \"\"with\"\" a\nnewline\"" : "plain";
+    csv += ",3.14159\r\n";
+  }
+  return csv;
+}
+
+void BM_SplitCsvRecords(benchmark::State& state) {
+  std::string test = MakeCsvTestString(state.range(0));
+  for (auto _ : state) {
+    std::vector<absl::string_view> result =
+        absl::StrSplit(test, absl::ByCsvRecord());
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * test.size());
+}
+BENCHMARK_RANGE(BM_SplitCsvRecords, 1, 1 << 14);
+
+void BM_SplitCsvFields(benchmark::State& state) {
+  std::string test = MakeCsvTestString(state.range(0));
+  std::string scratch;
+  for (auto _ : state) {
+    size_t bytes = 0;
+    for (absl::string_view record :
+         absl::StrSplit(test, absl::ByCsvRecord(), absl::SkipEmpty())) {
+      for (absl::string_view field :
+           absl::StrSplit(record, absl::ByCsvField())) {
+        bytes += absl::UnquoteCsvField(field, &scratch).size();
+      }
+    }
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetBytesProcessed(state.iterations() * test.size());
+}
+BENCHMARK_RANGE(BM_SplitCsvFields, 1, 1 << 14);
+
 struct OneCharLiteral {
   char operator()() const { return 'X'; }
 };
@@ -902,6 +902,110 @@ TEST(Delimiter, ByLength) {
   EXPECT_FALSE(IsFoundAt("abcd", four_char_delim, 0));
 }
 
+//
+// Tests for ByCsvRecord, ByCsvField and UnquoteCsvField
+//
+
+TEST(Delimiter, ByCsvRecord) {
+  using absl::ByCsvRecord;
+
+  EXPECT_THAT(absl::StrSplit("a,b\nc,d", ByCsvRecord()),
+              ElementsAre("a,b", "c,d"));
+  EXPECT_THAT(absl::StrSplit("a,b\r\nc,d\r\n", ByCsvRecord()),
+              ElementsAre("a,b", "c,d", ""));
+  // Newlines inside quotes belong to the field.
+  EXPECT_THAT(absl::StrSplit("a,\"b\nc\"\r\nd,\"\"\"\n\"", ByCsvRecord()),
+              ElementsAre("a,\"b\nc\"", "d,\"\"\"\n\""));
+  EXPECT_THAT(absl::StrSplit("\"\r\n\"", ByCsvRecord()),
+              ElementsAre("\"\r\n\""));
+}
+
+TEST(Delimiter, ByCsvField) {
+  using absl::ByCsvField;
+
+  EXPECT_THAT(absl::StrSplit("a,b,,c", ByCsvField()),
+              ElementsAre("a", "b", "", "c"));
+  EXPECT_THAT(absl::StrSplit("\"a,b\",c", ByCsvField()),
+              ElementsAre("\"a,b\"", "c"));
+  EXPECT_THAT(absl::StrSplit("\"say \"\"hi, there\"\"\",x", ByCsvField()),
+              ElementsAre("\"say \"\"hi, there\"\"\"", "x"));
+  EXPECT_THAT(absl::StrSplit("a\t\"b\tc\"\td", ByCsvField('\t')),
+              ElementsAre("a", "\"b\tc\"", "d"));
+  EXPECT_THAT(absl::StrSplit("", ByCsvField()), ElementsAre(""));
+}
+
+// Exercises the block-at-a-time scan with quoted sections that straddle block
+// boundaries, comparing against a byte-at-a-time parity scan.
+TEST(Delimiter, ByCsvFieldLongRecords) {
+  uint32_t seed = 7;
+  auto next = [&seed]() { return (seed = seed * 1103515245 + 12345) >> 16; };
+  for (int round = 0; round < 200; ++round) {
+    std::string record(next() % 300, 'x');
+    for (char& c : record) {
+      switch (next() % 8) {
+        case 0: c = ','; break;
+        case 1: c = '"'; break;
+        default: break;
+      }
+    }
+    std::vector<absl::string_view> expected;
+    bool in_quotes = false;
+    size_t start = 0;
+    for (size_t i = 0; i < record.size(); ++i) {
+      if (record[i] == '"') {
+        in_quotes = !in_quotes;
+      } else if (record[i] == ',' && !in_quotes) {
+        expected.push_back(absl::string_view(record).substr(start, i - start));
+        start = i + 1;
+      }
+    }
+    expected.push_back(absl::string_view(record).substr(start));
+    std::vector<absl::string_view> actual =
+        absl::StrSplit(record, absl::ByCsvField());
+    EXPECT_EQ(expected, actual) << record;
+  }
+}
+
+TEST(Split, UnquoteCsvField) {
+  std::string scratch = "unchanged";
+  const std::string plain = "plain";
+  absl::string_view value = absl::UnquoteCsvField(plain, &scratch);
+  EXPECT_EQ("plain", value);
+  EXPECT_EQ(plain.data(), value.data());
+
+  const std::string quoted = "\"a,b\"";
+  value = absl::UnquoteCsvField(quoted, &scratch);
+  EXPECT_EQ("a,b", value);
+  EXPECT_EQ(quoted.data() + 1, value.data());
+  EXPECT_EQ("unchanged", scratch);
+
+  EXPECT_EQ("say \"hi\"",
+            absl::UnquoteCsvField("\"say \"\"hi\"\"\"", &scratch));
+  EXPECT_EQ("\"", absl::UnquoteCsvField("\"\"\"\"", &scratch));
+  EXPECT_EQ("", absl::UnquoteCsvField("\"\"", &scratch));
+  EXPECT_EQ("\"", absl::UnquoteCsvField("\"", &scratch));
+  EXPECT_EQ("", absl::UnquoteCsvField("", &scratch));
+}
+
+TEST(Split, CsvRecordsAndFields) {
+  const std::string csv =
+      "name,quote\r\n"
+      "alice,\"hello, world\"\r\n"
+      "bob,\"line one\nline \"\"two\"\"\"\r\n";
+  std::vector<std::vector<std::string>> rows;
+  std::string scratch;
+  for (absl::string_view record :
+       absl::StrSplit(csv, absl::ByCsvRecord(), absl::SkipEmpty())) {
+    rows.emplace_back();
+    for (absl::string_view f : absl::StrSplit(record, absl::ByCsvField())) {
+      rows.back().push_back(std::string(absl::UnquoteCsvField(f, &scratch)));
+    }
+  }
+  EXPECT_THAT(rows, ElementsAre(ElementsAre("name", "quote"),
+                                ElementsAre("alice", "hello, world"),
+                                ElementsAre("bob", "line one\nline \"two\"")));
+}
+
 TEST(Split, WorksWithLargeStrings) {
   if (sizeof(size_t) > 4) {
     std::string s((uint32_t{1} << 31) + 1, 'x');  // 2G + 1 byte
@@ -21,6 +21,11 @@
 #include <cstring>
 #include <ostream>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "absl/base/internal/bits.h"
 #include "absl/strings/internal/memutil.h"
 
 namespace absl {
@@ -54,6 +59,108 @@ class LookupTable {
   bool table_[UCHAR_MAX + 1] = {};
 };
 
+#ifdef __SSE2__
+
+// SmallCharSet is the find_.*_of counterpart of LookupTable for sets of at
+// most kMaxSize characters. Rather than looking up one byte at a time, it
+// compares 16 bytes of the haystack against every wanted character at once
+// and reduces the result to a bitmask. Each wanted character costs one
+// compare per block, so beyond about 8 characters the LookupTable is as fast.
+class SmallCharSet {
+ public:
+  static constexpr size_t kMaxSize = 8;
+
+  explicit SmallCharSet(string_view wanted)
+      : wanted_(wanted), size_(wanted.size()) {
+    assert(size_ > 0 && size_ <= kMaxSize);
+    for (size_t i = 0; i < size_; ++i) {
+      splat_[i] = _mm_set1_epi8(wanted[i]);
+    }
+  }
+
+  // Returns the index of the first byte of `[p + pos, p + len)` whose
+  // membership in the set equals `kInSet`, or `string_view::npos`.
+  template <bool kInSet>
+  size_t FindFirst(const char* p, size_t pos, size_t len) const {
+    if (pos >= len) return string_view::npos;
+    if (len < kBlock) {
+      for (; pos < len; ++pos) {
+        if (Contains(p[pos]) == kInSet) return pos;
+      }
+      return string_view::npos;
+    }
+    for (; pos + kBlock <= len; pos += kBlock) {
+      uint32_t mask = Mask<kInSet>(p + pos);
+      if (mask != 0) {
+        return pos + base_internal::CountTrailingZerosNonZero32(mask);
+      }
+    }
+    if (pos == len) return string_view::npos;
+    // Finish with a block ending at `len` that overlaps bytes already
+    // rejected, and discard the bits for those bytes.
+    const size_t start = len - kBlock;
+    uint32_t mask = Mask<kInSet>(p + start) >> (pos - start);
+    if (mask == 0) return string_view::npos;
+    return pos + base_internal::CountTrailingZerosNonZero32(mask);
+  }
+
+  // Returns the index of the last byte of `[p, p + end)` whose membership in
+  // the set equals `kInSet`, or `string_view::npos`.
+  template <bool kInSet>
+  size_t FindLast(const char* p, size_t end) const {
+    if (end < kBlock) {
+      while (end > 0) {
+        --end;
+        if (Contains(p[end]) == kInSet) return end;
+      }
+      return string_view::npos;
+    }
+    for (; end >= kBlock; end -= kBlock) {
+      uint32_t mask = Mask<kInSet>(p + end - kBlock);
+      if (mask != 0) return end - kBlock + HighestBit(mask);
+    }
+    if (end == 0) return string_view::npos;
+    // Finish with the block starting at `p`, discarding the bits for bytes at
+    // or beyond `end` that have already been rejected.
+    uint32_t mask = Mask<kInSet>(p) & ((1u << end) - 1);
+    if (mask == 0) return string_view::npos;
+    return HighestBit(mask);
+  }
+
+ private:
+  static constexpr size_t kBlock = sizeof(__m128i);
+
+  static size_t HighestBit(uint32_t mask) {
+    return 31 - base_internal::CountLeadingZeros32(mask);
+  }
+
+  bool Contains(char c) const {
+    return memchr(wanted_.data(), c, size_) != nullptr;
+  }
+
+  // Returns a 16-bit mask with bit `i` set if the membership of `p[i]` in the
+  // set equals `kInSet`.
+  template <bool kInSet>
+  uint32_t Mask(const char* p) const {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits = _mm_cmpeq_epi8(block, splat_[0]);
+    for (size_t i = 1; i < size_; ++i) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, splat_[i]));
+    }
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+    return kInSet ? mask : mask ^ 0xFFFFu;
+  }
+
+  string_view wanted_;
+  size_t size_;
+  __m128i splat_[kMaxSize];
+};
+
+constexpr size_t SmallCharSet::kMaxSize;
+constexpr size_t SmallCharSet::kBlock;
+
+#endif  // __SSE2__
+
 }  // namespace
 
 std::ostream& operator<<(std::ostream& o, string_view piece) {
@@ -140,6 +247,11 @@ string_view::size_type string_view::find_first_of(string_view s,
   }
   // Avoid the cost of LookupTable() for a single-character search.
   if (s.length_ == 1) return find_first_of(s.ptr_[0], pos);
+#ifdef __SSE2__
+  if (s.length_ <= SmallCharSet::kMaxSize) {
+    return SmallCharSet(s).FindFirst<true>(ptr_, pos, length_);
+  }
+#endif
   LookupTable tbl(s);
   for (size_type i = pos; i < length_; ++i) {
     if (tbl[ptr_[i]]) {
@@ -155,6 +267,11 @@ string_view::size_type string_view::find_first_not_of(string_view s,
   if (empty()) return npos;
   // Avoid the cost of LookupTable() for a single-character search.
   if (s.length_ == 1) return find_first_not_of(s.ptr_[0], pos);
+#ifdef __SSE2__
+  if (s.length_ > 0 && s.length_ <= SmallCharSet::kMaxSize) {
+    return SmallCharSet(s).FindFirst<false>(ptr_, pos, length_);
+  }
+#endif
   LookupTable tbl(s);
   for (size_type i = pos; i < length_; ++i) {
     if (!tbl[ptr_[i]]) {
@@ -181,6 +298,12 @@ string_view::size_type string_view::find_last_of(string_view s,
   if (empty() || s.empty()) return npos;
   // Avoid the cost of LookupTable() for a single-character search.
   if (s.length_ == 1) return find_last_of(s.ptr_[0], pos);
+#ifdef __SSE2__
+  if (s.length_ <= SmallCharSet::kMaxSize) {
+    return SmallCharSet(s).FindLast<true>(ptr_,
+                                          std::min(pos, length_ - 1) + 1);
+  }
+#endif
   LookupTable tbl(s);
   for (size_type i = std::min(pos, length_ - 1);; --i) {
     if (tbl[ptr_[i]]) {
@@ -199,6 +322,11 @@ string_view::size_type string_view::find_last_not_of(string_view s,
   if (s.empty()) return i;
   // Avoid the cost of LookupTable() for a single-character search.
   if (s.length_ == 1) return find_last_not_of(s.ptr_[0], pos);
+#ifdef __SSE2__
+  if (s.length_ <= SmallCharSet::kMaxSize) {
+    return SmallCharSet(s).FindLast<false>(ptr_, i + 1);
+  }
+#endif
   LookupTable tbl(s);
   for (;; --i) {
     if (!tbl[ptr_[i]]) {
@@ -211,7 +211,72 @@ void BM_find_first_of_long(benchmark::State& state) {
 
 BENCHMARK(BM_find_first_of_short)->DenseRange(0, 4)->Arg(8)->Arg(16)->Arg(32);
 BENCHMARK(BM_find_first_of_medium)->DenseRange(0, 4)->Arg(8)->Arg(16)->Arg(32);
-BENCHMARK(BM_find_first_of_long)->DenseRange(0, 4)->Arg(8)->Arg(16)->Arg(32);
+BENCHMARK(BM_find_first_of_long)
+    ->DenseRange(0, 4)
+    ->Arg(8)
+    ->Arg(9)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
+// Worst cases for the remaining find_.*_of methods over a 1000-byte haystack,
+// with character sets of state.range(0) bytes. Small sets are scanned a block
+// at a time on SSE2 targets; larger sets use a lookup table.
+std::string MakeCharSet(int size) {
+  std::string set;
+  for (int i = 0; i < size; ++i) {
+    set += static_cast<char>('a' + i);
+  }
+  return set;
+}
+
+void BM_find_first_not_of(benchmark::State& state) {
+  const std::string needle = MakeCharSet(state.range(0));
+  const std::string haystack(1000, 'a');
+  absl::string_view s(haystack);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(s.find_first_not_of(needle));
+  }
+}
+BENCHMARK(BM_find_first_not_of)
+    ->DenseRange(1, 4)
+    ->Arg(8)
+    ->Arg(9)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
+void BM_find_last_of(benchmark::State& state) {
+  const std::string needle = MakeCharSet(state.range(0));
+  const std::string haystack(1000, '0');
+  absl::string_view s(haystack);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(s.find_last_of(needle));
+  }
+}
+BENCHMARK(BM_find_last_of)
+    ->DenseRange(1, 4)
+    ->Arg(8)
+    ->Arg(9)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
+void BM_find_last_not_of(benchmark::State& state) {
+  const std::string needle = MakeCharSet(state.range(0));
+  const std::string haystack(1000, 'a');
+  absl::string_view s(haystack);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(s.find_last_not_of(needle));
+  }
+}
+BENCHMARK(BM_find_last_not_of)
+    ->DenseRange(1, 4)
+    ->Arg(8)
+    ->Arg(9)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
 
 struct EasyMap : public std::map<absl::string_view, uint64_t> {
   explicit EasyMap(size_t) {}
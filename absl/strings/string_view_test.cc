@@ -750,6 +750,40 @@ TEST(StringViewTest, FindConformance) {
   }
 }
 
+// The find_.*_of methods take a block-at-a-time path for small character sets,
+// so exercise haystacks spanning several blocks, matches at every offset and
+// sets on either side of the small-set threshold.
+TEST(StringViewTest, FindOfConformanceAcrossBlocks) {
+  const std::string alphabet = "abcdefghijklmnopqrstuvwxyz\x80\xff";
+  uint32_t seed = 1;
+  auto next = [&seed]() { return (seed = seed * 1103515245 + 12345) >> 16; };
+  for (size_t set_size = 2; set_size <= 20; ++set_size) {
+    const std::string needle = alphabet.substr(0, set_size);
+    for (size_t len = 0; len <= 70; ++len) {
+      std::string st(len, 'z');
+      // Sprinkle a few needle characters into the haystack.
+      for (size_t n = 0; n < len / 16; ++n) {
+        st[next() % len] = needle[next() % set_size];
+      }
+      const absl::string_view sp = st;
+      SCOPED_TRACE(set_size);
+      SCOPED_TRACE(len);
+      for (size_t pos = 0; pos <= len + 1; ++pos) {
+        EXPECT_EQ(sp.find_first_of(needle, pos), st.find_first_of(needle, pos));
+        EXPECT_EQ(sp.find_last_of(needle, pos), st.find_last_of(needle, pos));
+      }
+      // Flip the haystack so that needle characters are the common case.
+      for (char& c : st) c = (c == 'z') ? needle[next() % set_size] : 'z';
+      for (size_t pos = 0; pos <= len + 1; ++pos) {
+        EXPECT_EQ(sp.find_first_not_of(needle, pos),
+                  st.find_first_not_of(needle, pos));
+        EXPECT_EQ(sp.find_last_not_of(needle, pos),
+                  st.find_last_not_of(needle, pos));
+      }
+    }
+  }
+}
+
 TEST(StringViewTest, Remove) {
   absl::string_view a("foobar");
   std::string s1("123");
@@ -12,39 +12,148 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// The threads are divided among the leaves of a tree whose nodes each count
+// the arrivals of at most kFanIn threads or children. A thread claims a place
+// at a leaf, and the thread that completes a node goes on to arrive at its
+// parent; the others wait on the node's event. The thread that completes the
+// root has seen every arrival. Each thread, once it has completed the root or
+// been released from a node, releases the nodes it completed below, from the
+// top down, so wakeups fan out through the tree instead of all being issued
+// by one thread.
+
 #include "absl/synchronization/barrier.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
 #include "absl/base/internal/raw_logging.h"
-#include "absl/synchronization/mutex.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
 
 namespace absl {
 
-// Return whether int *arg is zero.
-static bool IsZero(void *arg) {
-  return 0 == *reinterpret_cast<int *>(arg);
+struct Barrier::Node {
+  synchronization_internal::OneShotEvent released;
+  std::atomic<int> arrived;  // may exceed capacity at a leaf; see Arrive()
+  int capacity;              // the number of arrivals that complete the node
+  int parent;                // index of the parent in nodes_, or -1
+  char padding[ABSL_CACHELINE_SIZE -
+               sizeof(synchronization_internal::OneShotEvent) -
+               sizeof(std::atomic<int>) - 2 * sizeof(int)];
+};
+
+namespace {
+
+// The number of threads or children that share a node. Small enough that a
+// node's counter is not contended, large enough to keep the tree shallow.
+constexpr int kFanIn = 4;
+
+// More than the height of the tree for any number of threads.
+constexpr int kMaxHeight = 32;
+
+}  // namespace
+
+Barrier::Barrier(int num_threads)
+    : num_threads_(num_threads), num_to_exit_(num_threads) {
+  const int n = num_threads > 0 ? num_threads : 0;
+  num_leaves_ = n > kFanIn ? (n + kFanIn - 1) / kFanIn : 1;
+  int num_nodes = 0;
+  for (int width = num_leaves_;; width = (width + kFanIn - 1) / kFanIn) {
+    num_nodes += width;
+    if (width == 1) break;
+  }
+
+  nodes_storage_ = new char[(num_nodes + 1) * ABSL_CACHELINE_SIZE];
+  uintptr_t p = reinterpret_cast<uintptr_t>(nodes_storage_);
+  p = (p + ABSL_CACHELINE_SIZE - 1) & ~uintptr_t{ABSL_CACHELINE_SIZE - 1};
+  nodes_ = reinterpret_cast<Node*>(p);
+
+  // The threads are spread evenly over the leaves, and each level above has
+  // one node per kFanIn nodes of the level below.
+  for (int i = 0; i != num_leaves_; i++) {
+    Node* leaf = new (&nodes_[i]) Node;
+    leaf->capacity = n / num_leaves_ + (i < n % num_leaves_ ? 1 : 0);
+  }
+  int level = 0;
+  int width = num_leaves_;
+  while (width != 1) {
+    const int next_level = level + width;
+    const int next_width = (width + kFanIn - 1) / kFanIn;
+    for (int i = 0; i != next_width; i++) {
+      Node* node = new (&nodes_[next_level + i]) Node;
+      node->capacity = std::min(kFanIn, width - i * kFanIn);
+    }
+    for (int i = 0; i != width; i++) {
+      nodes_[level + i].parent = next_level + i / kFanIn;
+    }
+    level = next_level;
+    width = next_width;
+  }
+  nodes_[level].parent = -1;
+  for (int i = 0; i != num_nodes; i++) {
+    nodes_[i].arrived.store(0, std::memory_order_relaxed);
+  }
 }
 
-bool Barrier::Block() {
-  MutexLock l(&this->lock_);
-
-  this->num_to_block_--;
-  if (this->num_to_block_ < 0) {
-    ABSL_RAW_LOG(
-        FATAL,
-        "Block() called too many times.  num_to_block_=%d out of total=%d",
-        this->num_to_block_, this->num_to_exit_);
+Barrier::~Barrier() {
+  // Node is trivially destructible.
+  delete[] nodes_storage_;
+}
+
+Barrier::Node* Barrier::Arrive(bool* last) {
+  // Start at a leaf chosen by thread, so that threads arriving together
+  // mostly use different leaves, and move on from leaves that are full.
+  const base_internal::ThreadIdentity* identity =
+      synchronization_internal::GetOrCreateCurrentThreadIdentity();
+  const uint64_t h = static_cast<uint64_t>(
+                         reinterpret_cast<uintptr_t>(identity)) *
+                     uint64_t{0x9E3779B97F4A7C15};
+  const int start = static_cast<int>((h >> 32) % num_leaves_);
+  for (int i = 0; i != num_leaves_; i++) {
+    int index = start + i;
+    if (index >= num_leaves_) index -= num_leaves_;
+    Node* leaf = &nodes_[index];
+    if (leaf->arrived.load(std::memory_order_relaxed) >= leaf->capacity) {
+      continue;
+    }
+    // Arrivals beyond the capacity of the leaf, by threads that raced for its
+    // last place, are not counted and do not affect which arrival was last.
+    const int prev = leaf->arrived.fetch_add(1, std::memory_order_acq_rel);
+    if (prev < leaf->capacity) {
+      *last = prev == leaf->capacity - 1;
+      return leaf;
+    }
   }
+  ABSL_RAW_LOG(FATAL, "Block() called too many times.  num_threads=%d",
+               num_threads_);
+  return nullptr;
+}
 
-  this->lock_.Await(Condition(IsZero, &this->num_to_block_));
+bool Barrier::Block() {
+  Node* completed[kMaxHeight];
+  int num_completed = 0;
+
+  bool last;
+  Node* node = Arrive(&last);
+  while (last) {
+    completed[num_completed++] = node;
+    if (node->parent < 0) break;
+    node = &nodes_[node->parent];
+    last = node->arrived.fetch_add(1, std::memory_order_acq_rel) ==
+           node->capacity - 1;
+  }
+  if (!last) node->released.Wait();
 
-  // Determine which thread can safely delete this Barrier object
-  this->num_to_exit_--;
-  ABSL_RAW_CHECK(this->num_to_exit_ >= 0, "barrier underflow");
+  while (num_completed != 0) completed[--num_completed]->released.Set();
 
-  // If num_to_exit_ == 0 then all other threads in the barrier have
-  // exited the Wait() and have released the Mutex so this thread is
-  // free to delete the barrier.
-  return this->num_to_exit_ == 0;
+  // Determine which thread can safely delete this Barrier object: the last
+  // one to exit, once every other thread has released the nodes it
+  // completed and will not touch the barrier again.
+  const int num_to_exit = num_to_exit_.fetch_sub(1, std::memory_order_acq_rel);
+  ABSL_RAW_CHECK(num_to_exit > 0, "barrier underflow");
+  return num_to_exit == 1;
 }
 
 }  // namespace absl
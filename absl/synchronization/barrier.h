@@ -19,8 +19,9 @@
 #ifndef ABSL_SYNCHRONIZATION_BARRIER_H_
 #define ABSL_SYNCHRONIZATION_BARRIER_H_
 
-#include "absl/base/thread_annotations.h"
-#include "absl/synchronization/mutex.h"
+#include <atomic>
+
+#include "absl/synchronization/internal/one_shot_event.h"
 
 namespace absl {
 
@@ -46,15 +47,22 @@ namespace absl {
 //   if (barrier->Block()) delete barrier;  // Exactly one call to `Block()`
 //                                          // returns `true`; that call
 //                                          // deletes the barrier.
+//
+// Arrivals are combined in a tree of counters, each shared by a few threads,
+// rather than counted by a single lock, and released threads wake the threads
+// that arrived below them in the tree. Threads spin briefly before they sleep,
+// so a barrier shared by many threads releases them all within a few
+// microseconds of the last arrival.
 class Barrier {
  public:
   // `num_threads` is the number of threads that will participate in the barrier
-  explicit Barrier(int num_threads)
-      : num_to_block_(num_threads), num_to_exit_(num_threads) {}
+  explicit Barrier(int num_threads);
 
   Barrier(const Barrier&) = delete;
   Barrier& operator=(const Barrier&) = delete;
 
+  ~Barrier();
+
   // Barrier::Block()
   //
   // Blocks the current thread, and returns only when the `num_threads`
@@ -68,9 +76,17 @@ class Barrier {
   bool Block();
 
  private:
-  Mutex lock_;
-  int num_to_block_ GUARDED_BY(lock_);
-  int num_to_exit_ GUARDED_BY(lock_);
+  struct Node;
+
+  // Claims a place at a leaf for the calling thread and returns the leaf,
+  // setting `*last` if the thread completed it.
+  Node* Arrive(bool* last);
+
+  const int num_threads_;
+  int num_leaves_;
+  char* nodes_storage_;  // the allocation that holds nodes_
+  Node* nodes_;          // the tree, leaves first and the root last
+  std::atomic<int> num_to_exit_;
 };
 
 }  // namespace absl
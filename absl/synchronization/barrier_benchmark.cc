@@ -0,0 +1,98 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <limits>
+
+#include "benchmark/benchmark.h"
+#include "absl/synchronization/barrier.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+
+namespace {
+
+// A barrier that counts arrivals under one Mutex, for comparison.
+class MutexBarrier {
+ public:
+  explicit MutexBarrier(int num_threads)
+      : num_to_block_(num_threads), num_to_exit_(num_threads) {}
+
+  bool Block() {
+    absl::MutexLock l(&lock_);
+    num_to_block_--;
+    lock_.Await(absl::Condition(
+        +[](int* n) { return *n == 0; }, &num_to_block_));
+    num_to_exit_--;
+    return num_to_exit_ == 0;
+  }
+
+ private:
+  absl::Mutex lock_;
+  int num_to_block_ GUARDED_BY(lock_);
+  int num_to_exit_ GUARDED_BY(lock_);
+};
+
+// Each iteration is one phase in which every thread blocks on a barrier.
+//
+// Barriers can be used only once, so the phases cycle through kRing of them.
+// The thread that leaves the barrier of phase `i` last replaces the one of
+// phase `i + 2`, which every thread left before arriving at phase `i`, and
+// which no thread can reach before this one has arrived at phase `i + 1`.
+template <typename BarrierType>
+void BM_Barrier(benchmark::State& state) {
+  constexpr int kRing = 4;
+  static BarrierType* barriers[kRing];
+  if (state.thread_index == 0) {
+    for (BarrierType*& b : barriers) b = new BarrierType(state.threads);
+  }
+  int phase = 0;
+  for (auto _ : state) {
+    if (barriers[phase % kRing]->Block()) {
+      BarrierType*& next = barriers[(phase + 2) % kRing];
+      delete next;
+      next = new BarrierType(state.threads);
+    }
+    phase++;
+  }
+  if (state.thread_index == 0) {
+    for (BarrierType*& b : barriers) {
+      delete b;
+      b = nullptr;
+    }
+  }
+}
+
+void SetUpBarrier(benchmark::internal::Benchmark* bm) {
+  bm->ThreadRange(2, 256);
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_Barrier, MutexBarrier)->Apply(SetUpBarrier);
+BENCHMARK_TEMPLATE(BM_Barrier, absl::Barrier)->Apply(SetUpBarrier);
+
+// Measures DecrementCount() on a counter shared by all threads.
+void BM_BlockingCounterDecrement(benchmark::State& state) {
+  static absl::BlockingCounter* counter;
+  if (state.thread_index == 0) {
+    counter = new absl::BlockingCounter(std::numeric_limits<int>::max());
+  }
+  for (auto _ : state) {
+    counter->DecrementCount();
+  }
+  if (state.thread_index == 0) {
+    delete counter;
+  }
+}
+BENCHMARK(BM_BlockingCounterDecrement)->Apply(SetUpBarrier);
+
+}  // namespace
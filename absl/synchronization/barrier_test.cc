@@ -14,6 +14,7 @@
 
 #include "absl/synchronization/barrier.h"
 
+#include <atomic>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
@@ -73,3 +74,32 @@ TEST(Barrier, SanityTest) {
   absl::MutexLock lock(&mutex);
   EXPECT_EQ(counter, kNumThreads);
 }
+
+TEST(Barrier, ManyThreads) {
+  for (int num_threads : {1, 2, 5, 17, 64, 100}) {
+    absl::Barrier* barrier = new absl::Barrier(num_threads);
+    std::atomic<int> arrived(0);
+    std::atomic<int> num_true(0);
+    std::atomic<int> left_early(0);
+
+    auto thread_func = [&] {
+      arrived.fetch_add(1);
+      if (barrier->Block()) {
+        num_true.fetch_add(1);
+        delete barrier;
+      }
+      if (arrived.load() != num_threads) left_early.fetch_add(1);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.push_back(std::thread(thread_func));
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    EXPECT_EQ(num_true.load(), 1) << num_threads;
+    EXPECT_EQ(left_early.load(), 0) << num_threads;
+  }
+}
@@ -12,42 +12,121 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+// The count is divided among shards. A thread decrements the shard chosen by
+// its identity, or, if that shard has reached zero, the next one that has
+// not. The decrement that brings a shard to zero also decrements
+// shards_remaining_, and the one that brings that to zero brings the count to
+// zero.
+
 #include "absl/synchronization/blocking_counter.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
 #include "absl/base/internal/raw_logging.h"
+#include "absl/base/internal/sysinfo.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
 
 namespace absl {
 
-// Return whether int *arg is zero.
-static bool IsZero(void *arg) {
-  return 0 == *reinterpret_cast<int *>(arg);
+struct BlockingCounter::Shard {
+  std::atomic<int> count;  // may go below zero; see DecrementCount()
+  char padding[ABSL_CACHELINE_SIZE - sizeof(std::atomic<int>)];
+};
+
+namespace {
+
+// Beyond this many shards, a thread whose own shard has reached zero takes
+// too long to find one that has not.
+constexpr int kMaxShards = 64;
+
+// Each shard starts with at least this much of the count, so that small
+// counters are not spread thinly over many cache lines.
+constexpr int kMinCountPerShard = 4;
+
+// Returns the number of shards for a counter starting at `initial_count`: up
+// to one per CPU, at most kMaxShards.
+int NumShards(int initial_count) {
+  static const int max_shards =
+      std::min(kMaxShards, std::max(1, base_internal::NumCPUs()));
+  return std::max(1, std::min(max_shards, initial_count / kMinCountPerShard));
+}
+
+}  // namespace
+
+BlockingCounter::BlockingCounter(int initial_count)
+    : initial_count_(initial_count),
+      num_shards_(NumShards(initial_count)),
+      num_waiting_(0) {
+  shards_storage_ = new char[(num_shards_ + 1) * ABSL_CACHELINE_SIZE];
+  uintptr_t p = reinterpret_cast<uintptr_t>(shards_storage_);
+  p = (p + ABSL_CACHELINE_SIZE - 1) & ~uintptr_t{ABSL_CACHELINE_SIZE - 1};
+  shards_ = reinterpret_cast<Shard*>(p);
+  const int count = initial_count > 0 ? initial_count : 0;
+  for (int i = 0; i != num_shards_; i++) {
+    new (&shards_[i]) Shard;
+    shards_[i].count.store(
+        count / num_shards_ + (i < count % num_shards_ ? 1 : 0),
+        std::memory_order_relaxed);
+  }
+  // Shards that start at zero are never brought to zero.
+  shards_remaining_.store(std::min(count, num_shards_),
+                          std::memory_order_relaxed);
+  if (count == 0) done_.Set();
+}
+
+BlockingCounter::~BlockingCounter() {
+  // Shard is trivially destructible.
+  delete[] shards_storage_;
 }
 
 bool BlockingCounter::DecrementCount() {
-  MutexLock l(&lock_);
-  count_--;
-  if (count_ < 0) {
-    ABSL_RAW_LOG(
-        FATAL,
-        "BlockingCounter::DecrementCount() called too many times.  count=%d",
-        count_);
+  const base_internal::ThreadIdentity* identity =
+      synchronization_internal::GetOrCreateCurrentThreadIdentity();
+  const uint64_t h = static_cast<uint64_t>(
+                         reinterpret_cast<uintptr_t>(identity)) *
+                     uint64_t{0x9E3779B97F4A7C15};
+  const int start = static_cast<int>((h >> 32) % num_shards_);
+  for (int i = 0; i != num_shards_; i++) {
+    int index = start + i;
+    if (index >= num_shards_) index -= num_shards_;
+    Shard* shard = &shards_[index];
+    if (shard->count.load(std::memory_order_relaxed) <= 0) continue;
+    // Decrements that find the shard already at zero, because they raced
+    // for its last unit, are not counted and move on to the next shard.
+    const int prev = shard->count.fetch_sub(1, std::memory_order_acq_rel);
+    if (prev <= 0) continue;
+    if (prev != 1 ||
+        shards_remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+      return false;
+    }
+    // Once done_ is set, the waiter may destroy this object.
+    done_.Set();
+    return true;
   }
-  return count_ == 0;
+  ABSL_RAW_LOG(FATAL,
+               "BlockingCounter::DecrementCount() called too many times.  "
+               "initial_count=%d",
+               initial_count_);
+  return false;
 }
 
 void BlockingCounter::Wait() {
-  MutexLock l(&this->lock_);
-  ABSL_RAW_CHECK(count_ >= 0, "BlockingCounter underflow");
+  ABSL_RAW_CHECK(initial_count_ >= 0, "BlockingCounter underflow");
 
   // only one thread may call Wait(). To support more than one thread,
   // implement a counter num_to_exit, like in the Barrier class.
-  ABSL_RAW_CHECK(num_waiting_ == 0, "multiple threads called Wait()");
-  num_waiting_++;
+  const int num_waiting = num_waiting_.fetch_add(1, std::memory_order_relaxed);
+  ABSL_RAW_CHECK(num_waiting == 0, "multiple threads called Wait()");
 
-  this->lock_.Await(Condition(IsZero, &this->count_));
+  done_.Wait();
 
-  // At this point, We know that all threads executing DecrementCount have
-  // released the lock, and so will not touch this object again.
+  // At this point, we know that every call to DecrementCount has been
+  // counted, and that no thread touches this object once its call has been
+  // counted, except to set done_, which has now been done.
   // Therefore, the thread calling this method is free to delete the object
   // after we return from this method.
 }
@@ -20,8 +20,9 @@
 #ifndef ABSL_SYNCHRONIZATION_BLOCKING_COUNTER_H_
 #define ABSL_SYNCHRONIZATION_BLOCKING_COUNTER_H_
 
-#include "absl/base/thread_annotations.h"
-#include "absl/synchronization/mutex.h"
+#include <atomic>
+
+#include "absl/synchronization/internal/one_shot_event.h"
 
 namespace absl {
 
@@ -57,14 +58,19 @@ namespace absl {
 //
 //     bcount.Wait();                    // wait for all work to be complete
 //
+// The count is split into shards on separate cache lines, and each thread
+// decrements a shard chosen by thread, so that many threads can decrement
+// the counter at once without contending for one location. The waiter spins
+// briefly before it sleeps.
 class BlockingCounter {
  public:
-  explicit BlockingCounter(int initial_count)
-      : count_(initial_count), num_waiting_(0) {}
+  explicit BlockingCounter(int initial_count);
 
   BlockingCounter(const BlockingCounter&) = delete;
   BlockingCounter& operator=(const BlockingCounter&) = delete;
 
+  ~BlockingCounter();
+
   // BlockingCounter::DecrementCount()
   //
   // Decrements the counter's "count" by one, and return "count == 0". This
@@ -87,9 +93,15 @@ class BlockingCounter {
   void Wait();
 
  private:
-  Mutex lock_;
-  int count_ GUARDED_BY(lock_);
-  int num_waiting_ GUARDED_BY(lock_);
+  struct Shard;
+
+  const int initial_count_;
+  int num_shards_;
+  char* shards_storage_;  // the allocation that holds shards_
+  Shard* shards_;
+  std::atomic<int> shards_remaining_;  // shards whose count is not yet zero
+  std::atomic<int> num_waiting_;
+  synchronization_internal::OneShotEvent done_;  // set once the count is zero
 };
 
 }  // namespace absl
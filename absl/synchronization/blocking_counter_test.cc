@@ -14,6 +14,7 @@
 
 #include "absl/synchronization/blocking_counter.h"
 
+#include <atomic>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
@@ -62,5 +63,41 @@ TEST(BlockingCounterTest, BasicFunctionality) {
   }
 }
 
+TEST(BlockingCounterTest, ManyDecrementsFromManyThreads) {
+  const int num_workers = 16;
+  const int decrements_per_worker = 10000;
+  BlockingCounter counter(num_workers * decrements_per_worker);
+
+  std::atomic<int> num_true(0);
+  std::vector<int> done(num_workers, 0);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (int k = 0; k < num_workers; k++) {
+    workers.emplace_back([&counter, &num_true, &done, k] {
+      for (int i = 0; i < decrements_per_worker; i++) {
+        done[k]++;
+        if (counter.DecrementCount()) num_true.fetch_add(1);
+      }
+    });
+  }
+
+  counter.Wait();
+
+  // Every decrement happened before Wait() returned.
+  for (int k = 0; k < num_workers; k++) {
+    EXPECT_EQ(decrements_per_worker, done[k]);
+  }
+
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  EXPECT_EQ(1, num_true.load());
+}
+
+TEST(BlockingCounterTest, WaitForZeroCountReturns) {
+  BlockingCounter counter(0);
+  counter.Wait();
+}
+
 }  // namespace
 }  // namespace absl
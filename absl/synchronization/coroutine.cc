@@ -0,0 +1,87 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/coroutine.h"
+
+#ifdef ABSL_HAVE_COROUTINES
+
+namespace absl {
+
+void Spawn(CoroutineExecutor* executor, Task<void> task) {
+  auto run = [](Task<void> t) -> coroutine_internal::Detached {
+    co_await std::move(t);
+  };
+  coroutine_internal::Detached d = run(std::move(task));
+  d.handle.promise().executor = executor;
+  executor->Resume(d.handle);
+}
+
+namespace coroutine_internal {
+
+bool NotificationAwaiter::Suspend() {
+  waiter_.wake = &NotificationAwaiter::WakeWaiter;
+  waiter_.arg = this;
+  // Once added, this awaiter may be woken, and its coroutine resumed and
+  // destroyed, at any time; do not touch it afterwards.
+  return notification_.AddAsyncWaiter(&waiter_);
+}
+
+void NotificationAwaiter::WakeWaiter(void* arg) {
+  NotificationAwaiter* self = static_cast<NotificationAwaiter*>(arg);
+  Wake(self->handle_, self->executor_);
+}
+
+}  // namespace coroutine_internal
+
+bool AsyncMutex::TryLock() {
+  MutexLock l(&mu_);
+  if (locked_) return false;
+  locked_ = true;
+  return true;
+}
+
+bool AsyncMutex::LockOrEnqueue(Waiter* w) {
+  MutexLock l(&mu_);
+  if (!locked_) {
+    locked_ = true;
+    return true;
+  }
+  if (tail_ == nullptr) {
+    head_ = w;
+  } else {
+    tail_->next = w;
+  }
+  tail_ = w;
+  return false;
+}
+
+void AsyncMutex::Unlock() {
+  Waiter* w;
+  {
+    MutexLock l(&mu_);
+    w = head_;
+    if (w == nullptr) {
+      locked_ = false;
+      return;
+    }
+    // Hand the lock to `w`, leaving locked_ set.
+    head_ = w->next;
+    if (head_ == nullptr) tail_ = nullptr;
+  }
+  coroutine_internal::Wake(w->handle, w->executor);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_HAVE_COROUTINES
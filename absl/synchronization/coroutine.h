@@ -0,0 +1,416 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// coroutine.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines C++20 coroutine support: `absl::Task<T>`, a lazily
+// started coroutine that produces a `T`, and synchronization that suspends a
+// coroutine instead of blocking its thread:
+//
+//   * `co_await notification` waits for an `absl::Notification`;
+//   * `co_await mu.LockAsync()` acquires an `absl::AsyncMutex`.
+//
+// While suspended, a coroutine occupies no thread, so one thread can serve
+// many waiting coroutines:
+//
+//   absl::Task<Response> HandleRequest(Request req) {
+//     co_await cache_mu.LockAsync();
+//     Response r = LookUp(req);
+//     cache_mu.Unlock();
+//     co_return r;
+//   }
+//
+// A coroutine that is woken by another thread resumes on the
+// `absl::CoroutineExecutor` it was started on by `absl::Spawn()`, or, if it has
+// none, in the waking thread. `absl::SyncWait()` runs a task to completion
+// from ordinary code.
+//
+// Everything in this header is only defined if `ABSL_HAVE_COROUTINES` is.
+
+#ifndef ABSL_SYNCHRONIZATION_COROUTINE_H_
+#define ABSL_SYNCHRONIZATION_COROUTINE_H_
+
+#include "absl/base/config.h"
+
+#ifdef ABSL_HAVE_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+
+namespace absl {
+
+// CoroutineExecutor
+//
+// Where coroutines woken by other threads are resumed.
+class CoroutineExecutor {
+ public:
+  // Arranges for `h.resume()` to be called, usually on another thread.
+  virtual void Resume(std::coroutine_handle<> h) = 0;
+
+ protected:
+  ~CoroutineExecutor() = default;
+};
+
+// CoroutineExecutorAdapter
+//
+// A `CoroutineExecutor` that resumes coroutines on an executor with a
+// `Schedule(Callable)` method, such as `absl::ThreadPool`:
+//
+//   absl::ThreadPool pool(8);
+//   absl::CoroutineExecutorAdapter<absl::ThreadPool> executor(&pool);
+//   absl::Spawn(&executor, HandleRequest(req));
+template <typename Executor>
+class CoroutineExecutorAdapter final : public CoroutineExecutor {
+ public:
+  explicit CoroutineExecutorAdapter(Executor* executor)
+      : executor_(executor) {}
+
+  void Resume(std::coroutine_handle<> h) override {
+    executor_->Schedule([h] { h.resume(); });
+  }
+
+ private:
+  Executor* const executor_;
+};
+
+template <typename T = void>
+class Task;
+
+namespace coroutine_internal {
+
+// State common to the promises of all coroutine types in this file.
+struct PromiseBase {
+  // The executor that this coroutine resumes on after being woken by another
+  // thread, or null to resume in that thread.
+  CoroutineExecutor* executor = nullptr;
+  // The coroutine to resume when this one finishes, if any.
+  std::coroutine_handle<> continuation;
+};
+
+// Returns the executor of the coroutine `h`, which need not be one of ours.
+template <typename P>
+CoroutineExecutor* ExecutorOf(std::coroutine_handle<P> h) {
+  if constexpr (std::is_base_of_v<PromiseBase, P>) {
+    return h.promise().executor;
+  } else {
+    return nullptr;
+  }
+}
+
+// Resumes a coroutine that was woken by the calling thread.
+inline void Wake(std::coroutine_handle<> h, CoroutineExecutor* executor) {
+  if (executor != nullptr) {
+    executor->Resume(h);
+  } else {
+    h.resume();
+  }
+}
+
+// Transfers control to the continuation of a finished task.
+struct FinalAwaiter {
+  bool await_ready() const noexcept { return false; }
+
+  template <typename P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+    std::coroutine_handle<> c = h.promise().continuation;
+    return c ? c : std::noop_coroutine();
+  }
+
+  void await_resume() const noexcept {}
+};
+
+template <typename T>
+class TaskPromise : public PromiseBase {
+ public:
+  Task<T> get_return_object() noexcept;
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const noexcept { std::terminate(); }
+
+  template <typename U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T TakeValue() { return std::move(*value_); }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public PromiseBase {
+ public:
+  Task<void> get_return_object() noexcept;
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() const noexcept { std::terminate(); }
+  void return_void() const noexcept {}
+  void TakeValue() const noexcept {}
+};
+
+// A coroutine that is started explicitly and destroys itself when it
+// finishes. Used to run tasks from ordinary code.
+struct Detached {
+  struct promise_type : PromiseBase {
+    Detached get_return_object() noexcept {
+      return Detached{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void unhandled_exception() const noexcept { std::terminate(); }
+    void return_void() const noexcept {}
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+// The awaiter of `co_await notification`.
+class NotificationAwaiter {
+ public:
+  explicit NotificationAwaiter(const Notification& n) : notification_(n) {}
+
+  bool await_ready() const { return notification_.HasBeenNotified(); }
+
+  template <typename P>
+  bool await_suspend(std::coroutine_handle<P> h) {
+    handle_ = h;
+    executor_ = ExecutorOf(h);
+    return Suspend();
+  }
+
+  void await_resume() const noexcept {}
+
+ private:
+  // Returns false if the notification has already been notified.
+  bool Suspend();
+
+  static void WakeWaiter(void* arg);
+
+  const Notification& notification_;
+  std::coroutine_handle<> handle_;
+  CoroutineExecutor* executor_ = nullptr;
+  Notification::AsyncWaiter waiter_;
+};
+
+// The awaiter of `co_await std::move(task)`, which starts the task and resumes
+// the awaiting coroutine when it finishes.
+template <typename T>
+class TaskAwaiter {
+ public:
+  explicit TaskAwaiter(std::coroutine_handle<TaskPromise<T>> h) : handle_(h) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  template <typename P>
+  std::coroutine_handle<> await_suspend(
+      std::coroutine_handle<P> caller) noexcept {
+    handle_.promise().continuation = caller;
+    handle_.promise().executor = ExecutorOf(caller);
+    return handle_;
+  }
+
+  T await_resume() { return handle_.promise().TakeValue(); }
+
+ private:
+  std::coroutine_handle<TaskPromise<T>> handle_;
+};
+
+class LockAwaiter;
+
+}  // namespace coroutine_internal
+
+// Task
+//
+// The return type of a coroutine that produces a `T`. A task does not start
+// until it is awaited, and a task is awaited at most once, by `co_await
+// std::move(task)`; the awaiting coroutine resumes when the task finishes.
+// Tasks are movable but not copyable. Destroying a task that has not
+// finished destroys the coroutine.
+//
+// Exceptions thrown out of a task terminate the program.
+template <typename T>
+class Task {
+ public:
+  using promise_type = coroutine_internal::TaskPromise<T>;
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  coroutine_internal::TaskAwaiter<T> operator co_await() && noexcept {
+    return coroutine_internal::TaskAwaiter<T>(handle_);
+  }
+
+ private:
+  friend promise_type;
+
+  explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename T>
+Task<T> coroutine_internal::TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+inline Task<void>
+coroutine_internal::TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise>::from_promise(*this));
+}
+
+// Spawn()
+//
+// Starts `task` on `executor`, which must outlive it, without waiting for it
+// to finish. Whenever the task is woken by another thread, it resumes on
+// `executor`.
+void Spawn(CoroutineExecutor* executor, Task<void> task);
+
+// SyncWait()
+//
+// Runs `task` in the calling thread until it first suspends, blocks the
+// thread until the task finishes, and returns its result.
+template <typename T>
+T SyncWait(Task<T> task) {
+  Notification done;
+  if constexpr (std::is_void_v<T>) {
+    auto run = [](Task<void>& t,
+                  Notification& n) -> coroutine_internal::Detached {
+      co_await std::move(t);
+      n.Notify();
+    };
+    run(task, done).handle.resume();
+    done.WaitForNotification();
+  } else {
+    std::optional<T> result;
+    auto run = [](Task<T>& t, std::optional<T>& r,
+                  Notification& n) -> coroutine_internal::Detached {
+      r.emplace(co_await std::move(t));
+      n.Notify();
+    };
+    run(task, result, done).handle.resume();
+    done.WaitForNotification();
+    return std::move(*result);
+  }
+}
+
+// operator co_await(const Notification&)
+//
+// Suspends the calling coroutine until `n` has been notified.
+inline coroutine_internal::NotificationAwaiter operator co_await(
+    const Notification& n) {
+  return coroutine_internal::NotificationAwaiter(n);
+}
+
+// AsyncMutex
+//
+// A mutual exclusion lock for coroutines. Where `absl::Mutex::Lock()` blocks
+// the calling thread, `co_await mu.LockAsync()` suspends the calling coroutine
+// and queues it; `Unlock()` hands the lock directly to the first queued
+// coroutine and wakes it. Waiters acquire the lock in FIFO order.
+//
+// An `AsyncMutex` may be held across suspension points, and released by a
+// different thread than the one that acquired it. It is not reentrant.
+class LOCKABLE AsyncMutex {
+ public:
+  AsyncMutex() = default;
+  AsyncMutex(const AsyncMutex&) = delete;
+  AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+  // Returns an awaitable that acquires this mutex, suspending the awaiting
+  // coroutine while another holds it.
+  coroutine_internal::LockAwaiter LockAsync();
+
+  // Acquires this mutex and returns true if it is free, and otherwise
+  // returns false.
+  bool TryLock() EXCLUSIVE_TRYLOCK_FUNCTION(true);
+
+  // Releases this mutex, which must be held.
+  void Unlock() UNLOCK_FUNCTION();
+
+ private:
+  friend class coroutine_internal::LockAwaiter;
+
+  struct Waiter {
+    std::coroutine_handle<> handle;
+    CoroutineExecutor* executor;
+    Waiter* next;
+  };
+
+  // Acquires this mutex and returns true if it is free, and otherwise queues
+  // `w` and returns false.
+  bool LockOrEnqueue(Waiter* w);
+
+  Mutex mu_;
+  bool locked_ GUARDED_BY(mu_) = false;
+  Waiter* head_ GUARDED_BY(mu_) = nullptr;  // queued waiters, oldest first
+  Waiter* tail_ GUARDED_BY(mu_) = nullptr;
+};
+
+namespace coroutine_internal {
+
+// The awaiter of `co_await mu.LockAsync()`.
+class LockAwaiter {
+ public:
+  explicit LockAwaiter(AsyncMutex* mu) : mu_(mu) {}
+
+  bool await_ready() { return mu_->TryLock(); }
+
+  template <typename P>
+  bool await_suspend(std::coroutine_handle<P> h) {
+    waiter_.handle = h;
+    waiter_.executor = ExecutorOf(h);
+    waiter_.next = nullptr;
+    return !mu_->LockOrEnqueue(&waiter_);
+  }
+
+  void await_resume() const noexcept {}
+
+ private:
+  AsyncMutex* const mu_;
+  AsyncMutex::Waiter waiter_;
+};
+
+}  // namespace coroutine_internal
+
+inline coroutine_internal::LockAwaiter AsyncMutex::LockAsync() {
+  return coroutine_internal::LockAwaiter(this);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_HAVE_COROUTINES
+
+#endif  // ABSL_SYNCHRONIZATION_COROUTINE_H_
@@ -0,0 +1,176 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/coroutine.h"
+
+#include "gtest/gtest.h"
+
+#ifdef ABSL_HAVE_COROUTINES
+
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/thread_pool.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+
+// Resumes coroutines in the thread that wakes them.
+class InlineExecutor final : public absl::CoroutineExecutor {
+ public:
+  void Resume(std::coroutine_handle<> h) override { h.resume(); }
+};
+
+absl::Task<int> Add(int a, int b) { co_return a + b; }
+
+absl::Task<std::string> Describe(int a, int b) {
+  const int sum = co_await Add(a, b);
+  co_return std::to_string(a) + "+" + std::to_string(b) + "=" +
+      std::to_string(sum);
+}
+
+TEST(Task, SyncWait) {
+  EXPECT_EQ(absl::SyncWait(Add(1, 2)), 3);
+  EXPECT_EQ(absl::SyncWait(Describe(2, 3)), "2+3=5");
+}
+
+TEST(Task, NotStartedUntilAwaited) {
+  bool started = false;
+  auto make = [&started]() -> absl::Task<void> {
+    started = true;
+    co_return;
+  };
+  absl::Task<void> task = make();
+  EXPECT_FALSE(started);
+  absl::SyncWait(std::move(task));
+  EXPECT_TRUE(started);
+}
+
+absl::Task<void> WaitFor(const absl::Notification* n, std::thread::id* ran_in) {
+  co_await *n;
+  *ran_in = std::this_thread::get_id();
+}
+
+TEST(Task, AwaitNotificationSuspends) {
+  absl::Notification n;
+  std::thread::id ran_in;
+  InlineExecutor executor;
+  absl::Spawn(&executor, WaitFor(&n, &ran_in));
+  // The coroutine is suspended, so Spawn() returned without blocking.
+  EXPECT_EQ(ran_in, std::thread::id());
+
+  std::thread notifier([&n] { n.Notify(); });
+  const std::thread::id notifier_id = notifier.get_id();
+  notifier.join();
+  // Without an executor of its own, the coroutine resumes in the notifier.
+  EXPECT_EQ(ran_in, notifier_id);
+}
+
+TEST(Task, AwaitNotifiedNotification) {
+  absl::Notification n;
+  n.Notify();
+  std::thread::id ran_in;
+  absl::SyncWait(WaitFor(&n, &ran_in));
+  EXPECT_EQ(ran_in, std::this_thread::get_id());
+}
+
+TEST(Task, ManyWaitersOnOnePool) {
+  constexpr int kWaiters = 10000;
+  absl::ThreadPool pool(2);
+  absl::CoroutineExecutorAdapter<absl::ThreadPool> executor(&pool);
+  absl::Notification start;
+  std::atomic<int> woken(0);
+  absl::BlockingCounter done(kWaiters);
+  auto waiter = [](const absl::Notification* n, std::atomic<int>* woken,
+                   absl::BlockingCounter* done) -> absl::Task<void> {
+    co_await *n;
+    woken->fetch_add(1, std::memory_order_relaxed);
+    done->DecrementCount();
+  };
+  for (int i = 0; i < kWaiters; ++i) {
+    absl::Spawn(&executor, waiter(&start, &woken, &done));
+  }
+  // Far more coroutines are waiting than the pool has threads.
+  EXPECT_EQ(woken.load(), 0);
+  start.Notify();
+  done.Wait();
+  EXPECT_EQ(woken.load(), kWaiters);
+}
+
+TEST(AsyncMutex, TryLock) {
+  absl::AsyncMutex mu;
+  EXPECT_TRUE(mu.TryLock());
+  EXPECT_FALSE(mu.TryLock());
+  mu.Unlock();
+  EXPECT_TRUE(mu.TryLock());
+  mu.Unlock();
+}
+
+TEST(AsyncMutex, WaitersAcquireInOrder) {
+  absl::AsyncMutex mu;
+  InlineExecutor executor;
+  std::vector<int> order;
+  auto locker = [](absl::AsyncMutex* mu, std::vector<int>* order,
+                   int id) -> absl::Task<void> {
+    co_await mu->LockAsync();
+    order->push_back(id);
+    mu->Unlock();
+  };
+  ASSERT_TRUE(mu.TryLock());
+  for (int i = 0; i < 3; ++i) {
+    absl::Spawn(&executor, locker(&mu, &order, i));
+  }
+  EXPECT_TRUE(order.empty());
+  mu.Unlock();
+  EXPECT_THAT(order, ElementsAre(0, 1, 2));
+  EXPECT_TRUE(mu.TryLock());
+  mu.Unlock();
+}
+
+TEST(AsyncMutex, MutualExclusion) {
+  constexpr int kCoroutines = 100;
+  constexpr int kIterations = 100;
+  absl::ThreadPool pool(4);
+  absl::CoroutineExecutorAdapter<absl::ThreadPool> executor(&pool);
+  absl::AsyncMutex mu;
+  int counter = 0;
+  absl::BlockingCounter done(kCoroutines);
+  auto incrementer = [](absl::AsyncMutex* mu, int* counter,
+                        absl::BlockingCounter* done) -> absl::Task<void> {
+    for (int i = 0; i < kIterations; ++i) {
+      co_await mu->LockAsync();
+      const int seen = *counter;
+      std::this_thread::yield();
+      *counter = seen + 1;
+      mu->Unlock();
+    }
+    done->DecrementCount();
+  };
+  for (int i = 0; i < kCoroutines; ++i) {
+    absl::Spawn(&executor, incrementer(&mu, &counter, &done));
+  }
+  done.Wait();
+  ASSERT_TRUE(mu.TryLock());
+  EXPECT_EQ(counter, kCoroutines * kIterations);
+  mu.Unlock();
+}
+
+}  // namespace
+
+#endif  // ABSL_HAVE_COROUTINES
@@ -0,0 +1,315 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// future.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::Promise<T>` and `absl::Future<T>`, the two
+// ends of a channel that carries a single value of type `T` (or, for
+// `T = void`, only the fact that it has been set) from one thread to others.
+//
+// A `Future` can be waited on, like an `absl::Notification`, but it can also
+// be given a continuation to run once its value is set, without tying up a
+// thread to wait for it:
+//
+//   absl::Promise<std::string> promise;
+//   absl::Future<size_t> length = promise.GetFuture().Then(
+//       [](std::string s) { return s.size(); });
+//   ...
+//   promise.Set("hello");  // runs the continuation
+//   ...
+//   size_t n = length.Get();
+//
+// A continuation runs in the thread that sets the value, or, if the value is
+// already set, in the thread that calls `Then()`. Continuations that do
+// more than a little work should instead be run on an executor, such as an
+// `absl::ThreadPool`:
+//
+//   absl::Future<Result> result =
+//       std::move(input).Then(&pool, [](Input in) { return Process(in); });
+//
+// `WhenAll()` and `WhenAny()` combine several futures into one.
+//
+// Each `Promise`, and each call to `Then()`, `WhenAll()` or `WhenAny()`,
+// makes a single allocation that holds the value, the continuations and the
+// state needed to synchronize them. The value may allocate in turn: that of
+// a `WhenAll()` of non-void futures is a `std::vector`.
+
+#ifndef ABSL_SYNCHRONIZATION_FUTURE_H_
+#define ABSL_SYNCHRONIZATION_FUTURE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/internal/raw_logging.h"
+#include "absl/synchronization/internal/future_internal.h"
+#include "absl/time/time.h"
+
+namespace absl {
+
+template <typename T>
+class Future;
+
+namespace future_internal {
+
+// Grants the free functions below access to the state of a Future.
+struct FutureAccess {
+  template <typename T>
+  static SharedState<T>* Release(Future<T>* future) {
+    SharedState<T>* state = future->state_;
+    future->state_ = nullptr;
+    return state;
+  }
+
+  template <typename T>
+  static Future<T> Make(SharedState<T>* state) {
+    return Future<T>(state);
+  }
+};
+
+// The return type of `Future<T>::Get()`.
+template <typename T>
+struct GetResult {
+  using type = const T&;
+};
+
+template <>
+struct GetResult<void> {
+  using type = void;
+};
+
+template <typename T>
+struct GetValue {
+  static const T& Do(SharedState<T>* state) { return state->value(); }
+};
+
+template <>
+struct GetValue<void> {
+  static void Do(SharedState<void>*) {}
+};
+
+}  // namespace future_internal
+
+// Future
+//
+// The receiving end of a `Promise<T>`. A `Future` is movable but not
+// copyable; it is valid until it is moved from or consumed by `Then()`,
+// `WhenAll()` or `WhenAny()`. Only `Valid()` may be called on an invalid
+// future.
+template <typename T>
+class Future {
+ public:
+  // Constructs an invalid `Future`.
+  Future() noexcept : state_(nullptr) {}
+
+  Future(Future&& other) noexcept : state_(other.state_) {
+    other.state_ = nullptr;
+  }
+
+  Future& operator=(Future&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      state_ = other.state_;
+      other.state_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~Future() { Reset(); }
+
+  // Returns true if this future refers to a value, set or not.
+  bool Valid() const { return state_ != nullptr; }
+
+  // Returns true if the value has been set.
+  bool IsReady() const { return state_->IsReady(); }
+
+  // Blocks until the value has been set.
+  void Wait() const { state_->Wait(); }
+
+  // Blocks until the value has been set or `timeout` has elapsed, and returns
+  // true in the former case.
+  bool WaitWithTimeout(absl::Duration timeout) const {
+    return state_->WaitWithTimeout(timeout);
+  }
+
+  // Blocks until the value has been set, and returns it. For `Future<void>`,
+  // returns nothing. The returned reference is valid as long as this future
+  // is.
+  typename future_internal::GetResult<T>::type Get() const {
+    state_->Wait();
+    return future_internal::GetValue<T>::Do(state_);
+  }
+
+  // Future::Then()
+  //
+  // Consumes this future, and returns a future for `f(value)`, or `f()` for
+  // a `Future<void>`. The value is passed as an rvalue. If `f` returns
+  // `void`, so does the new future.
+  //
+  // The first overload calls `f` inline, in the thread that sets the value
+  // or, if it is already set, in this thread. The second schedules it on
+  // `executor`, which must outlive the call and provide a
+  // `Schedule(Callable)` method, such as `absl::ThreadPool`.
+  template <typename F>
+  Future<future_internal::ThenResult<T, typename std::decay<F>::type>> Then(
+      F&& f) {
+    return Then(future_internal::GetInlineExecutor(), std::forward<F>(f));
+  }
+
+  template <typename Executor, typename F>
+  Future<future_internal::ThenResult<T, typename std::decay<F>::type>> Then(
+      Executor* executor, F&& f) {
+    assert(Valid());
+    using D = typename std::decay<F>::type;
+    auto* state = new future_internal::ThenState<T, D, Executor>(
+        state_, std::forward<F>(f), executor);
+    state_ = nullptr;
+    state->Start();
+    return future_internal::FutureAccess::Make<
+        future_internal::ThenResult<T, D>>(state);
+  }
+
+ private:
+  friend struct future_internal::FutureAccess;
+  template <typename U>
+  friend class Promise;
+
+  explicit Future(future_internal::SharedState<T>* state) : state_(state) {}
+
+  void Reset() {
+    if (state_ != nullptr) {
+      state_->Unref();
+      state_ = nullptr;
+    }
+  }
+
+  future_internal::SharedState<T>* state_;
+};
+
+// Promise
+//
+// The sending end of a `Future<T>`. A `Promise` is movable but not copyable.
+// Its value must be set exactly once, before it is destroyed.
+template <typename T>
+class Promise {
+ public:
+  Promise()
+      : state_(new future_internal::SharedState<T>),
+        future_retrieved_(false) {}
+
+  Promise(Promise&& other) noexcept
+      : state_(other.state_), future_retrieved_(other.future_retrieved_) {
+    other.state_ = nullptr;
+  }
+
+  Promise& operator=(Promise&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      state_ = other.state_;
+      future_retrieved_ = other.future_retrieved_;
+      other.state_ = nullptr;
+    }
+    return *this;
+  }
+
+  ~Promise() { Reset(); }
+
+  // Returns the future for this promise's value. May be called at most once.
+  Future<T> GetFuture() {
+    assert(!future_retrieved_ && "Promise::GetFuture() called twice");
+    future_retrieved_ = true;
+    state_->Ref();
+    return Future<T>(state_);
+  }
+
+  // Constructs the value from `args`, which must be empty for
+  // `Promise<void>`, wakes all threads waiting for it, and runs the
+  // continuation, if any, in this thread.
+  template <typename... Args>
+  void Set(Args&&... args) {
+    assert(!state_->IsReady() && "Promise::Set() called twice");
+    state_->SetValue(std::forward<Args>(args)...);
+  }
+
+ private:
+  void Reset() {
+    if (state_ != nullptr) {
+      ABSL_RAW_CHECK(state_->IsReady(), "Promise destroyed without a value");
+      state_->Unref();
+      state_ = nullptr;
+    }
+  }
+
+  future_internal::SharedState<T>* state_;
+  bool future_retrieved_;
+};
+
+// MakeReadyFuture()
+//
+// Returns a future whose value, constructed from `args`, is already set.
+template <typename T, typename... Args>
+Future<T> MakeReadyFuture(Args&&... args) {
+  auto* state = new future_internal::SharedState<T>;
+  state->SetValue(std::forward<Args>(args)...);
+  return future_internal::FutureAccess::Make(state);
+}
+
+// WhenAll()
+//
+// Consumes `futures`, and returns a future that becomes ready once all of
+// them are. Its value is a vector of their values, in the same order, or
+// nothing for futures of type `void`.
+template <typename T>
+Future<typename future_internal::WhenAllResult<T>::type> WhenAll(
+    std::vector<Future<T>> futures) {
+  using R = typename future_internal::WhenAllResult<T>::type;
+  if (futures.empty()) return MakeReadyFuture<R>();
+  using State = future_internal::WhenAllState<T>;
+  State* state = State::template New<State>(futures.size());
+  for (size_t i = 0; i != futures.size(); ++i) {
+    assert(futures[i].Valid());
+    state->SetInput(i, future_internal::FutureAccess::Release(&futures[i]));
+  }
+  state->Start();
+  return future_internal::FutureAccess::Make<R>(state);
+}
+
+// WhenAny()
+//
+// Consumes `futures`, which must not be empty, and returns a future that
+// becomes ready as soon as one of them is. Its value is the pair of the index
+// and the value of that future, or only the index for futures of type
+// `void`. The values of the other futures are discarded.
+template <typename T>
+Future<typename future_internal::WhenAnyResult<T>::type> WhenAny(
+    std::vector<Future<T>> futures) {
+  using R = typename future_internal::WhenAnyResult<T>::type;
+  assert(!futures.empty() && "WhenAny() of no futures");
+  using State = future_internal::WhenAnyState<T>;
+  State* state = State::template New<State>(futures.size());
+  for (size_t i = 0; i != futures.size(); ++i) {
+    assert(futures[i].Valid());
+    state->SetInput(i, future_internal::FutureAccess::Release(&futures[i]));
+  }
+  state->Start();
+  return future_internal::FutureAccess::Make<R>(state);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_FUTURE_H_
@@ -0,0 +1,229 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/future.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/thread_pool.h"
+#include "absl/time/time.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(Future, SetThenGet) {
+  absl::Promise<int> promise;
+  absl::Future<int> future = promise.GetFuture();
+  ASSERT_TRUE(future.Valid());
+  EXPECT_FALSE(future.IsReady());
+  promise.Set(42);
+  EXPECT_TRUE(future.IsReady());
+  EXPECT_EQ(future.Get(), 42);
+}
+
+TEST(Future, GetBlocksUntilSet) {
+  absl::Promise<std::string> promise;
+  absl::Future<std::string> future = promise.GetFuture();
+  std::thread setter([&promise] {
+    absl::SleepFor(absl::Milliseconds(50));
+    promise.Set("done");
+  });
+  EXPECT_EQ(future.Get(), "done");
+  setter.join();
+}
+
+TEST(Future, WaitWithTimeout) {
+  absl::Promise<void> promise;
+  absl::Future<void> future = promise.GetFuture();
+  EXPECT_FALSE(future.WaitWithTimeout(absl::Milliseconds(10)));
+  promise.Set();
+  EXPECT_TRUE(future.WaitWithTimeout(absl::Milliseconds(10)));
+  future.Get();
+}
+
+TEST(Future, MoveOnlyValue) {
+  absl::Promise<std::unique_ptr<int>> promise;
+  absl::Future<int> future = promise.GetFuture().Then(
+      [](std::unique_ptr<int> p) { return *p + 1; });
+  promise.Set(new int(1));
+  EXPECT_EQ(future.Get(), 2);
+}
+
+TEST(Future, ThenBeforeSetRunsInSetter) {
+  absl::Promise<int> promise;
+  absl::Future<int> source = promise.GetFuture();
+  std::thread::id ran_in;
+  absl::Future<int> result = source.Then([&ran_in](int v) {
+    ran_in = std::this_thread::get_id();
+    return v * 2;
+  });
+  EXPECT_FALSE(source.Valid());
+  EXPECT_FALSE(result.IsReady());
+
+  std::thread setter([&promise] { promise.Set(21); });
+  const std::thread::id setter_id = setter.get_id();
+  setter.join();
+  EXPECT_EQ(result.Get(), 42);
+  EXPECT_EQ(ran_in, setter_id);
+}
+
+TEST(Future, ThenAfterSetRunsImmediately) {
+  absl::Future<int> source = absl::MakeReadyFuture<int>(5);
+  bool ran = false;
+  absl::Future<void> result = source.Then([&ran](int v) {
+    EXPECT_EQ(v, 5);
+    ran = true;
+  });
+  EXPECT_TRUE(ran);
+  EXPECT_TRUE(result.IsReady());
+}
+
+TEST(Future, ChainOfThens) {
+  absl::Promise<void> promise;
+  absl::Future<std::string> result = promise.GetFuture()
+                                         .Then([] { return 1; })
+                                         .Then([](int v) { return v + 1; })
+                                         .Then([](int v) {
+                                           return std::to_string(v);
+                                         });
+  promise.Set();
+  EXPECT_EQ(result.Get(), "2");
+}
+
+TEST(Future, ContinuationIsDestroyedAfterRunning) {
+  auto captured = std::make_shared<int>(0);
+  absl::Promise<void> promise;
+  absl::Future<void> result =
+      promise.GetFuture().Then([captured] { ++*captured; });
+  EXPECT_EQ(captured.use_count(), 2);
+  promise.Set();
+  EXPECT_EQ(*captured, 1);
+  EXPECT_EQ(captured.use_count(), 1);
+}
+
+TEST(Future, DroppedFuturesStillRunContinuations) {
+  std::atomic<int> runs(0);
+  absl::Promise<int> promise;
+  promise.GetFuture().Then([&runs](int) { runs++; });
+  promise.Set(1);
+  EXPECT_EQ(runs.load(), 1);
+}
+
+TEST(Future, ThenOnExecutor) {
+  absl::ThreadPool pool(2);
+  absl::Promise<int> promise;
+  const std::thread::id setter_id = std::this_thread::get_id();
+  std::thread::id ran_in = setter_id;
+  absl::Future<int> result =
+      promise.GetFuture().Then(&pool, [&ran_in](int v) {
+        ran_in = std::this_thread::get_id();
+        return v + 1;
+      });
+  promise.Set(1);
+  EXPECT_EQ(result.Get(), 2);
+  EXPECT_NE(ran_in, setter_id);
+}
+
+TEST(Future, WhenAll) {
+  std::vector<absl::Promise<int>> promises(3);
+  std::vector<absl::Future<int>> futures;
+  for (auto& p : promises) futures.push_back(p.GetFuture());
+  absl::Future<std::vector<int>> all = absl::WhenAll(std::move(futures));
+  promises[2].Set(2);
+  promises[0].Set(0);
+  EXPECT_FALSE(all.IsReady());
+  promises[1].Set(1);
+  EXPECT_THAT(all.Get(), ElementsAre(0, 1, 2));
+}
+
+TEST(Future, WhenAllVoid) {
+  std::vector<absl::Promise<void>> promises(2);
+  std::vector<absl::Future<void>> futures;
+  for (auto& p : promises) futures.push_back(p.GetFuture());
+  absl::Future<void> all = absl::WhenAll(std::move(futures));
+  promises[0].Set();
+  EXPECT_FALSE(all.IsReady());
+  promises[1].Set();
+  EXPECT_TRUE(all.IsReady());
+}
+
+TEST(Future, WhenAllOfNothing) {
+  absl::Future<std::vector<int>> all =
+      absl::WhenAll(std::vector<absl::Future<int>>());
+  ASSERT_TRUE(all.IsReady());
+  EXPECT_TRUE(all.Get().empty());
+}
+
+TEST(Future, WhenAny) {
+  std::vector<absl::Promise<std::string>> promises(3);
+  std::vector<absl::Future<std::string>> futures;
+  for (auto& p : promises) futures.push_back(p.GetFuture());
+  absl::Future<std::pair<size_t, std::string>> any =
+      absl::WhenAny(std::move(futures));
+  EXPECT_FALSE(any.IsReady());
+  promises[1].Set("one");
+  ASSERT_TRUE(any.IsReady());
+  promises[0].Set("zero");
+  promises[2].Set("two");
+  EXPECT_EQ(any.Get().first, 1u);
+  EXPECT_EQ(any.Get().second, "one");
+}
+
+TEST(Future, WhenAnyVoid) {
+  std::vector<absl::Future<void>> futures;
+  absl::Promise<void> promise;
+  futures.push_back(promise.GetFuture());
+  futures.push_back(absl::MakeReadyFuture<void>());
+  absl::Future<size_t> any = absl::WhenAny(std::move(futures));
+  EXPECT_EQ(any.Get(), 1u);
+  promise.Set();
+}
+
+TEST(Future, ManyThreads) {
+  constexpr int kPromises = 1000;
+  std::vector<absl::Promise<int>> promises(kPromises);
+  // Destroyed first, so that no task still refers to the promises.
+  absl::ThreadPool pool(4);
+  std::vector<absl::Future<int>> futures;
+  for (auto& p : promises) {
+    futures.push_back(
+        p.GetFuture().Then(&pool, [](int v) { return v * 2; }));
+  }
+  absl::Future<int> sum = absl::WhenAll(std::move(futures))
+                              .Then([](std::vector<int> values) {
+                                int total = 0;
+                                for (int v : values) total += v;
+                                return total;
+                              });
+  for (int i = 0; i < kPromises; ++i) {
+    absl::Promise<int>* p = &promises[i];
+    pool.Schedule([p, i] { p->Set(i); });
+  }
+  EXPECT_EQ(sum.Get(), kPromises * (kPromises - 1));
+}
+
+TEST(FutureDeathTest, BrokenPromise) {
+  EXPECT_DEATH({ absl::Promise<int> promise; },
+               "Promise destroyed without a value");
+}
+
+}  // namespace
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <stdint.h>
+#include <atomic>
 #include <new>
 
 // This file is a no-op if the required LowLevelAlloc support is missing.
@@ -34,6 +35,9 @@ namespace synchronization_internal {
 static base_internal::SpinLock freelist_lock(base_internal::kLinkerInitialized);
 static base_internal::ThreadIdentity* thread_identity_freelist;
 
+// Every ThreadIdentity ever allocated, newest first, linked by next_allocated.
+static std::atomic<base_internal::ThreadIdentity*> all_thread_identities;
+
 // A per-thread destructor for reclaiming associated ThreadIdentity objects.
 // Since we must preserve their storage we cache them for re-use.
 static void ReclaimThreadIdentity(void* v) {
@@ -54,6 +58,9 @@ static void ReclaimThreadIdentity(void* v) {
   //     reinitialized before reuse.  We must allow explicit clearing of the
   //     association state in this case.
   base_internal::ClearCurrentThreadIdentity();
+  // A thread should not exit inside a read-side section, but if it does, it
+  // must not hold up reclamation forever.
+  identity->epoch.store(0, std::memory_order_release);
   {
     base_internal::SpinLockHolder l(&freelist_lock);
     identity->next = thread_identity_freelist;
@@ -79,7 +86,13 @@ static base_internal::ThreadIdentity* NewThreadIdentity() {
     }
   }
 
-  if (identity == nullptr) {
+  if (identity != nullptr) {
+    // Clear all but the fields that other threads may read at any time,
+    // which start with epoch.
+    memset(static_cast<void*>(identity), 0,
+           reinterpret_cast<char*>(&identity->epoch) -
+               reinterpret_cast<char*>(identity));
+  } else {
     // Allocate enough space to align ThreadIdentity to a multiple of
     // PerThreadSynch::kAlignment. This space is never released (it is
     // added to a freelist by ReclaimThreadIdentity instead).
@@ -89,12 +102,23 @@ static base_internal::ThreadIdentity* NewThreadIdentity() {
     identity = reinterpret_cast<base_internal::ThreadIdentity*>(
         RoundUp(reinterpret_cast<intptr_t>(allocation),
                 base_internal::PerThreadSynch::kAlignment));
+    memset(static_cast<void*>(identity), 0, sizeof(*identity));
+
+    base_internal::ThreadIdentity* head =
+        all_thread_identities.load(std::memory_order_relaxed);
+    do {
+      identity->next_allocated = head;
+    } while (!all_thread_identities.compare_exchange_weak(
+        head, identity, std::memory_order_release, std::memory_order_relaxed));
   }
-  memset(identity, 0, sizeof(*identity));
 
   return identity;
 }
 
+base_internal::ThreadIdentity* AllThreadIdentities() {
+  return all_thread_identities.load(std::memory_order_acquire);
+}
+
 // Allocates and attaches ThreadIdentity object for the calling thread.  Returns
 // the new identity.
 // REQUIRES: CurrentThreadIdentity(false) == nullptr
@@ -35,6 +35,12 @@ namespace synchronization_internal {
 // For private use only.
 base_internal::ThreadIdentity* CreateThreadIdentity();
 
+// Returns the most recently allocated ThreadIdentity object; the others
+// follow through their `next_allocated` fields.  ThreadIdentity objects are
+// never freed, so the list may be walked at any time without locking.  It
+// includes objects not currently assigned to a thread.
+base_internal::ThreadIdentity* AllThreadIdentities();
+
 // Returns the ThreadIdentity object representing the calling thread; guaranteed
 // to be unique for its lifetime.  The returned object will remain valid for the
 // program's lifetime; although it may be re-assigned to a subsequent thread.
@@ -0,0 +1,66 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/internal/epoch.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/attributes.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+ABSL_CONST_INIT std::atomic<uint64_t> global_epoch(1);
+
+uint64_t EpochAdvance() {
+  // Orders the caller's unlinking of objects before the increment, which
+  // readers load with acquire ordering in EpochEnter().
+  return global_epoch.fetch_add(1, std::memory_order_seq_cst);
+}
+
+uint64_t EpochOldestReader() {
+  // Pairs with the fence in EpochEnter(): either this scan sees a reader's
+  // epoch, or that reader sees everything the caller did before the scan.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (base_internal::ThreadIdentity* identity = AllThreadIdentities();
+       identity != nullptr; identity = identity->next_allocated) {
+    // Acquire pairs with the release in EpochExit(), so that the reader's
+    // uses of objects happen before the caller frees them.
+    const uint64_t epoch = identity->epoch.load(std::memory_order_acquire);
+    if (epoch != 0) oldest = std::min(oldest, epoch);
+  }
+  return oldest;
+}
+
+void EpochWaitForReaders(uint64_t epoch) {
+  // Read-side sections are expected to be short, so poll; first by yielding,
+  // then by sleeping for increasing times.
+  absl::Duration sleep = absl::Microseconds(10);
+  for (int i = 0; EpochOldestReader() <= epoch; i++) {
+    if (i < 10) {
+      std::this_thread::yield();
+    } else {
+      absl::SleepFor(sleep);
+      sleep = std::min(sleep * 2, absl::Milliseconds(1));
+    }
+  }
+}
+
+}  // namespace synchronization_internal
+}  // namespace absl
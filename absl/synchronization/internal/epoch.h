@@ -0,0 +1,84 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Epoch-based reclamation, which lets readers use shared objects without
+// locking or writing shared memory, while writers unlink objects and free
+// them later, once no reader can still be using them.
+//
+// A global epoch counter is advanced by writers.  A reader brackets its uses
+// of shared objects with EpochEnter() and EpochExit(), which record in the
+// thread's ThreadIdentity the epoch in which the read-side section began.  A
+// writer that has made an object unreachable to new readers calls
+// EpochAdvance(), and may free the object once EpochOldestReader() exceeds
+// the epoch returned: every reader that could have found the object has then
+// left its section.  It is used by absl::ReadMostly.
+
+#ifndef ABSL_SYNCHRONIZATION_INTERNAL_EPOCH_H_
+#define ABSL_SYNCHRONIZATION_INTERNAL_EPOCH_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/internal/thread_identity.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+// The current epoch.  Starts at 1, as 0 marks a thread outside any read-side
+// section.  Only for use by the functions below.
+extern std::atomic<uint64_t> global_epoch;
+
+// Starts a read-side section on the calling thread, which lasts until the
+// matching EpochExit().  Sections may nest.  Shared objects must be loaded
+// with at least acquire ordering after this call.
+inline void EpochEnter() {
+  base_internal::ThreadIdentity* identity = GetOrCreateCurrentThreadIdentity();
+  if (identity->epoch_nesting++ == 0) {
+    identity->epoch.store(global_epoch.load(std::memory_order_acquire),
+                          std::memory_order_relaxed);
+    // A writer that does not see the store above has not yet scanned the
+    // thread, so this thread's loads of shared objects below see the writer's
+    // unlinking of them.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+// Ends a read-side section started by EpochEnter().
+inline void EpochExit() {
+  base_internal::ThreadIdentity* identity =
+      base_internal::CurrentThreadIdentityIfPresent();
+  if (--identity->epoch_nesting == 0) {
+    identity->epoch.store(0, std::memory_order_release);
+  }
+}
+
+// Starts a new epoch, and returns the previous one.  Objects that were made
+// unreachable before the call may be freed once EpochOldestReader() returns a
+// greater value.
+uint64_t EpochAdvance();
+
+// Returns the epoch in which the oldest current read-side section began, or
+// UINT64_MAX if no thread is in one.
+uint64_t EpochOldestReader();
+
+// Blocks until EpochOldestReader() > `epoch`.  Must not be called inside a
+// read-side section.
+void EpochWaitForReaders(uint64_t epoch);
+
+}  // namespace synchronization_internal
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_INTERNAL_EPOCH_H_
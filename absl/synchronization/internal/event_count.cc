@@ -0,0 +1,132 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Waiters are kept in a FIFO list under lock_, with their number mirrored in
+// num_waiters_ so that Notify() can skip the lock when there are none. A
+// waiter increments num_waiters_ and then rechecks its condition; a notifier
+// changes the state and then reads num_waiters_. The seq_cst fences on both
+// sides ensure that either the waiter sees the new state or the notifier sees
+// the waiter.
+
+#include "absl/synchronization/internal/event_count.h"
+
+#include <limits>
+
+#include "absl/base/internal/sysinfo.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/internal/per_thread_sem.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+namespace {
+
+// The number of times a waiter polls for its notification before it parks.
+// As for Mutex, spinning is pointless on a single CPU.
+int SpinIterations() {
+  static const int iterations = base_internal::NumCPUs() > 1 ? 1000 : 0;
+  return iterations;
+}
+
+}  // namespace
+
+void EventCount::PrepareWait(Waiter* w) {
+  w->identity = GetOrCreateCurrentThreadIdentity();
+  w->woken.store(false, std::memory_order_relaxed);
+  {
+    base_internal::SpinLockHolder l(&lock_);
+    w->prev = tail_;
+    w->next = nullptr;
+    if (tail_ == nullptr) {
+      head_ = w;
+    } else {
+      tail_->next = w;
+    }
+    tail_ = w;
+    w->queued = true;
+    num_waiters_.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EventCount::CancelWait(Waiter* w) {
+  {
+    base_internal::SpinLockHolder l(&lock_);
+    if (w->queued) {
+      if (w->prev == nullptr) {
+        head_ = w->next;
+      } else {
+        w->prev->next = w->next;
+      }
+      if (w->next == nullptr) {
+        tail_ = w->prev;
+      } else {
+        w->next->prev = w->prev;
+      }
+      w->queued = false;
+      num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  // A notifier has dequeued w, and will touch it until it sets woken. Wait
+  // for that, consuming its Post(), then hand the notification on.
+  CommitWait(w);
+  Notify(1);
+}
+
+void EventCount::CommitWait(Waiter* w) {
+  for (int i = SpinIterations(); i != 0; i--) {
+    if (w->woken.load(std::memory_order_acquire)) return;
+  }
+  while (!w->woken.load(std::memory_order_acquire)) {
+    PerThreadSem::Wait(KernelTimeout::Never());
+  }
+}
+
+void EventCount::NotifyAll() { Notify(std::numeric_limits<int>::max()); }
+
+void EventCount::NotifySlow(int n) {
+  Waiter* woken = nullptr;
+  {
+    base_internal::SpinLockHolder l(&lock_);
+    Waiter* last = nullptr;
+    for (Waiter* w = head_; w != nullptr && n != 0; w = w->next, n--) {
+      w->queued = false;
+      num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+      last = w;
+    }
+    if (last != nullptr) {
+      woken = head_;
+      head_ = last->next;
+      if (head_ == nullptr) {
+        tail_ = nullptr;
+      } else {
+        head_->prev = nullptr;
+      }
+      last->next = nullptr;
+    }
+  }
+  while (woken != nullptr) {
+    // Once woken is set, the waiter may return and its Waiter go away.
+    Waiter* next = woken->next;
+    base_internal::ThreadIdentity* identity = woken->identity;
+    woken->woken.store(true, std::memory_order_release);
+    PerThreadSem::Post(identity);
+    woken = next;
+  }
+}
+
+}  // namespace synchronization_internal
+}  // namespace absl
@@ -0,0 +1,102 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// EventCount lets threads block until a condition on lock-free state becomes
+// true, without making the threads that change that state take a lock when
+// nobody is waiting. A waiter announces itself before it rechecks the
+// condition, so that a notifier that changes the state after the recheck is
+// certain to see it:
+//
+//   EventCount::Waiter w;
+//   ec.PrepareWait(&w);
+//   if (condition) {
+//     ec.CancelWait(&w);
+//   } else {
+//     ec.CommitWait(&w);  // blocks until a Notify()
+//   }
+//
+// and the thread that makes the condition true then calls Notify() or
+// NotifyAll(). Waiters park on their PerThreadSem. It is used by MpmcQueue.
+
+#ifndef ABSL_SYNCHRONIZATION_INTERNAL_EVENT_COUNT_H_
+#define ABSL_SYNCHRONIZATION_INTERNAL_EVENT_COUNT_H_
+
+#include <atomic>
+
+#include "absl/base/internal/spinlock.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/thread_annotations.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+class EventCount {
+ public:
+  // The state of one waiting thread, which lives on its stack.
+  class Waiter {
+   public:
+    Waiter() = default;
+    Waiter(const Waiter&) = delete;
+    Waiter& operator=(const Waiter&) = delete;
+
+   private:
+    friend class EventCount;
+
+    base_internal::ThreadIdentity* identity = nullptr;
+    Waiter* prev = nullptr;
+    Waiter* next = nullptr;
+    bool queued = false;  // on the list; guarded by the EventCount's lock_
+    std::atomic<bool> woken{false};
+  };
+
+  EventCount() : num_waiters_(0), head_(nullptr), tail_(nullptr) {}
+
+  EventCount(const EventCount&) = delete;
+  EventCount& operator=(const EventCount&) = delete;
+
+  // Adds `w` to the waiters. The caller must then check its condition, and
+  // call CancelWait() if it is true, and CommitWait() otherwise.
+  void PrepareWait(Waiter* w);
+
+  // Removes `w`, prepared by PrepareWait(), from the waiters. If it has
+  // already been notified, passes the notification on to another waiter.
+  void CancelWait(Waiter* w);
+
+  // Blocks until `w`, prepared by PrepareWait(), has been notified.
+  void CommitWait(Waiter* w);
+
+  // Wakes up to `n` waiters, in the order in which they prepared to wait.
+  // Costs only a fence and a load when there are none.
+  void Notify(int n) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiters_.load(std::memory_order_relaxed) != 0) NotifySlow(n);
+  }
+
+  // Wakes all waiters.
+  void NotifyAll();
+
+ private:
+  void NotifySlow(int n);
+
+  std::atomic<int> num_waiters_;
+  base_internal::SpinLock lock_;
+  Waiter* head_ GUARDED_BY(lock_);
+  Waiter* tail_ GUARDED_BY(lock_);
+};
+
+}  // namespace synchronization_internal
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_INTERNAL_EVENT_COUNT_H_
@@ -0,0 +1,86 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/internal/futex.h"
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "absl/base/optimization.h"
+
+// Some Android headers are missing these definitions even though they
+// support these futex operations.
+#ifdef __BIONIC__
+#ifndef SYS_futex
+#define SYS_futex __NR_futex
+#endif
+#ifndef FUTEX_WAIT_BITSET
+#define FUTEX_WAIT_BITSET 9
+#endif
+#ifndef FUTEX_PRIVATE_FLAG
+#define FUTEX_PRIVATE_FLAG 128
+#endif
+#ifndef FUTEX_CLOCK_REALTIME
+#define FUTEX_CLOCK_REALTIME 256
+#endif
+#ifndef FUTEX_BITSET_MATCH_ANY
+#define FUTEX_BITSET_MATCH_ANY 0xFFFFFFFF
+#endif
+#endif
+
+namespace absl {
+namespace synchronization_internal {
+
+int Futex::WaitUntil(std::atomic<int32_t> *v, int32_t val, KernelTimeout t) {
+  int err = 0;
+  if (t.has_timeout()) {
+    // https://locklessinc.com/articles/futex_cheat_sheet/
+    // Unlike FUTEX_WAIT, FUTEX_WAIT_BITSET uses absolute time.
+    struct timespec abs_timeout = t.MakeAbsTimespec();
+    // Atomically check that the futex value is still val, and if it
+    // is, sleep until abs_timeout or until woken by FUTEX_WAKE.
+    err = syscall(
+        SYS_futex, reinterpret_cast<int32_t *>(v),
+        FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG | FUTEX_CLOCK_REALTIME, val,
+        &abs_timeout, nullptr, FUTEX_BITSET_MATCH_ANY);
+  } else {
+    // Atomically check that the futex value is still val, and if it
+    // is, sleep until woken by FUTEX_WAKE.
+    err = syscall(SYS_futex, reinterpret_cast<int32_t *>(v),
+                  FUTEX_WAIT | FUTEX_PRIVATE_FLAG, val, nullptr);
+  }
+  if (err != 0) {
+    err = -errno;
+  }
+  return err;
+}
+
+int Futex::Wake(std::atomic<int32_t> *v, int32_t count) {
+  int err = syscall(SYS_futex, reinterpret_cast<int32_t *>(v),
+                    FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count);
+  if (ABSL_PREDICT_FALSE(err < 0)) {
+    err = -errno;
+  }
+  return err;
+}
+
+}  // namespace synchronization_internal
+}  // namespace absl
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
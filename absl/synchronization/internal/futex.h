@@ -0,0 +1,62 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Futex is a thin wrapper around the Linux futex system call, used by Waiter
+// and by synchronization primitives that wait on a word of their own rather
+// than on a per-thread semaphore. ABSL_INTERNAL_HAVE_FUTEX is defined where
+// it is available.
+
+#ifndef ABSL_SYNCHRONIZATION_INTERNAL_FUTEX_H_
+#define ABSL_SYNCHRONIZATION_INTERNAL_FUTEX_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/synchronization/internal/kernel_timeout.h"
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+#error ABSL_INTERNAL_HAVE_FUTEX cannot be directly set
+#elif defined(__linux__)
+#define ABSL_INTERNAL_HAVE_FUTEX 1
+#endif
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+namespace absl {
+namespace synchronization_internal {
+
+class Futex {
+ public:
+  // Futexes are defined by specification to be 32-bits.
+  static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t),
+                "Wrong size for futex");
+
+  // Atomically checks that `*v` is still `val`, and if it is, sleeps until
+  // woken by Wake() or until `t` has passed. Returns 0 if woken, which may
+  // be spuriously, or a negated errno value: -EWOULDBLOCK if `*v` was not
+  // `val`, -EINTR if interrupted and -ETIMEDOUT if `t` passed.
+  static int WaitUntil(std::atomic<int32_t>* v, int32_t val, KernelTimeout t);
+
+  // Wakes at most `count` threads sleeping in WaitUntil() on `v`. Returns the
+  // number woken, or a negated errno value.
+  static int Wake(std::atomic<int32_t>* v, int32_t count);
+};
+
+}  // namespace synchronization_internal
+}  // namespace absl
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
+
+#endif  // ABSL_SYNCHRONIZATION_INTERNAL_FUTEX_H_
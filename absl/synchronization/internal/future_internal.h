@@ -0,0 +1,399 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Shared state of absl::Future and absl::Promise. See future.h.
+
+#ifndef ABSL_SYNCHRONIZATION_INTERNAL_FUTURE_INTERNAL_H_
+#define ABSL_SYNCHRONIZATION_INTERNAL_FUTURE_INTERNAL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+
+namespace absl {
+namespace future_internal {
+
+// Stands in for the value of a `Future<void>`.
+struct Empty {};
+
+template <typename T>
+using StorageType =
+    typename std::conditional<std::is_void<T>::value, Empty, T>::type;
+
+// Something to run once the value of a SharedState has been set.
+class Continuation {
+ public:
+  virtual void Run() = 0;
+
+ protected:
+  ~Continuation() = default;
+};
+
+// The state shared by a Promise and its Future: a reference count, the value
+// once it is set, and at most one Continuation.
+//
+// Subclasses that implement Future::Then(), WhenAll() and WhenAny() embed
+// their own state in the same allocation, so that each of them allocates
+// once.
+template <typename T>
+class SharedState {
+ public:
+  using Storage = StorageType<T>;
+
+  SharedState() : refs_(1), continuation_(kPending) {}
+
+  SharedState(const SharedState&) = delete;
+  SharedState& operator=(const SharedState&) = delete;
+
+  virtual ~SharedState() {
+    if (ready_.HasBeenNotified()) value().~Storage();
+  }
+
+  void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+  void Unref() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  // Constructs the value from `args`, wakes threads blocked in Wait(), and
+  // runs the continuation, if any. Must be called exactly once.
+  template <typename... Args>
+  void SetValue(Args&&... args) {
+    new (&storage_) Storage(std::forward<Args>(args)...);
+    ready_.Notify();
+    const uintptr_t c =
+        continuation_.exchange(kReady, std::memory_order_acq_rel);
+    if (c != kPending) reinterpret_cast<Continuation*>(c)->Run();
+  }
+
+  bool IsReady() const { return ready_.HasBeenNotified(); }
+
+  void Wait() const { ready_.WaitForNotification(); }
+
+  bool WaitWithTimeout(absl::Duration timeout) const {
+    return ready_.WaitForNotificationWithTimeout(timeout);
+  }
+
+  // REQUIRES: IsReady()
+  Storage& value() { return *reinterpret_cast<Storage*>(&storage_); }
+
+  // Arranges for `c->Run()` to be called once the value is set: immediately
+  // if it already is, and otherwise by the thread that sets it. May be called
+  // at most once.
+  void SetContinuation(Continuation* c) {
+    uintptr_t expected = kPending;
+    if (!continuation_.compare_exchange_strong(
+            expected, reinterpret_cast<uintptr_t>(c),
+            std::memory_order_acq_rel, std::memory_order_acquire)) {
+      c->Run();
+    }
+  }
+
+ private:
+  // Values of continuation_ other than a Continuation*.
+  static constexpr uintptr_t kPending = 0;
+  static constexpr uintptr_t kReady = 1;
+
+  std::atomic<int> refs_;
+  std::atomic<uintptr_t> continuation_;
+  Notification ready_;
+  typename std::aligned_storage<sizeof(Storage), alignof(Storage)>::type
+      storage_;
+};
+
+template <typename T>
+constexpr uintptr_t SharedState<T>::kPending;
+template <typename T>
+constexpr uintptr_t SharedState<T>::kReady;
+
+// Apply<T>::Call(f, v) calls `f` with the value `v` of a `Future<T>`, moving
+// it, or with no arguments if `T` is void.
+template <typename T>
+struct Apply {
+  template <typename F>
+  static auto Call(F& f, T& v) -> decltype(f(std::move(v))) {
+    return f(std::move(v));
+  }
+};
+
+template <>
+struct Apply<void> {
+  template <typename F>
+  static auto Call(F& f, Empty&) -> decltype(f()) {
+    return f();
+  }
+};
+
+// The type of the value of the future returned by `Future<T>::Then(f)`.
+template <typename T, typename F>
+using ThenResult = decltype(Apply<T>::Call(std::declval<F&>(),
+                                           std::declval<StorageType<T>&>()));
+
+// Sets the value of `state` to the result of Apply<T>::Call(f, v).
+template <typename R>
+struct SetResult {
+  template <typename T, typename F>
+  static void Do(SharedState<R>* state, F& f, StorageType<T>& v) {
+    state->SetValue(Apply<T>::Call(f, v));
+  }
+};
+
+template <>
+struct SetResult<void> {
+  template <typename T, typename F>
+  static void Do(SharedState<void>* state, F& f, StorageType<T>& v) {
+    Apply<T>::Call(f, v);
+    state->SetValue();
+  }
+};
+
+// Runs the continuation of `Future<T>::Then()` and holds its result.
+//
+// Holds one reference to itself until the continuation has run, and the
+// reference to `source` that the consumed future held.
+template <typename T, typename F, typename Executor>
+class ThenState final : public SharedState<ThenResult<T, F>>,
+                        private Continuation {
+ public:
+  using R = ThenResult<T, F>;
+
+  ThenState(SharedState<T>* source, F f, Executor* executor)
+      : source_(source), executor_(executor) {
+    new (&fn_) F(std::move(f));
+  }
+
+  // Takes the reference to this object that the continuation holds, and
+  // attaches the continuation to the source.
+  void Start() {
+    this->Ref();
+    source_->SetContinuation(this);
+  }
+
+ private:
+  void Run() override {
+    executor_->Schedule([this] { Execute(); });
+  }
+
+  void Execute() {
+    F& f = *reinterpret_cast<F*>(&fn_);
+    SetResult<R>::template Do<T>(this, f, source_->value());
+    // Release what the continuation captured as soon as it has run.
+    f.~F();
+    source_->Unref();
+    this->Unref();
+  }
+
+  SharedState<T>* const source_;
+  Executor* const executor_;
+  typename std::aligned_storage<sizeof(F), alignof(F)>::type fn_;
+};
+
+// The executor of continuations that are run by the thread that sets the
+// value, or by the thread that calls Then() if it is already set.
+struct InlineExecutor {
+  template <typename F>
+  void Schedule(F&& f) {
+    f();
+  }
+};
+
+inline InlineExecutor* GetInlineExecutor() {
+  static InlineExecutor executor;
+  return &executor;
+}
+
+// The type of the value of the future returned by `WhenAll()` of futures of
+// type `T`.
+template <typename T>
+struct WhenAllResult {
+  using type = std::vector<T>;
+};
+
+template <>
+struct WhenAllResult<void> {
+  using type = void;
+};
+
+// The type of the value of the future returned by `WhenAny()` of futures of
+// type `T`.
+template <typename T>
+struct WhenAnyResult {
+  using type = std::pair<size_t, T>;
+};
+
+template <>
+struct WhenAnyResult<void> {
+  using type = size_t;
+};
+
+// Builds the value of a WhenAll() future from the values of the inputs of
+// `state`.
+template <typename T>
+struct CollectAll {
+  template <typename State>
+  static void Do(State* state) {
+    std::vector<T> values;
+    values.reserve(state->num_inputs());
+    for (size_t i = 0; i != state->num_inputs(); ++i) {
+      values.push_back(std::move(state->input(i)->value()));
+    }
+    state->SetValue(std::move(values));
+  }
+};
+
+template <>
+struct CollectAll<void> {
+  template <typename State>
+  static void Do(State* state) {
+    state->SetValue();
+  }
+};
+
+// Builds the value of a WhenAny() future from its first ready input.
+template <typename T>
+struct CollectAny {
+  static void Do(SharedState<std::pair<size_t, T>>* state, size_t index,
+                 SharedState<T>* input) {
+    state->SetValue(index, std::move(input->value()));
+  }
+};
+
+template <>
+struct CollectAny<void> {
+  static void Do(SharedState<size_t>* state, size_t index,
+                 SharedState<void>*) {
+    state->SetValue(index);
+  }
+};
+
+// Base of the states of the futures returned by WhenAll() and WhenAny(),
+// which are of type `R`.
+//
+// The continuation attached to each input, and the reference to the input
+// that the consumed future held, live in an array that follows the state in
+// the same allocation; see New(). Holds one reference to itself until the
+// continuations of all inputs have run.
+template <typename T, typename R>
+class WhenState : public SharedState<R> {
+ public:
+  // Allocates a `State`, derived from WhenState, constructed from `n` and
+  // `args`, together with room for `n` inputs, which must then be given with
+  // SetInput().
+  template <typename State, typename... Args>
+  static State* New(size_t n, Args&&... args) {
+    const size_t offset =
+        (sizeof(State) + alignof(Node) - 1) & ~(alignof(Node) - 1);
+    char* p = static_cast<char*>(::operator new(offset + n * sizeof(Node)));
+    return new (p) State(reinterpret_cast<Node*>(p + offset), n,
+                         std::forward<Args>(args)...);
+  }
+
+  // The allocation made by New() is larger than the object.
+  static void operator delete(void* p) { ::operator delete(p); }
+
+  // Takes the reference to `input` that a consumed future held.
+  void SetInput(size_t index, SharedState<T>* input) {
+    new (&nodes_[index]) Node(this, input);
+  }
+
+  // Attaches a continuation to each input.
+  // REQUIRES: there is at least one input, and all have been set
+  void Start() {
+    this->Ref();
+    for (size_t i = 0; i != num_inputs_; ++i) {
+      nodes_[i].input->SetContinuation(&nodes_[i]);
+    }
+  }
+
+  size_t num_inputs() const { return num_inputs_; }
+  SharedState<T>* input(size_t index) const { return nodes_[index].input; }
+
+ protected:
+  struct Node;
+
+  WhenState(Node* nodes, size_t n)
+      : nodes_(nodes), num_inputs_(n), pending_(static_cast<int64_t>(n)) {}
+
+  // Called when the value of the input `index` has been set.
+  virtual void InputReady(size_t /*index*/) {}
+
+  // Called once the values of all inputs have been set, after InputReady().
+  virtual void AllInputsReady() {}
+
+ private:
+  void NodeReady(size_t index) {
+    InputReady(index);
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      AllInputsReady();
+      for (size_t i = 0; i != num_inputs_; ++i) nodes_[i].input->Unref();
+      this->Unref();
+    }
+  }
+
+  Node* const nodes_;
+  const size_t num_inputs_;
+  std::atomic<int64_t> pending_;  // inputs whose continuation has not run
+};
+
+template <typename T, typename R>
+struct WhenState<T, R>::Node final : Continuation {
+  Node(WhenState* p, SharedState<T>* i) : parent(p), input(i) {}
+  void Run() override {
+    parent->NodeReady(static_cast<size_t>(this - parent->nodes_));
+  }
+  WhenState* const parent;
+  SharedState<T>* const input;
+};
+
+template <typename T>
+class WhenAllState final
+    : public WhenState<T, typename WhenAllResult<T>::type> {
+ private:
+  using Base = WhenState<T, typename WhenAllResult<T>::type>;
+  friend Base;
+
+  WhenAllState(typename Base::Node* nodes, size_t n) : Base(nodes, n) {}
+
+  void AllInputsReady() override { CollectAll<T>::Do(this); }
+};
+
+template <typename T>
+class WhenAnyState final
+    : public WhenState<T, typename WhenAnyResult<T>::type> {
+ private:
+  using Base = WhenState<T, typename WhenAnyResult<T>::type>;
+  friend Base;
+
+  WhenAnyState(typename Base::Node* nodes, size_t n)
+      : Base(nodes, n), done_(false) {}
+
+  void InputReady(size_t index) override {
+    if (!done_.exchange(true, std::memory_order_acq_rel)) {
+      CollectAny<T>::Do(this, index, this->input(index));
+    }
+  }
+
+  std::atomic<bool> done_;  // the value has been set
+};
+
+}  // namespace future_internal
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_INTERNAL_FUTURE_INTERNAL_H_
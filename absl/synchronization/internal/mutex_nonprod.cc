@@ -247,6 +247,7 @@ bool Mutex::ReaderLockWhenWithDeadline(const Condition& cond,
 
 void Mutex::EnableDebugLog(const char*) {}
 void Mutex::EnableInvariantDebugging(void (*)(void*), void*) {}
+void Mutex::EnableLatencyHistograms(const char*) {}
 void Mutex::ForgetDeadlockInfo() {}
 void Mutex::AssertHeld() const {}
 void Mutex::AssertReaderHeld() const {}
@@ -315,4 +316,26 @@ bool Condition::Eval() const {
 
 void RegisterSymbolizer(bool (*)(const void*, char*, int)) {}
 
+void EnableMutexAdaptiveSpinning(bool) {}
+
+// This implementation has no deadlock detector to sample for.
+void SetMutexDeadlockDetectionSamplingRate(int) {}
+
+// This implementation does not sample contention, so the profile is always
+// empty.
+void SetMutexContentionProfilingRate(int) {}
+std::vector<MutexContentionSample> GetMutexContentionSamples() { return {}; }
+std::string GetMutexContentionProfile(MutexContentionStack) {
+  return "--- contention\n";
+}
+void ResetMutexContentionProfile() {}
+
+// Nor does it record latencies, so there are no histograms.
+void EnableMutexLatencyHistograms(bool) {}
+int64_t MutexLatencyHistogram::Distribution::Quantile(double) const {
+  return 0;
+}
+std::vector<MutexLatencyHistogram> GetMutexLatencyHistograms() { return {}; }
+void ResetMutexLatencyHistograms() {}
+
 }  // namespace absl
@@ -0,0 +1,90 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Waiters that find the event unset push a Waiter, allocated on their own
+// stack, onto a lock-free list headed by state_, and park until Set() marks
+// their Waiter woken. Set() swaps the list out for kSet, so that no Waiter can
+// be pushed afterwards, and wakes each Waiter on it.
+
+#include "absl/synchronization/internal/one_shot_event.h"
+
+#include "absl/base/internal/raw_logging.h"
+#include "absl/base/internal/sysinfo.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/internal/per_thread_sem.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+constexpr uintptr_t OneShotEvent::kUnset;
+constexpr uintptr_t OneShotEvent::kSet;
+
+struct OneShotEvent::Waiter {
+  base_internal::ThreadIdentity* identity;
+  Waiter* next;
+  std::atomic<bool> woken;
+};
+
+namespace {
+
+// The number of times a waiter polls the event before it parks. As for
+// Mutex, spinning is pointless on a single CPU.
+int SpinIterations() {
+  static const int iterations = base_internal::NumCPUs() > 1 ? 1500 : 0;
+  return iterations;
+}
+
+}  // namespace
+
+void OneShotEvent::Set() {
+  uintptr_t head = state_.exchange(kSet, std::memory_order_acq_rel);
+  ABSL_RAW_CHECK(head != kSet, "OneShotEvent::Set() called twice");
+  Waiter* w = reinterpret_cast<Waiter*>(head);
+  while (w != nullptr) {
+    // Once woken is set, the waiter may return and its Waiter go away.
+    Waiter* next = w->next;
+    base_internal::ThreadIdentity* identity = w->identity;
+    w->woken.store(true, std::memory_order_release);
+    PerThreadSem::Post(identity);
+    w = next;
+  }
+}
+
+void OneShotEvent::Wait() {
+  for (int i = SpinIterations(); i != 0; i--) {
+    if (IsSet()) return;
+  }
+
+  Waiter w;
+  w.identity = GetOrCreateCurrentThreadIdentity();
+  w.woken.store(false, std::memory_order_relaxed);
+  uintptr_t head = state_.load(std::memory_order_acquire);
+  do {
+    if (head == kSet) return;
+    w.next = reinterpret_cast<Waiter*>(head);
+  } while (!state_.compare_exchange_weak(head, reinterpret_cast<uintptr_t>(&w),
+                                         std::memory_order_release,
+                                         std::memory_order_acquire));
+
+  // The semaphore may also hold posts meant for some earlier wait of this
+  // thread, so wait until this Waiter has actually been woken.
+  while (!w.woken.load(std::memory_order_acquire)) {
+    PerThreadSem::Wait(KernelTimeout::Never());
+  }
+}
+
+}  // namespace synchronization_internal
+}  // namespace absl
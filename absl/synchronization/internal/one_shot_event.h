@@ -0,0 +1,66 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// OneShotEvent is a lock-free event that is set once and on which any number
+// of threads may wait. Waiters spin briefly, then park on their PerThreadSem;
+// Set() wakes them all. It is used by Barrier and BlockingCounter, whose
+// waiters are usually released within microseconds of arriving.
+
+#ifndef ABSL_SYNCHRONIZATION_INTERNAL_ONE_SHOT_EVENT_H_
+#define ABSL_SYNCHRONIZATION_INTERNAL_ONE_SHOT_EVENT_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace absl {
+namespace synchronization_internal {
+
+class OneShotEvent {
+ public:
+  constexpr OneShotEvent() : state_(kUnset) {}
+
+  OneShotEvent(const OneShotEvent&) = delete;
+  OneShotEvent& operator=(const OneShotEvent&) = delete;
+
+  // Returns true if Set() has been called.
+  bool IsSet() const { return state_.load(std::memory_order_acquire) == kSet; }
+
+  // Wakes all threads blocked in Wait(). Must be called at most once.
+  //
+  // Set() does not touch the event after the first waiter it wakes may have
+  // returned, so a waiter may destroy the event once Wait() returns, provided
+  // no other thread will call Wait().
+  void Set();
+
+  // Blocks until Set() has been called.
+  //
+  // Memory ordering: any action taken before Set() is visible after Wait()
+  // returns.
+  void Wait();
+
+ private:
+  struct Waiter;
+
+  // Values of state_ other than a pointer to the most recently pushed Waiter.
+  static constexpr uintptr_t kUnset = 0;
+  static constexpr uintptr_t kSet = 1;
+
+  std::atomic<uintptr_t> state_;
+};
+
+}  // namespace synchronization_internal
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_INTERNAL_ONE_SHOT_EVENT_H_
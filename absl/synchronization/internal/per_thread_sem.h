@@ -34,6 +34,7 @@
 namespace absl {
 
 class Mutex;
+class ThreadPool;
 
 namespace synchronization_internal {
 
@@ -74,8 +75,12 @@ class PerThreadSem {
   static inline bool Wait(KernelTimeout t);
 
   // White-listed callers.
+  friend class EventCount;
+  friend class OneShotEvent;
+  friend class ParkingLot;
   friend class PerThreadSemTest;
   friend class absl::Mutex;
+  friend class absl::ThreadPool;
   friend absl::base_internal::ThreadIdentity* CreateThreadIdentity();
 };
 
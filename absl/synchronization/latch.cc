@@ -0,0 +1,126 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/latch.h"
+
+#include <errno.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/internal/raw_logging.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace absl {
+
+constexpr int Latch::kMaxCount;
+constexpr int32_t Latch::kCountMask;
+constexpr int32_t Latch::kWaiters;
+
+Latch::~Latch() {
+  // Make sure that the thread that brought the count to zero has finished
+  // waking waiters before the latch is destroyed.
+  while ((state_.load(std::memory_order_acquire) & kWaiters) != 0 &&
+         TryWait()) {
+    std::this_thread::yield();
+  }
+}
+
+void Latch::CountDown(int n) {
+  const int32_t prev = state_.fetch_sub(n, std::memory_order_acq_rel);
+#ifndef NDEBUG
+  if (ABSL_PREDICT_FALSE((prev & kCountMask) < n)) {
+    ABSL_RAW_LOG(FATAL, "Latch %p counted down below zero",
+                 static_cast<void *>(this));
+  }
+#endif
+  if (prev == (kWaiters | n)) {
+    WakeThreads();
+    // Waiters that see a zero count may return, but the destructor waits for
+    // kWaiters to be cleared, after which this latch must not be touched.
+    state_.store(0, std::memory_order_release);
+  }
+}
+
+bool Latch::WaitWithTimeout(absl::Duration timeout) const {
+  return TryWait() || WaitUntil(absl::Now() + timeout);
+}
+
+bool Latch::WaitWithDeadline(absl::Time deadline) const {
+  return TryWait() || WaitUntil(deadline);
+}
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+bool Latch::WaitUntil(absl::Time deadline) const {
+  const synchronization_internal::KernelTimeout t(deadline);
+  int32_t s = state_.load(std::memory_order_acquire);
+  while ((s & kCountMask) != 0) {
+    // Tell the last CountDown() that it must wake this thread.
+    if ((s & kWaiters) == 0 &&
+        !state_.compare_exchange_weak(s, s | kWaiters,
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+      continue;
+    }
+    const int err = synchronization_internal::Futex::WaitUntil(
+        &state_, s | kWaiters, t);
+    if (err == -ETIMEDOUT) {
+      return TryWait();
+    }
+    if (err != 0 && err != -EINTR && err != -EWOULDBLOCK) {
+      ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+    }
+    s = state_.load(std::memory_order_acquire);
+  }
+  return true;
+}
+
+void Latch::WakeThreads() {
+  const int err = synchronization_internal::Futex::Wake(
+      &state_, std::numeric_limits<int32_t>::max());
+  if (ABSL_PREDICT_FALSE(err < 0)) {
+    ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+  }
+}
+
+#else  // ABSL_INTERNAL_HAVE_FUTEX
+
+bool Latch::WaitUntil(absl::Time deadline) const {
+  // Tell the last CountDown() that it must wake this thread.
+  int32_t s = state_.load(std::memory_order_relaxed);
+  while ((s & kCountMask) != 0 && (s & kWaiters) == 0 &&
+         !state_.compare_exchange_weak(s, s | kWaiters,
+                                       std::memory_order_relaxed,
+                                       std::memory_order_relaxed)) {
+  }
+  const bool zero =
+      this->mutex_.LockWhenWithDeadline(Condition(this, &Latch::TryWait),
+                                        deadline);
+  this->mutex_.Unlock();
+  return zero;
+}
+
+void Latch::WakeThreads() {
+  MutexLock l(&this->mutex_);
+}
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
+
+}  // namespace absl
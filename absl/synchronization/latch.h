@@ -0,0 +1,138 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// latch.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::Latch`, a single-use count down on which
+// any number of threads may wait:
+//
+//   absl::Latch ready(kNumWorkers);
+//
+//   // Each worker, once initialized:
+//   ready.CountDown();
+//
+//   // Threads that need all workers to be ready:
+//   ready.Wait();
+//
+// A `Latch` is a single atomic word that threads wait on directly (with a
+// futex, where the platform has one), so none of its methods takes a lock,
+// and counting down while no thread waits is one atomic operation.
+//
+// Unlike `absl::BlockingCounter`, any number of threads may wait, with or
+// without a timeout, and the count may be decreased by more than one at a
+// time. `BlockingCounter` remains better suited to counts decremented by many
+// threads at once, which it spreads over several cache lines.
+//
+// Memory ordering: For any threads X and Y, any action taken by X before it
+// calls `CountDown()` is visible to Y after Y returns from `Wait()`, or
+// receives a `true` return value from `TryWait()`, `WaitWithTimeout()` or
+// `WaitWithDeadline()`.
+
+#ifndef ABSL_SYNCHRONIZATION_LATCH_H_
+#define ABSL_SYNCHRONIZATION_LATCH_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/synchronization/internal/futex.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace absl {
+
+// Latch
+//
+// Holds a count, which must start between zero and `kMaxCount`, and which
+// reaches zero once. A Latch may be destroyed as soon as the count is zero and
+// no thread will call any more of its methods, even if the `CountDown()` that
+// brought it to zero has not returned.
+class Latch {
+ public:
+  static constexpr int kMaxCount = (1 << 30) - 1;
+
+  explicit Latch(int count) : state_(count) {}
+
+  Latch(const Latch&) = delete;
+  Latch& operator=(const Latch&) = delete;
+
+  ~Latch();
+
+  // Latch::CountDown()
+  //
+  // Decreases the count by `n`, and wakes the waiting threads if it reaches
+  // zero. The count must be at least `n`.
+  void CountDown(int n = 1);
+
+  // Latch::TryWait()
+  //
+  // Returns whether the count is zero.
+  bool TryWait() const {
+    return (state_.load(std::memory_order_acquire) & kCountMask) == 0;
+  }
+
+  // Latch::Wait()
+  //
+  // Blocks until the count is zero.
+  void Wait() const {
+    if (!TryWait()) WaitUntil(absl::InfiniteFuture());
+  }
+
+  // Latch::WaitWithTimeout()
+  //
+  // Blocks until the count is zero or `timeout` has elapsed, and returns
+  // whether the count is zero.
+  bool WaitWithTimeout(absl::Duration timeout) const;
+
+  // Latch::WaitWithDeadline()
+  //
+  // Blocks until the count is zero or `deadline` has passed, and returns
+  // whether the count is zero.
+  bool WaitWithDeadline(absl::Time deadline) const;
+
+  // Latch::ArriveAndWait()
+  //
+  // Equivalent to `CountDown(n)` followed by `Wait()`.
+  void ArriveAndWait(int n = 1) {
+    CountDown(n);
+    Wait();
+  }
+
+ private:
+  // state_ holds the count, and kWaiters once a thread may be blocked. The
+  // CountDown() that brings the count to zero clears kWaiters once it no
+  // longer touches the latch, which the destructor waits for.
+  static constexpr int32_t kCountMask = kMaxCount;
+  static constexpr int32_t kWaiters = 1 << 30;
+
+  // Blocks until the count is zero or `deadline` has passed, and returns
+  // whether the count is zero.
+  bool WaitUntil(absl::Time deadline) const;
+
+  // Wakes the threads blocked in WaitUntil().
+  void WakeThreads();
+
+  mutable std::atomic<int32_t> state_;
+#ifndef ABSL_INTERNAL_HAVE_FUTEX
+  // Without a futex, threads block in mutex_.LockWhenWithDeadline(), and the
+  // last CountDown() acquires and releases mutex_ to make them re-evaluate
+  // their Condition.
+  mutable Mutex mutex_;
+#endif
+};
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_LATCH_H_
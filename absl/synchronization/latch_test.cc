@@ -0,0 +1,109 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/latch.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+TEST(Latch, CountDown) {
+  absl::Latch latch(3);
+  EXPECT_FALSE(latch.TryWait());
+  latch.CountDown(2);
+  EXPECT_FALSE(latch.TryWait());
+  EXPECT_FALSE(latch.WaitWithTimeout(absl::ZeroDuration()));
+  latch.CountDown();
+  EXPECT_TRUE(latch.TryWait());
+  latch.Wait();
+  EXPECT_TRUE(latch.WaitWithDeadline(absl::InfinitePast()));
+}
+
+TEST(Latch, ZeroCount) {
+  absl::Latch latch(0);
+  EXPECT_TRUE(latch.TryWait());
+  latch.Wait();
+}
+
+TEST(Latch, WaitWithTimeout) {
+  absl::Latch latch(1);
+  absl::Time start = absl::Now();
+  EXPECT_FALSE(latch.WaitWithTimeout(absl::Milliseconds(50)));
+  EXPECT_LE(start + absl::Milliseconds(50), absl::Now());
+
+  std::thread counter([&latch] {
+    absl::SleepFor(absl::Milliseconds(50));
+    latch.CountDown();
+  });
+  EXPECT_TRUE(latch.WaitWithTimeout(absl::Seconds(60)));
+  counter.join();
+}
+
+TEST(Latch, WakesAllWaiters) {
+  constexpr int kWaiters = 8;
+  absl::Latch latch(1);
+  int value = 0;
+  std::atomic<int> done(0);
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < kWaiters; i++) {
+    waiters.emplace_back([&] {
+      latch.Wait();
+      EXPECT_EQ(value, 1);
+      done++;
+    });
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(done.load(), 0);
+  value = 1;
+  latch.CountDown();
+  for (std::thread& waiter : waiters) waiter.join();
+  EXPECT_EQ(done.load(), kWaiters);
+}
+
+TEST(Latch, ArriveAndWait) {
+  constexpr int kThreads = 8;
+  absl::Latch latch(kThreads);
+  std::atomic<int> arrived(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&] {
+      arrived++;
+      latch.ArriveAndWait();
+      EXPECT_EQ(arrived.load(), kThreads);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+// A waiter may destroy the latch as soon as it returns, while the thread that
+// counted down may still be waking others.
+TEST(Latch, DestroyAfterWait) {
+  for (int i = 0; i < 100; i++) {
+    std::unique_ptr<absl::Latch> latch(new absl::Latch(1));
+    absl::Latch* raw = latch.get();
+    std::thread counter([raw] { raw->CountDown(); });
+    latch->Wait();
+    latch.reset();
+    counter.join();
+  }
+}
+
+}  // namespace
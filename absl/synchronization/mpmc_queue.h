@@ -0,0 +1,393 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// mpmc_queue.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::MpmcQueue<T>`, a bounded first-in,
+// first-out queue that any number of threads may push to and pop from.
+//
+//   absl::MpmcQueue<Request> queue(1024);
+//
+//   // Producers
+//   queue.Push(std::move(request));  // blocks while the queue is full
+//
+//   // Consumers
+//   Request request = queue.Pop();   // blocks while the queue is empty
+//
+// The queue is a fixed ring of slots, each with a sequence number that says
+// whether it is ready to be pushed to or popped from in the current lap of
+// the ring. A push or pop claims its slot with one compare-and-swap, on the
+// tail or head index respectively, and then touches only that slot, so
+// `TryPush()` and `TryPop()` are lock-free, and producers and consumers
+// interfere with each other only when the queue is nearly full or empty.
+// `Push()` and `Pop()` park the calling thread when they cannot proceed; a
+// thread that pushes or pops wakes a parked thread only if there is one.
+//
+// The batch operations claim several adjacent slots with a single
+// compare-and-swap, which amortizes the cost of contention on the indices.
+
+#ifndef ABSL_SYNCHRONIZATION_MPMC_QUEUE_H_
+#define ABSL_SYNCHRONIZATION_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/event_count.h"
+
+namespace absl {
+
+// MpmcQueue
+//
+// A bounded multi-producer, multi-consumer queue of `T`, which must be move
+// constructible. All member functions except the destructor are thread-safe.
+template <typename T>
+class MpmcQueue {
+ public:
+  // Creates a queue that can hold `capacity` elements, rounded up to a power
+  // of two no smaller than 2.
+  explicit MpmcQueue(size_t capacity);
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // Destroys the elements left in the queue. No other thread may be using
+  // the queue.
+  ~MpmcQueue();
+
+  // Returns the number of elements the queue can hold.
+  size_t capacity() const { return mask_ + 1; }
+
+  // MpmcQueue::TryPush()
+  //
+  // Appends `value` if the queue is not full, and returns whether it did.
+  // The value is moved from only if it was appended.
+  bool TryPush(const T& value) { return TryEmplace(value); }
+  bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+
+  // MpmcQueue::TryEmplace()
+  //
+  // Appends an element constructed from `args` if the queue is not full, and
+  // returns whether it did.
+  template <typename... Args>
+  bool TryEmplace(Args&&... args);
+
+  // MpmcQueue::Push()
+  //
+  // Appends `value`, blocking while the queue is full.
+  void Push(const T& value) { Emplace(value); }
+  void Push(T&& value) { Emplace(std::move(value)); }
+
+  // MpmcQueue::Emplace()
+  //
+  // Appends an element constructed from `args`, blocking while the queue is
+  // full.
+  template <typename... Args>
+  void Emplace(Args&&... args);
+
+  // MpmcQueue::TryPop()
+  //
+  // Removes the first element and moves it to `*value` if the queue is not
+  // empty, and returns whether it did.
+  bool TryPop(T* value);
+
+  // MpmcQueue::Pop()
+  //
+  // Removes and returns the first element, blocking while the queue is empty.
+  T Pop();
+
+  // MpmcQueue::TryPushBatch()
+  //
+  // Appends as many of the `n` elements starting at `first` as there is room
+  // for, up to all of them, constructing each from `*first++`, and returns
+  // how many it appended. The elements are adjacent in the queue.
+  template <typename InputIt>
+  size_t TryPushBatch(InputIt first, size_t n) {
+    return PushSome(&first, n);
+  }
+
+  // MpmcQueue::PushBatch()
+  //
+  // Appends the `n` elements starting at `first`, blocking while the queue is
+  // full. Other threads' elements may come between them.
+  template <typename InputIt>
+  void PushBatch(InputIt first, size_t n);
+
+  // MpmcQueue::TryPopBatch()
+  //
+  // Removes up to `max` elements from the front of the queue, assigns them
+  // in order to `*out++`, and returns how many it removed.
+  template <typename OutputIt>
+  size_t TryPopBatch(OutputIt out, size_t max);
+
+  // MpmcQueue::PopBatch()
+  //
+  // As TryPopBatch(), but blocks while the queue is empty, so that it removes
+  // at least one element if `max > 0`.
+  template <typename OutputIt>
+  size_t PopBatch(OutputIt out, size_t max);
+
+ private:
+  struct Slot {
+    // The position in the ring at which the slot is next to be pushed to,
+    // if it is empty, or that plus one, if it holds an element to be popped.
+    std::atomic<size_t> seq;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* value() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  static size_t RoundUpCapacity(size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) rounded <<= 1;
+    return rounded;
+  }
+
+  Slot& SlotAt(size_t pos) { return slots_[pos & mask_]; }
+
+  // Claims up to `n` adjacent slots to push to, and returns how many it
+  // claimed, and in `*pos`, the position of the first.
+  size_t ClaimPush(size_t n, size_t* pos);
+
+  // Claims up to `n` adjacent slots to pop from, and returns how many it
+  // claimed, and in `*pos`, the position of the first.
+  size_t ClaimPop(size_t n, size_t* pos);
+
+  // Publishes the element constructed in the slot at `pos`.
+  void Publish(size_t pos) {
+    SlotAt(pos).seq.store(pos + 1, std::memory_order_release);
+  }
+
+  // Moves the element out of the slot at `pos`, and frees the slot.
+  T Take(size_t pos) {
+    Slot& slot = SlotAt(pos);
+    T value(std::move(*slot.value()));
+    slot.value()->~T();
+    slot.seq.store(pos + capacity(), std::memory_order_release);
+    return value;
+  }
+
+  // Returns whether a push or pop, respectively, might now succeed.
+  bool MayPush() {
+    const size_t pos = tail_.load(std::memory_order_relaxed);
+    return static_cast<intptr_t>(
+               SlotAt(pos).seq.load(std::memory_order_acquire) - pos) >= 0;
+  }
+  bool MayPop() {
+    const size_t pos = head_.load(std::memory_order_relaxed);
+    return static_cast<intptr_t>(
+               SlotAt(pos).seq.load(std::memory_order_acquire) - (pos + 1)) >=
+           0;
+  }
+
+  // Blocks until `ready()` may have become true, as announced on `event`.
+  void Wait(synchronization_internal::EventCount* event,
+            bool (MpmcQueue::*ready)());
+
+  template <typename InputIt>
+  size_t PushSome(InputIt* first, size_t n);
+
+  const size_t mask_;
+  Slot* const slots_;
+
+  // head_ and tail_ are on cache lines of their own, so that consumers and
+  // producers do not contend for them.
+  char pad0_[ABSL_CACHELINE_SIZE];
+  std::atomic<size_t> head_;  // position of the next slot to pop from
+  char pad1_[ABSL_CACHELINE_SIZE - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail_;  // position of the next slot to push to
+  char pad2_[ABSL_CACHELINE_SIZE - sizeof(std::atomic<size_t>)];
+
+  synchronization_internal::EventCount not_empty_;  // announces pushes
+  synchronization_internal::EventCount not_full_;   // announces pops
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+    : mask_(RoundUpCapacity(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      head_(0),
+      tail_(0) {
+  for (size_t i = 0; i != mask_ + 1; i++) {
+    slots_[i].seq.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() {
+  const size_t tail = tail_.load(std::memory_order_relaxed);
+  for (size_t pos = head_.load(std::memory_order_relaxed); pos != tail;
+       pos++) {
+    SlotAt(pos).value()->~T();
+  }
+  delete[] slots_;
+}
+
+template <typename T>
+size_t MpmcQueue<T>::ClaimPush(size_t n, size_t* pos) {
+  if (n == 0) return 0;
+  size_t p = tail_.load(std::memory_order_relaxed);
+  for (;;) {
+    size_t k = 0;
+    while (k != n &&
+           SlotAt(p + k).seq.load(std::memory_order_acquire) == p + k) {
+      k++;
+    }
+    if (k == 0) {
+      const size_t seq = SlotAt(p).seq.load(std::memory_order_acquire);
+      if (static_cast<intptr_t>(seq - p) < 0) return 0;  // full
+      p = tail_.load(std::memory_order_relaxed);  // another thread pushed
+    } else if (tail_.compare_exchange_weak(p, p + k,
+                                           std::memory_order_relaxed)) {
+      *pos = p;
+      return k;
+    }
+  }
+}
+
+template <typename T>
+size_t MpmcQueue<T>::ClaimPop(size_t n, size_t* pos) {
+  if (n == 0) return 0;
+  size_t p = head_.load(std::memory_order_relaxed);
+  for (;;) {
+    size_t k = 0;
+    while (k != n &&
+           SlotAt(p + k).seq.load(std::memory_order_acquire) == p + k + 1) {
+      k++;
+    }
+    if (k == 0) {
+      const size_t seq = SlotAt(p).seq.load(std::memory_order_acquire);
+      if (static_cast<intptr_t>(seq - (p + 1)) < 0) return 0;  // empty
+      p = head_.load(std::memory_order_relaxed);  // another thread popped
+    } else if (head_.compare_exchange_weak(p, p + k,
+                                           std::memory_order_relaxed)) {
+      *pos = p;
+      return k;
+    }
+  }
+}
+
+template <typename T>
+void MpmcQueue<T>::Wait(synchronization_internal::EventCount* event,
+                        bool (MpmcQueue::*ready)()) {
+  synchronization_internal::EventCount::Waiter w;
+  event->PrepareWait(&w);
+  if ((this->*ready)()) {
+    event->CancelWait(&w);
+  } else {
+    event->CommitWait(&w);
+  }
+}
+
+template <typename T>
+template <typename... Args>
+bool MpmcQueue<T>::TryEmplace(Args&&... args) {
+  size_t pos;
+  if (ClaimPush(1, &pos) == 0) return false;
+  new (SlotAt(pos).value()) T(std::forward<Args>(args)...);
+  Publish(pos);
+  not_empty_.Notify(1);
+  return true;
+}
+
+template <typename T>
+template <typename... Args>
+void MpmcQueue<T>::Emplace(Args&&... args) {
+  size_t pos;
+  while (ClaimPush(1, &pos) == 0) {
+    Wait(&not_full_, &MpmcQueue::MayPush);
+  }
+  new (SlotAt(pos).value()) T(std::forward<Args>(args)...);
+  Publish(pos);
+  not_empty_.Notify(1);
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPop(T* value) {
+  size_t pos;
+  if (ClaimPop(1, &pos) == 0) return false;
+  *value = Take(pos);
+  not_full_.Notify(1);
+  return true;
+}
+
+template <typename T>
+T MpmcQueue<T>::Pop() {
+  size_t pos;
+  while (ClaimPop(1, &pos) == 0) {
+    Wait(&not_empty_, &MpmcQueue::MayPop);
+  }
+  T value = Take(pos);
+  not_full_.Notify(1);
+  return value;
+}
+
+template <typename T>
+template <typename InputIt>
+size_t MpmcQueue<T>::PushSome(InputIt* first, size_t n) {
+  size_t pos;
+  const size_t k = ClaimPush(n, &pos);
+  for (size_t i = 0; i != k; i++) {
+    new (SlotAt(pos + i).value()) T(**first);
+    ++*first;
+    Publish(pos + i);
+  }
+  if (k != 0) not_empty_.Notify(static_cast<int>(k));
+  return k;
+}
+
+template <typename T>
+template <typename InputIt>
+void MpmcQueue<T>::PushBatch(InputIt first, size_t n) {
+  while (n != 0) {
+    const size_t k = PushSome(&first, n);
+    if (k == 0) {
+      Wait(&not_full_, &MpmcQueue::MayPush);
+    }
+    n -= k;
+  }
+}
+
+template <typename T>
+template <typename OutputIt>
+size_t MpmcQueue<T>::TryPopBatch(OutputIt out, size_t max) {
+  size_t pos;
+  const size_t k = ClaimPop(max, &pos);
+  for (size_t i = 0; i != k; i++) {
+    *out = Take(pos + i);
+    ++out;
+  }
+  if (k != 0) not_full_.Notify(static_cast<int>(k));
+  return k;
+}
+
+template <typename T>
+template <typename OutputIt>
+size_t MpmcQueue<T>::PopBatch(OutputIt out, size_t max) {
+  size_t k;
+  while ((k = TryPopBatch(out, max)) == 0 && max != 0) {
+    Wait(&not_empty_, &MpmcQueue::MayPop);
+  }
+  return k;
+}
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_MPMC_QUEUE_H_
@@ -0,0 +1,132 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/synchronization/mpmc_queue.h"
+#include "absl/synchronization/mutex.h"
+
+namespace {
+
+constexpr size_t kCapacity = 1024;
+constexpr int kBatch = 16;
+
+// A std::deque wrapped in an absl::Mutex, for comparison.
+class MutexDequeQueue {
+ public:
+  explicit MutexDequeQueue(size_t capacity) : capacity_(capacity) {}
+
+  void Push(int64_t value) {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &MutexDequeQueue::NotFull));
+    queue_.push_back(value);
+  }
+
+  int64_t Pop() {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &MutexDequeQueue::NotEmpty));
+    int64_t value = queue_.front();
+    queue_.pop_front();
+    return value;
+  }
+
+  void PushBatch(std::vector<int64_t>::const_iterator first, size_t n) {
+    while (n != 0) {
+      absl::MutexLock l(&mu_);
+      mu_.Await(absl::Condition(this, &MutexDequeQueue::NotFull));
+      for (; n != 0 && queue_.size() != capacity_; n--) {
+        queue_.push_back(*first++);
+      }
+    }
+  }
+
+  size_t PopBatch(std::vector<int64_t>::iterator out, size_t max) {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &MutexDequeQueue::NotEmpty));
+    size_t n = 0;
+    for (; n != max && !queue_.empty(); n++) {
+      *out++ = queue_.front();
+      queue_.pop_front();
+    }
+    return n;
+  }
+
+ private:
+  bool NotFull() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.size() != capacity_;
+  }
+  bool NotEmpty() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !queue_.empty();
+  }
+
+  const size_t capacity_;
+  absl::Mutex mu_;
+  std::deque<int64_t> queue_ GUARDED_BY(mu_);
+};
+
+// Half of the threads push one element per iteration, and half pop one.
+template <typename Queue>
+void BM_PushPop(benchmark::State& state) {
+  static Queue* queue;
+  if (state.thread_index == 0) queue = new Queue(kCapacity);
+  const bool producer = state.thread_index % 2 == 0;
+  int64_t sum = 0;
+  for (auto _ : state) {
+    if (producer) {
+      queue->Push(sum++);
+    } else {
+      sum += queue->Pop();
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index == 0) delete queue;
+}
+
+// As BM_PushPop, but each iteration pushes or pops kBatch elements with
+// the batch operations.
+template <typename Queue>
+void BM_PushPopBatch(benchmark::State& state) {
+  static Queue* queue;
+  if (state.thread_index == 0) queue = new Queue(kCapacity);
+  const bool producer = state.thread_index % 2 == 0;
+  std::vector<int64_t> batch(kBatch);
+  for (auto _ : state) {
+    if (producer) {
+      queue->PushBatch(batch.cbegin(), batch.size());
+    } else {
+      for (size_t n = 0; n != batch.size();) {
+        n += queue->PopBatch(batch.begin() + n, batch.size() - n);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+  if (state.thread_index == 0) delete queue;
+}
+
+void SetUpPushPop(benchmark::internal::Benchmark* bm) {
+  bm->ThreadRange(2, 64);
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_PushPop, MutexDequeQueue)->Apply(SetUpPushPop);
+BENCHMARK_TEMPLATE(BM_PushPop, absl::MpmcQueue<int64_t>)->Apply(SetUpPushPop);
+BENCHMARK_TEMPLATE(BM_PushPopBatch, MutexDequeQueue)->Apply(SetUpPushPop);
+BENCHMARK_TEMPLATE(BM_PushPopBatch, absl::MpmcQueue<int64_t>)
+    ->Apply(SetUpPushPop);
+
+}  // namespace
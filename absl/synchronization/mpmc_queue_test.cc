@@ -0,0 +1,206 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/mpmc_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(MpmcQueue, CapacityIsRoundedUpToPowerOfTwo) {
+  EXPECT_EQ(absl::MpmcQueue<int>(0).capacity(), 2);
+  EXPECT_EQ(absl::MpmcQueue<int>(1).capacity(), 2);
+  EXPECT_EQ(absl::MpmcQueue<int>(5).capacity(), 8);
+  EXPECT_EQ(absl::MpmcQueue<int>(64).capacity(), 64);
+}
+
+TEST(MpmcQueue, TryPushAndTryPopAreFifo) {
+  absl::MpmcQueue<int> queue(4);
+  int value;
+  EXPECT_FALSE(queue.TryPop(&value));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPush(i));
+  }
+  EXPECT_FALSE(queue.TryPush(4));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.TryPop(&value));
+
+  // Wrap around the ring a few times.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(queue.TryPush(i));
+    EXPECT_TRUE(queue.TryPush(i + 100));
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, i);
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, i + 100);
+  }
+}
+
+TEST(MpmcQueue, MoveOnlyElements) {
+  absl::MpmcQueue<std::unique_ptr<int>> queue(2);
+  std::unique_ptr<int> p(new int(7));
+  EXPECT_TRUE(queue.TryPush(std::move(p)));
+  EXPECT_TRUE(queue.TryEmplace(new int(8)));
+  std::unique_ptr<int> rejected(new int(9));
+  EXPECT_FALSE(queue.TryPush(std::move(rejected)));
+  ASSERT_NE(rejected, nullptr);  // not moved from, as it was not appended
+  EXPECT_EQ(*queue.Pop(), 7);
+  std::unique_ptr<int> q;
+  ASSERT_TRUE(queue.TryPop(&q));
+  EXPECT_EQ(*q, 8);
+}
+
+TEST(MpmcQueue, DestructorDestroysElements) {
+  auto counted = std::make_shared<int>(0);
+  {
+    absl::MpmcQueue<std::shared_ptr<int>> queue(4);
+    queue.Push(counted);
+    queue.Push(counted);
+    std::shared_ptr<int> popped;
+    ASSERT_TRUE(queue.TryPop(&popped));
+    queue.Push(counted);
+    EXPECT_EQ(counted.use_count(), 4);
+  }
+  EXPECT_EQ(counted.use_count(), 1);
+}
+
+TEST(MpmcQueue, Batches) {
+  absl::MpmcQueue<int> queue(4);
+  const std::vector<int> in = {1, 2, 3, 4, 5, 6};
+  // Only as many as there is room for are pushed.
+  EXPECT_EQ(queue.TryPushBatch(in.begin(), in.size()), 4);
+  EXPECT_EQ(queue.TryPushBatch(in.begin(), 1), 0);
+
+  std::vector<int> out;
+  EXPECT_EQ(queue.TryPopBatch(std::back_inserter(out), 3), 3);
+  EXPECT_THAT(out, ElementsAre(1, 2, 3));
+  EXPECT_EQ(queue.TryPushBatch(in.begin() + 4, 2), 2);
+  EXPECT_EQ(queue.PopBatch(std::back_inserter(out), 10), 3);
+  EXPECT_THAT(out, ElementsAre(1, 2, 3, 4, 5, 6));
+  EXPECT_EQ(queue.TryPopBatch(std::back_inserter(out), 10), 0);
+  EXPECT_EQ(queue.TryPopBatch(std::back_inserter(out), 0), 0);
+}
+
+TEST(MpmcQueue, PopBlocksUntilPush) {
+  absl::MpmcQueue<int> queue(2);
+  absl::Notification popped;
+  int value = 0;
+  std::thread consumer([&] {
+    value = queue.Pop();
+    popped.Notify();
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_FALSE(popped.HasBeenNotified());
+  queue.Push(42);
+  consumer.join();
+  EXPECT_EQ(value, 42);
+}
+
+TEST(MpmcQueue, PushBlocksUntilPop) {
+  absl::MpmcQueue<int> queue(2);
+  queue.Push(1);
+  queue.Push(2);
+  absl::Notification pushed;
+  std::thread producer([&] {
+    queue.Push(3);
+    pushed.Notify();
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_FALSE(pushed.HasBeenNotified());
+  EXPECT_EQ(queue.Pop(), 1);
+  producer.join();
+  EXPECT_EQ(queue.Pop(), 2);
+  EXPECT_EQ(queue.Pop(), 3);
+}
+
+// Producers and consumers, some of them using batches, exchange kItems
+// distinct values through a small queue, so that both often block.
+TEST(MpmcQueue, ManyProducersAndConsumers) {
+  constexpr int kThreads = 4;
+  constexpr int kItemsPerProducer = 20000;
+  constexpr int kItems = kThreads * kItemsPerProducer;
+  constexpr int kBatch = 7;
+  absl::MpmcQueue<int> queue(16);
+  std::vector<std::atomic<int>> seen(kItems);
+  for (std::atomic<int>& s : seen) s.store(0);
+  std::atomic<int> remaining(kItems);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&queue, t] {
+      std::vector<int> batch;
+      for (int i = 0; i < kItemsPerProducer; ++i) {
+        const int value = t * kItemsPerProducer + i;
+        if (t % 2 == 0) {
+          queue.Push(value);
+        } else {
+          batch.push_back(value);
+          if (batch.size() == kBatch || i == kItemsPerProducer - 1) {
+            queue.PushBatch(batch.begin(), batch.size());
+            batch.clear();
+          }
+        }
+      }
+    });
+    threads.emplace_back([&queue, &seen, &remaining, t] {
+      std::vector<int> batch;
+      for (;;) {
+        batch.clear();
+        if (t % 2 == 0) {
+          batch.push_back(queue.Pop());
+        } else {
+          queue.PopBatch(std::back_inserter(batch), kBatch);
+        }
+        int stops = 0;
+        for (int value : batch) {
+          if (value < 0) {
+            stops++;
+            continue;
+          }
+          seen[value].fetch_add(1);
+          if (remaining.fetch_sub(1) == 1) {
+            // Last item: stop all consumers.
+            for (int i = 0; i < kThreads; ++i) queue.Push(-1);
+          }
+        }
+        if (stops != 0) {
+          // Leave the stops taken in the same batch for other consumers.
+          for (int i = 1; i < stops; ++i) queue.Push(-1);
+          return;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < kItems; ++i) {
+    EXPECT_EQ(seen[i].load(), 1) << i;
+  }
+}
+
+}  // namespace
@@ -36,12 +36,17 @@
 #include <algorithm>
 #include <atomic>
 #include <cinttypes>
+#include <limits>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "absl/base/attributes.h"
 #include "absl/base/config.h"
 #include "absl/base/dynamic_annotations.h"
+#include "absl/base/internal/adaptive_spin.h"
 #include "absl/base/internal/atomic_hook.h"
+#include "absl/base/internal/bits.h"
 #include "absl/base/internal/cycleclock.h"
 #include "absl/base/internal/hide_ptr.h"
 #include "absl/base/internal/low_level_alloc.h"
@@ -84,6 +89,28 @@ ABSL_CONST_INIT std::atomic<OnDeadlockCycle> synch_deadlock_detection(
     kDeadlockDetectionDefault);
 ABSL_CONST_INIT std::atomic<bool> synch_check_invariants(false);
 
+// One in this many blocking acquisitions is sampled by the contention
+// profiler; zero or less disables it.
+ABSL_CONST_INIT std::atomic<int> contention_profiling_rate(0);
+
+// Whether the waits of all Mutexes are recorded in latency histograms; see
+// EnableMutexLatencyHistograms().
+ABSL_CONST_INIT std::atomic<bool> mutex_latency_histograms_enabled(false);
+
+// In all build modes, one in this many acquisitions made while holding
+// another Mutex adds lock-order edges to the deadlock graph; zero or less
+// disables sampling, leaving full deadlock detection in debug mode.
+ABSL_CONST_INIT std::atomic<int> deadlock_sampling_rate(0);
+
+// Incremented whenever the deadlock sampling rate is changed, after which each
+// thread discards the set of locks it tracked, which may be out of date.
+ABSL_CONST_INIT std::atomic<uint32_t> deadlock_tracking_generation(0);
+
+// Set once sampled deadlock detection has added a Mutex to the deadlock
+// graph; from then on, destroyed Mutexes must be removed from it in all build
+// modes.
+ABSL_CONST_INIT std::atomic<bool> deadlock_graph_sampled(false);
+
 // ------------------------------------------ spinlock support
 
 // Make sure read-only globals used in the Mutex code are contained on the
@@ -135,6 +162,10 @@ void RegisterSymbolizer(bool (*fn)(const void *pc, char *out, int out_size)) {
   symbolizer.Store(fn);
 }
 
+void EnableMutexAdaptiveSpinning(bool enabled) {
+  base_internal::SetAdaptiveSpinning(enabled);
+}
+
 // spinlock delay on iteration c.  Returns new c.
 namespace {
   enum DelayMode { AGGRESSIVE, GENTLE };
@@ -206,6 +237,100 @@ static absl::base_internal::SpinLock deadlock_graph_mu(
 static GraphCycles *deadlock_graph GUARDED_BY(deadlock_graph_mu)
     PT_GUARDED_BY(deadlock_graph_mu);
 
+//------------------------------------------------------------------
+// Latency histograms.
+
+// Each power of two is split into this many buckets.
+static const int kLatencySubBucketBits = 2;
+static const int kLatencySubBuckets = 1 << kLatencySubBucketBits;
+// Enough buckets for any non-negative int64_t.
+static const int kNumLatencyBuckets =
+    (64 - kLatencySubBucketBits) << kLatencySubBucketBits;
+
+// Returns the index of the bucket holding "cycles": values below
+// kLatencySubBuckets have a bucket each, and larger ones are bucketed by their
+// highest set bit and the kLatencySubBucketBits bits below it.
+static int LatencyBucket(int64_t cycles) {
+  if (cycles < kLatencySubBuckets) {
+    return cycles < 0 ? 0 : static_cast<int>(cycles);
+  }
+  const int msb =
+      63 - base_internal::CountLeadingZeros64(static_cast<uint64_t>(cycles));
+  return ((msb - kLatencySubBucketBits + 1) << kLatencySubBucketBits) |
+         static_cast<int>((cycles >> (msb - kLatencySubBucketBits)) &
+                          (kLatencySubBuckets - 1));
+}
+
+// Returns the smallest value in bucket "b"; the inverse of LatencyBucket().
+static int64_t LatencyBucketLowerBound(int b) {
+  if (b < kLatencySubBuckets) return b;
+  const int msb = (b >> kLatencySubBucketBits) + kLatencySubBucketBits - 1;
+  return static_cast<int64_t>(kLatencySubBuckets |
+                              (b & (kLatencySubBuckets - 1)))
+         << (msb - kLatencySubBucketBits);
+}
+
+struct LatencyDistribution {
+  std::atomic<int64_t> count[kNumLatencyBuckets];
+  std::atomic<int64_t> total_cycles;
+};
+
+// The histograms for one name.  They are never freed, so that SynchEvents
+// and snapshots can use them without locking.
+struct LatencyHistograms {
+  LatencyHistograms *next;  // constant once published
+  LatencyDistribution wait;
+  LatencyDistribution hold;
+  char name[1];  // actually longer---null-terminated std::string
+};
+
+static absl::base_internal::SpinLock latency_histograms_mu(
+    absl::base_internal::kLinkerInitialized);
+// serializes the creation of histograms
+
+// The list of all histograms, newest first.
+ABSL_CONST_INIT static std::atomic<LatencyHistograms *> latency_histograms(
+    nullptr);
+
+// Returns the histograms for "name", creating them if needed.
+static LatencyHistograms *GetLatencyHistograms(const char *name) {
+  latency_histograms_mu.Lock();
+  LatencyHistograms *h = latency_histograms.load(std::memory_order_relaxed);
+  while (h != nullptr && strcmp(h->name, name) != 0) {
+    h = h->next;
+  }
+  if (h == nullptr) {
+    size_t l = strlen(name);
+    h = reinterpret_cast<LatencyHistograms *>(
+        base_internal::LowLevelAlloc::Alloc(sizeof(*h) + l));
+    memset(static_cast<void *>(h), 0, sizeof(*h));
+    strcpy(h->name, name);  // NOLINT(runtime/printf)
+    h->next = latency_histograms.load(std::memory_order_relaxed);
+    latency_histograms.store(h, std::memory_order_release);
+  }
+  latency_histograms_mu.Unlock();
+  return h;
+}
+
+// The histograms for the Mutexes that have no name, or null until needed.
+ABSL_CONST_INIT static std::atomic<LatencyHistograms *>
+    unnamed_latency_histograms(nullptr);
+
+static LatencyHistograms *UnnamedLatencyHistograms() {
+  LatencyHistograms *h =
+      unnamed_latency_histograms.load(std::memory_order_acquire);
+  if (h == nullptr) {
+    h = GetLatencyHistograms("");
+    unnamed_latency_histograms.store(h, std::memory_order_release);
+  }
+  return h;
+}
+
+static void RecordLatency(LatencyDistribution *d, int64_t cycles) {
+  d->count[LatencyBucket(cycles)].fetch_add(1, std::memory_order_relaxed);
+  d->total_cycles.fetch_add(cycles, std::memory_order_relaxed);
+}
+
 //------------------------------------------------------------------
 // An event mechanism for debugging mutex use.
 // It also allows mutexes to be given names for those who can't handle
@@ -273,6 +398,8 @@ static absl::base_internal::SpinLock synch_event_mu(
 // Can't be too small, as it's used for deadlock detection information.
 static const uint32_t kNSynchEvent = 1031;
 
+struct MutexLatency;
+
 static struct SynchEvent {     // this is a trivial hash table for the events
   // struct is freed when refcount reaches 0
   int refcount GUARDED_BY(synch_event_mu);
@@ -290,10 +417,99 @@ static struct SynchEvent {     // this is a trivial hash table for the events
   void *arg;            // first arg to (*invariant)()
   bool log;             // logging turned on
 
+  // The latency state of a Mutex enabled with EnableLatencyHistograms(), or
+  // null.
+  MutexLatency *latency GUARDED_BY(synch_event_mu);
+  // The histograms for "name" in which the waits of a Mutex without latency
+  // state are recorded if those of all Mutexes are; null until first needed.
+  LatencyHistograms *wait_histograms GUARDED_BY(synch_event_mu);
+
   // Constant after initialization
   char name[1];         // actually longer---null-terminated std::string
 } *synch_event[kNSynchEvent] GUARDED_BY(synch_event_mu);
 
+// The latency state of a Mutex enabled with EnableLatencyHistograms().  It is
+// found by address without locking, so that recording latencies does not
+// serialize the Mutexes that do it.  It is never freed; a Mutex's destructor
+// releases it for reuse by another Mutex.
+struct MutexLatency {
+  // The Mutex at this address owns the state, or none if zero.  Set under
+  // latency_histograms_mu, and cleared when the Mutex is destroyed.
+  std::atomic<uintptr_t> masked_addr;
+  MutexLatency *next;  // constant once published
+  std::atomic<LatencyHistograms *> histograms;
+  // Whether the Mutex also needs the events that go through its SynchEvent,
+  // such as for logging or invariant checking.
+  std::atomic<bool> other_events;
+  // The number of threads holding the Mutex, as seen by the events, and the
+  // time at which that number last became nonzero.
+  std::atomic<int> holders;
+  std::atomic<int64_t> hold_start;
+};
+
+// A hash table of chains of MutexLatency, to which entries are only added.
+ABSL_CONST_INIT static std::atomic<MutexLatency *> mutex_latency[kNSynchEvent];
+
+// Returns the latency state of the Mutex at "mu", or null.
+static MutexLatency *FindMutexLatency(const void *mu) {
+  uint32_t h = reinterpret_cast<intptr_t>(mu) % kNSynchEvent;
+  const uintptr_t masked_addr = base_internal::HidePtr(mu);
+  for (MutexLatency *l = mutex_latency[h].load(std::memory_order_acquire);
+       l != nullptr; l = l->next) {
+    if (l->masked_addr.load(std::memory_order_acquire) == masked_addr) {
+      return l;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the latency state of the Mutex at "mu", recording in "histograms",
+// creating it or reusing a released one if needed.
+static MutexLatency *GetMutexLatency(const void *mu,
+                                     LatencyHistograms *histograms) {
+  uint32_t h = reinterpret_cast<intptr_t>(mu) % kNSynchEvent;
+  const uintptr_t masked_addr = base_internal::HidePtr(mu);
+  latency_histograms_mu.Lock();
+  MutexLatency *l = FindMutexLatency(mu);
+  if (l == nullptr) {
+    for (l = mutex_latency[h].load(std::memory_order_relaxed);
+         l != nullptr && l->masked_addr.load(std::memory_order_relaxed) != 0;
+         l = l->next) {
+    }
+    if (l == nullptr) {
+      l = reinterpret_cast<MutexLatency *>(
+          base_internal::LowLevelAlloc::Alloc(sizeof(*l)));
+      memset(static_cast<void *>(l), 0, sizeof(*l));
+      l->next = mutex_latency[h].load(std::memory_order_relaxed);
+      mutex_latency[h].store(l, std::memory_order_release);
+    }
+    l->histograms.store(histograms, std::memory_order_relaxed);
+    l->other_events.store(false, std::memory_order_relaxed);
+    l->holders.store(0, std::memory_order_relaxed);
+    l->hold_start.store(0, std::memory_order_relaxed);
+    l->masked_addr.store(masked_addr, std::memory_order_release);
+  } else {
+    l->histograms.store(histograms, std::memory_order_release);
+  }
+  latency_histograms_mu.Unlock();
+  return l;
+}
+
+// Releases "l" for reuse, when its Mutex is destroyed.
+static void ReleaseMutexLatency(MutexLatency *l) {
+  l->masked_addr.store(0, std::memory_order_release);
+}
+
+// Tells the latency state of the Mutex with SynchEvent "e", if any, that the
+// Mutex now needs the events that go through its SynchEvent.
+static void NoteOtherSynchEvents(SynchEvent *e) {
+  synch_event_mu.Lock();
+  if (e->latency != nullptr) {
+    e->latency->other_events.store(true, std::memory_order_release);
+  }
+  synch_event_mu.Unlock();
+}
+
 // Ensure that the object at "addr" has a SynchEvent struct associated with it,
 // set "bits" in the word there (waiting until lockbit is clear before doing
 // so), and return a refcounted reference that will remain valid until
@@ -324,6 +540,8 @@ static SynchEvent *EnsureSynchEvent(std::atomic<intptr_t> *addr,
     e->invariant = nullptr;
     e->arg = nullptr;
     e->log = false;
+    e->latency = nullptr;
+    e->wait_histograms = nullptr;
     strcpy(e->name, name);  // NOLINT(runtime/printf)
     e->next = synch_event[h];
     AtomicSetBits(addr, bits, lockbit);
@@ -369,6 +587,9 @@ static void ForgetSynchEvent(std::atomic<intptr_t> *addr, intptr_t bits,
   if (e != nullptr) {
     *pe = e->next;
     del = (--(e->refcount) == 0);
+    if (e->latency != nullptr) {
+      ReleaseMutexLatency(e->latency);
+    }
   }
   AtomicClearBits(addr, bits, lockbit);
   synch_event_mu.Unlock();
@@ -377,17 +598,24 @@ static void ForgetSynchEvent(std::atomic<intptr_t> *addr, intptr_t bits,
   }
 }
 
-// Return a refcounted reference to the SynchEvent of the object at address
-// "addr", if any.  The pointer returned is valid until the UnrefSynchEvent() is
-// called.
-static SynchEvent *GetSynchEvent(const void *addr) {
+// Return the SynchEvent of the object at address "addr", if any.
+static SynchEvent *FindSynchEventLocked(const void *addr)
+    EXCLUSIVE_LOCKS_REQUIRED(synch_event_mu) {
   uint32_t h = reinterpret_cast<intptr_t>(addr) % kNSynchEvent;
   SynchEvent *e;
-  synch_event_mu.Lock();
   for (e = synch_event[h];
        e != nullptr && e->masked_addr != base_internal::HidePtr(addr);
        e = e->next) {
   }
+  return e;
+}
+
+// Return a refcounted reference to the SynchEvent of the object at address
+// "addr", if any.  The pointer returned is valid until the UnrefSynchEvent() is
+// called.
+static SynchEvent *GetSynchEvent(const void *addr) {
+  synch_event_mu.Lock();
+  SynchEvent *e = FindSynchEventLocked(addr);
   if (e != nullptr) {
     e->refcount++;
   }
@@ -395,13 +623,105 @@ static SynchEvent *GetSynchEvent(const void *addr) {
   return e;
 }
 
+// Records in the histograms of the Mutex with latency state "l" the wait and
+// hold that event "ev", which is happening now, ends.  "wait_start" is the
+// time at which a thread that has acquired the Mutex began to wait for it, or
+// zero if the wait is not to be recorded.
+static void RecordMutexLatency(MutexLatency *l, int ev, int64_t wait_start) {
+  bool acquire;
+  switch (ev) {
+    case SYNCH_EV_TRYLOCK_SUCCESS:
+    case SYNCH_EV_READERTRYLOCK_SUCCESS:
+    case SYNCH_EV_LOCK_RETURNING:
+    case SYNCH_EV_READERLOCK_RETURNING:
+      acquire = true;
+      break;
+    case SYNCH_EV_UNLOCK:
+    case SYNCH_EV_READERUNLOCK:
+      acquire = false;
+      break;
+    default:
+      return;
+  }
+  LatencyHistograms *h = l->histograms.load(std::memory_order_acquire);
+  const int64_t now = base_internal::CycleClock::Now();
+  if (acquire) {
+    if (wait_start != 0) {
+      RecordLatency(&h->wait, std::max<int64_t>(now - wait_start, 0));
+    }
+    if (l->holders.fetch_add(1, std::memory_order_acq_rel) == 0) {
+      l->hold_start.store(now, std::memory_order_relaxed);
+    }
+    return;
+  }
+  // A Mutex enabled while held sees releases that it saw no acquisition for.
+  int holders = l->holders.load(std::memory_order_relaxed);
+  do {
+    if (holders == 0) return;
+  } while (!l->holders.compare_exchange_weak(holders, holders - 1,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_relaxed));
+  // The thread that made "holders" nonzero set "hold_start" before releasing
+  // its hold, so the last release sees it.
+  if (holders == 1) {
+    RecordLatency(&h->hold,
+                  std::max<int64_t>(
+                      now - l->hold_start.load(std::memory_order_relaxed), 0));
+  }
+}
+
 // Called when an event "ev" occurs on a Mutex of CondVar "obj"
-// if event recording is on
-static void PostSynchEvent(void *obj, int ev) {
-  SynchEvent *e = GetSynchEvent(obj);
+// if event recording is on.  For the events that end a wait to acquire a
+// Mutex, "wait_start" is as for RecordMutexLatency().
+static void PostSynchEvent(void *obj, int ev, int64_t wait_start = 0) {
+  // Mutexes that only record latencies do so without taking synch_event_mu.
+  MutexLatency *latency = FindMutexLatency(obj);
+  if (latency != nullptr) {
+    RecordMutexLatency(latency, ev, wait_start);
+    if (!latency->other_events.load(std::memory_order_acquire)) {
+      return;
+    }
+    wait_start = 0;  // recorded above
+  }
+  if (wait_start != 0 &&
+      !mutex_latency_histograms_enabled.load(std::memory_order_relaxed)) {
+    wait_start = 0;
+  }
+  LatencyHistograms *wait_histograms = nullptr;
+  bool lookup_wait_histograms = false;
   // logging is on if event recording is on and either there's no event struct,
   // or it explicitly says to log
-  if (e == nullptr || e->log) {
+  bool log = true;
+  // A reference to the event struct is taken only if it is used below.
+  SynchEvent *e = nullptr;
+  synch_event_mu.Lock();
+  SynchEvent *found = FindSynchEventLocked(obj);
+  if (found != nullptr) {
+    if (wait_start != 0) {
+      wait_histograms = found->wait_histograms;
+      lookup_wait_histograms = wait_histograms == nullptr;
+    }
+    log = found->log;
+    if (log || found->invariant != nullptr || lookup_wait_histograms) {
+      e = found;
+      e->refcount++;
+    }
+  }
+  synch_event_mu.Unlock();
+  if (lookup_wait_histograms) {
+    // Done once per Mutex, outside synch_event_mu, which GetLatencyHistograms()
+    // must not be called under.
+    wait_histograms = GetLatencyHistograms(e->name);
+    synch_event_mu.Lock();
+    e->wait_histograms = wait_histograms;
+    synch_event_mu.Unlock();
+  }
+  if (wait_histograms != nullptr) {
+    RecordLatency(&wait_histograms->wait,
+                  std::max<int64_t>(
+                      base_internal::CycleClock::Now() - wait_start, 0));
+  }
+  if (log) {
     void *pcs[40];
     int n = absl::GetStackTrace(pcs, ABSL_ARRAYSIZE(pcs), 1);
     // A buffer with enough space for the ASCII for all the PCs, even on a
@@ -423,6 +743,20 @@ static void PostSynchEvent(void *obj, int ev) {
 
 //------------------------------------------------------------------
 
+// Maximum depth of the stack traces kept by the contention profiler.
+static const int kMaxContentionStackDepth = 32;
+
+// The stacks of one sampled contention event. It lives on the waiting
+// thread's stack, and the holder's half is filled in by the thread that wakes
+// the waiter (see RecordContentionHolder()).
+struct ContentionStacks {
+  bool blocked = false;   // the waiter has captured its stack and blocked
+  int waiter_depth = 0;
+  int holder_depth = 0;
+  void *waiter[kMaxContentionStackDepth];
+  void *holder[kMaxContentionStackDepth];
+};
+
 // The SynchWaitParams struct encapsulates the way in which a thread is waiting:
 // whether it has a timeout, the condition, exclusive/shared, and whether a
 // condition variable wait has an associated Mutex (as opposed to another
@@ -448,7 +782,8 @@ struct SynchWaitParams {
         cvmu(cvmu_arg),
         thread(thread_arg),
         cv_word(cv_word_arg),
-        contention_start_cycles(base_internal::CycleClock::Now()) {}
+        contention_start_cycles(base_internal::CycleClock::Now()),
+        contention_sample(nullptr) {}
 
   const Mutex::MuHow how;  // How this thread needs to wait.
   const Condition *cond;  // The condition that this thread is waiting for.
@@ -466,11 +801,17 @@ struct SynchWaitParams {
 
   int64_t contention_start_cycles;  // Time (in cycles) when this thread started
                                   // to contend for the mutex.
+
+  // If not null, this wait is sampled by the contention profiler, and the
+  // thread that wakes this one records its stack here.
+  ContentionStacks *contention_sample;
 };
 
 struct SynchLocksHeld {
   int n;              // number of valid entries in locks[]
   bool overflow;      // true iff we overflowed the array at some point
+  uint32_t generation;    // deadlock_tracking_generation when last checked
+  int sample_countdown;   // acquisitions until the next sampled one
   struct {
     Mutex *mu;        // lock acquired
     int32_t count;      // times acquired
@@ -487,11 +828,294 @@ struct SynchLocksHeld {
 static PerThreadSynch *const kPerThreadSynchNull =
   reinterpret_cast<PerThreadSynch *>(1);
 
+//------------------------------------------------------------------
+// Contention profiling
+
+static absl::base_internal::SpinLock contention_profile_mu(
+    absl::base_internal::kLinkerInitialized);
+// protects contention_profile and contention_profile_size
+
+// Hash table size; should be prime.
+static const uint32_t kNContentionBuckets = 1031;
+// New stack pairs are dropped once this many are recorded.
+static const int kMaxContentionEntries = 4096;
+
+static struct ContentionEntry {  // a trivial hash table keyed by stacks
+  ContentionEntry *next;  // buckets have linear, 0-terminated chains
+  uint64_t hash;
+  uintptr_t masked_mu;    // the most recently sampled Mutex
+  int64_t count;
+  int64_t wait_cycles;
+  int waiter_depth;
+  int holder_depth;
+  void *waiter[kMaxContentionStackDepth];
+  void *holder[kMaxContentionStackDepth];
+} *contention_profile[kNContentionBuckets] GUARDED_BY(contention_profile_mu);
+static int contention_profile_size GUARDED_BY(contention_profile_mu) = 0;
+
+// Returns whether a blocking acquisition that started at `start_cycles`
+// should be sampled.
+static bool ShouldSampleContention(int64_t start_cycles) {
+  int rate = contention_profiling_rate.load(std::memory_order_relaxed);
+  if (rate <= 1) return rate == 1;
+  // The low bits of the cycle counter are close to random; mix them into the
+  // high half so that the choice does not depend on the counter's step.
+  uint64_t h = static_cast<uint64_t>(start_cycles) * 0x9E3779B97F4A7C15u;
+  return (h >> 32) % static_cast<uint32_t>(rate) == 0;
+}
+
+static uint64_t HashContentionStacks(const ContentionStacks &stacks) {
+  uint64_t h = static_cast<uint64_t>(stacks.waiter_depth) << 32 |
+               static_cast<uint32_t>(stacks.holder_depth);
+  for (int i = 0; i != stacks.waiter_depth; i++) {
+    h = (h ^ reinterpret_cast<uintptr_t>(stacks.waiter[i])) *
+        0x9E3779B97F4A7C15u;
+  }
+  for (int i = 0; i != stacks.holder_depth; i++) {
+    h = (h ^ reinterpret_cast<uintptr_t>(stacks.holder[i])) *
+        0x9E3779B97F4A7C15u;
+  }
+  return h ^ (h >> 29);
+}
+
+// Records the stack of the calling thread, which is about to block in
+// LockSlowLoop(), as the waiter stack of "stacks".
+ABSL_ATTRIBUTE_NOINLINE static void RecordContentionWaiter(
+    ContentionStacks *stacks) {
+  stacks->waiter_depth =
+      absl::GetStackTrace(stacks->waiter, kMaxContentionStackDepth, 1);
+  stacks->blocked = true;
+}
+
+// Records the stack of the calling thread, which has released a Mutex and is
+// about to wake the threads on "wake_list", as the holder stack of each of
+// them that is sampled.
+ABSL_ATTRIBUTE_NOINLINE static void RecordContentionHolder(
+    PerThreadSynch *wake_list) {
+  void *pcs[kMaxContentionStackDepth];
+  int depth = -1;
+  for (PerThreadSynch *w = wake_list; w != kPerThreadSynchNull; w = w->next) {
+    ContentionStacks *stacks = w->waitp->contention_sample;
+    if (stacks != nullptr) {
+      if (depth < 0) {
+        depth = absl::GetStackTrace(pcs, kMaxContentionStackDepth, 1);
+      }
+      memcpy(stacks->holder, pcs, depth * sizeof(pcs[0]));
+      stacks->holder_depth = depth;
+    }
+  }
+}
+
+// Adds one sample of "wait_cycles" of contention on "mu" to the profile.
+static void RecordContention(const Mutex *mu, int64_t wait_cycles,
+                             const ContentionStacks &stacks) {
+  const uint64_t hash = HashContentionStacks(stacks);
+  const uint32_t bucket = hash % kNContentionBuckets;
+  contention_profile_mu.Lock();
+  ContentionEntry *e = contention_profile[bucket];
+  for (; e != nullptr; e = e->next) {
+    if (e->hash == hash && e->waiter_depth == stacks.waiter_depth &&
+        e->holder_depth == stacks.holder_depth &&
+        memcmp(e->waiter, stacks.waiter,
+               stacks.waiter_depth * sizeof(e->waiter[0])) == 0 &&
+        memcmp(e->holder, stacks.holder,
+               stacks.holder_depth * sizeof(e->holder[0])) == 0) {
+      break;
+    }
+  }
+  if (e == nullptr && contention_profile_size < kMaxContentionEntries) {
+    e = static_cast<ContentionEntry *>(
+        base_internal::LowLevelAlloc::Alloc(sizeof(*e)));
+    e->hash = hash;
+    e->count = 0;
+    e->wait_cycles = 0;
+    e->waiter_depth = stacks.waiter_depth;
+    e->holder_depth = stacks.holder_depth;
+    memcpy(e->waiter, stacks.waiter,
+           stacks.waiter_depth * sizeof(e->waiter[0]));
+    memcpy(e->holder, stacks.holder,
+           stacks.holder_depth * sizeof(e->holder[0]));
+    e->next = contention_profile[bucket];
+    contention_profile[bucket] = e;
+    contention_profile_size++;
+  }
+  if (e != nullptr) {
+    e->masked_mu = base_internal::HidePtr(mu);
+    e->count++;
+    e->wait_cycles += wait_cycles;
+  }
+  contention_profile_mu.Unlock();
+}
+
+void SetMutexContentionProfilingRate(int n) {
+  contention_profiling_rate.store(n, std::memory_order_relaxed);
+}
+
+std::vector<MutexContentionSample> GetMutexContentionSamples() {
+  // The spinlock is taken on the Mutex slow path, so memory for the copy is
+  // only allocated while it is not held.
+  std::vector<ContentionEntry> entries;
+  for (;;) {
+    contention_profile_mu.Lock();
+    size_t size = contention_profile_size;
+    contention_profile_mu.Unlock();
+    entries.resize(size);
+    contention_profile_mu.Lock();
+    if (static_cast<size_t>(contention_profile_size) <= entries.size()) {
+      size = 0;
+      for (uint32_t i = 0; i != kNContentionBuckets; i++) {
+        for (ContentionEntry *e = contention_profile[i]; e != nullptr;
+             e = e->next) {
+          entries[size++] = *e;
+        }
+      }
+      contention_profile_mu.Unlock();
+      entries.resize(size);
+      break;
+    }
+    contention_profile_mu.Unlock();
+  }
+
+  std::vector<MutexContentionSample> samples(entries.size());
+  for (size_t i = 0; i != entries.size(); i++) {
+    const ContentionEntry &e = entries[i];
+    MutexContentionSample &sample = samples[i];
+    sample.mutex = base_internal::UnhidePtr<const void>(e.masked_mu);
+    sample.count = e.count;
+    sample.wait_cycles = e.wait_cycles;
+    sample.waiter_stack.assign(e.waiter, e.waiter + e.waiter_depth);
+    sample.holder_stack.assign(e.holder, e.holder + e.holder_depth);
+  }
+  return samples;
+}
+
+std::string GetMutexContentionProfile(MutexContentionStack stack) {
+  char buf[64];
+  std::string out = "--- contention\n";
+  snprintf(buf, sizeof(buf), "cycles/second = %" PRId64 "\n",
+           static_cast<int64_t>(base_internal::CycleClock::Frequency()));
+  out += buf;
+  snprintf(buf, sizeof(buf), "sampling period = %d\n",
+           std::max(contention_profiling_rate.load(std::memory_order_relaxed),
+                    1));
+  out += buf;
+  for (const MutexContentionSample &sample : GetMutexContentionSamples()) {
+    const std::vector<void *> &pcs = stack == MutexContentionStack::kWaiter
+                                         ? sample.waiter_stack
+                                         : sample.holder_stack;
+    if (pcs.empty()) continue;
+    snprintf(buf, sizeof(buf), "%" PRId64 " %" PRId64 " @", sample.wait_cycles,
+             sample.count);
+    out += buf;
+    for (void *pc : pcs) {
+      snprintf(buf, sizeof(buf), " 0x%" PRIxPTR,
+               reinterpret_cast<uintptr_t>(pc));
+      out += buf;
+    }
+    out += '\n';
+  }
+#ifdef __linux__
+  // pprof needs the memory map to symbolize addresses in position-independent
+  // code and shared libraries.
+  if (FILE *maps = fopen("/proc/self/maps", "r")) {
+    out += "MAPPED_LIBRARIES:\n";
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), maps)) > 0) out.append(chunk, n);
+    fclose(maps);
+  }
+#endif
+  return out;
+}
+
+void ResetMutexContentionProfile() {
+  ContentionEntry *freelist = nullptr;
+  contention_profile_mu.Lock();
+  for (uint32_t i = 0; i != kNContentionBuckets; i++) {
+    while (ContentionEntry *e = contention_profile[i]) {
+      contention_profile[i] = e->next;
+      e->next = freelist;
+      freelist = e;
+    }
+  }
+  contention_profile_size = 0;
+  contention_profile_mu.Unlock();
+  while (freelist != nullptr) {
+    ContentionEntry *e = freelist;
+    freelist = e->next;
+    base_internal::LowLevelAlloc::Free(e);
+  }
+}
+
+void EnableMutexLatencyHistograms(bool enabled) {
+  mutex_latency_histograms_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t MutexLatencyHistogram::Distribution::Quantile(double q) const {
+  int64_t remaining = static_cast<int64_t>(q * count);
+  for (const Bucket &b : buckets) {
+    if (remaining < b.count) return b.upper_bound;
+    remaining -= b.count;
+  }
+  return buckets.empty() ? 0 : buckets.back().upper_bound;
+}
+
+static void SnapshotLatency(const LatencyDistribution &d,
+                            MutexLatencyHistogram::Distribution *out) {
+  out->count = 0;
+  out->total_cycles = d.total_cycles.load(std::memory_order_relaxed);
+  for (int i = 0; i != kNumLatencyBuckets; i++) {
+    int64_t n = d.count[i].load(std::memory_order_relaxed);
+    if (n != 0) {
+      int64_t upper = i + 1 == kNumLatencyBuckets
+                          ? std::numeric_limits<int64_t>::max()
+                          : LatencyBucketLowerBound(i + 1);
+      out->buckets.push_back({LatencyBucketLowerBound(i), upper, n});
+      out->count += n;
+    }
+  }
+}
+
+std::vector<MutexLatencyHistogram> GetMutexLatencyHistograms() {
+  std::vector<MutexLatencyHistogram> result;
+  for (const LatencyHistograms *h =
+           latency_histograms.load(std::memory_order_acquire);
+       h != nullptr; h = h->next) {
+    result.emplace_back();
+    MutexLatencyHistogram &snapshot = result.back();
+    snapshot.name = h->name;
+    snapshot.cycles_per_second = base_internal::CycleClock::Frequency();
+    SnapshotLatency(h->wait, &snapshot.wait);
+    SnapshotLatency(h->hold, &snapshot.hold);
+  }
+  return result;
+}
+
+static void ResetLatency(LatencyDistribution *d) {
+  for (int i = 0; i != kNumLatencyBuckets; i++) {
+    d->count[i].store(0, std::memory_order_relaxed);
+  }
+  d->total_cycles.store(0, std::memory_order_relaxed);
+}
+
+void ResetMutexLatencyHistograms() {
+  for (LatencyHistograms *h =
+           latency_histograms.load(std::memory_order_acquire);
+       h != nullptr; h = h->next) {
+    ResetLatency(&h->wait);
+    ResetLatency(&h->hold);
+  }
+}
+
 static SynchLocksHeld *LocksHeldAlloc() {
   SynchLocksHeld *ret = reinterpret_cast<SynchLocksHeld *>(
       base_internal::LowLevelAlloc::Alloc(sizeof(SynchLocksHeld)));
   ret->n = 0;
   ret->overflow = false;
+  ret->generation =
+      deadlock_tracking_generation.load(std::memory_order_relaxed);
+  ret->sample_countdown =
+      deadlock_sampling_rate.load(std::memory_order_relaxed);
   return ret;
 }
 
@@ -517,7 +1141,20 @@ static SynchLocksHeld *Synch_GetAllLocks() {
   if (s->all_locks == nullptr) {
     s->all_locks = LocksHeldAlloc();  // Freed by ReclaimThreadIdentity.
   }
-  return s->all_locks;
+  SynchLocksHeld *held = s->all_locks;
+  const uint32_t generation =
+      deadlock_tracking_generation.load(std::memory_order_relaxed);
+  if (ABSL_PREDICT_FALSE(held->generation != generation)) {
+    // Locks may have been acquired or released untracked since the detector
+    // was reconfigured, so start afresh, and do not complain about releases
+    // of locks that are missing from the set.
+    held->generation = generation;
+    held->n = 0;
+    held->overflow = true;
+    held->sample_countdown =
+        deadlock_sampling_rate.load(std::memory_order_relaxed);
+  }
+  return held;
 }
 
 // Post on "w"'s associated PerThreadSem.
@@ -694,7 +1331,7 @@ Mutex::~Mutex() {
   if ((v & kMuEvent) != 0 && !DebugOnlyIsExiting()) {
     ForgetSynchEvent(&this->mu_, kMuEvent, kMuSpin);
   }
-  if (kDebugMode) {
+  if (kDebugMode || deadlock_graph_sampled.load(std::memory_order_relaxed)) {
     this->ForgetDeadlockInfo();
   }
   ABSL_TSAN_MUTEX_DESTROY(this, __tsan_mutex_not_static);
@@ -703,6 +1340,18 @@ Mutex::~Mutex() {
 void Mutex::EnableDebugLog(const char *name) {
   SynchEvent *e = EnsureSynchEvent(&this->mu_, name, kMuEvent, kMuSpin);
   e->log = true;
+  NoteOtherSynchEvents(e);
+  UnrefSynchEvent(e);
+}
+
+void Mutex::EnableLatencyHistograms(const char *name) {
+  SynchEvent *e = EnsureSynchEvent(&this->mu_, name, kMuEvent, kMuSpin);
+  MutexLatency *l = GetMutexLatency(this, GetLatencyHistograms(e->name));
+  synch_event_mu.Lock();
+  e->latency = l;
+  l->other_events.store(e->log || e->invariant != nullptr,
+                        std::memory_order_release);
+  synch_event_mu.Unlock();
   UnrefSynchEvent(e);
 }
 
@@ -717,6 +1366,7 @@ void Mutex::EnableInvariantDebugging(void (*invariant)(void *),
     SynchEvent *e = EnsureSynchEvent(&this->mu_, nullptr, kMuEvent, kMuSpin);
     e->invariant = invariant;
     e->arg = arg;
+    NoteOtherSynchEvents(e);
     UnrefSynchEvent(e);
   }
 }
@@ -725,6 +1375,11 @@ void SetMutexDeadlockDetectionMode(OnDeadlockCycle mode) {
   synch_deadlock_detection.store(mode, std::memory_order_release);
 }
 
+void SetMutexDeadlockDetectionSamplingRate(int n) {
+  deadlock_sampling_rate.store(n, std::memory_order_relaxed);
+  deadlock_tracking_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 // Return true iff threads x and y are waiting on the same condition for the
 // same type of lock.  Requires that x and y be waiting on the same Mutex
 // queue.
@@ -1196,9 +1851,70 @@ static void LockLeave(Mutex* mu, GraphId id, SynchLocksHeld *held_locks) {
   }
 }
 
-// Call LockEnter() if in debug mode and deadlock detection is enabled.
-static inline void DebugOnlyLockEnter(Mutex *mu) {
-  if (kDebugMode) {
+// Returns whether sampled deadlock detection is on, in which case it replaces
+// full deadlock detection.
+static inline bool DeadlockSamplingEnabled() {
+  return ABSL_PREDICT_FALSE(
+      deadlock_sampling_rate.load(std::memory_order_relaxed) > 0);
+}
+
+// Record a lock acquisition for sampled deadlock detection.  Locks are
+// tracked by address only, without taking deadlock_graph_mu, and are given
+// deadlock graph ids only when an acquisition is sampled.
+static void SampledLockEnter(Mutex *mu) {
+  if (synch_deadlock_detection.load(std::memory_order_acquire) ==
+      OnDeadlockCycle::kIgnore) {
+    return;
+  }
+  SynchLocksHeld *held_locks = Synch_GetAllLocks();
+  int n = held_locks->n;
+  int i = 0;
+  while (i != n && held_locks->locks[i].mu != mu) {
+    i++;
+  }
+  if (i != n) {
+    held_locks->locks[i].count++;
+  } else if (n == ABSL_ARRAYSIZE(held_locks->locks)) {
+    held_locks->overflow = true;  // lost some data
+  } else {
+    held_locks->locks[i].mu = mu;
+    held_locks->locks[i].count = 1;
+    held_locks->locks[i].id = InvalidGraphId();
+    held_locks->n = n + 1;
+  }
+}
+
+// Record a lock release for sampled deadlock detection.  Unlike LockLeave(),
+// tolerates the release of a lock that is not in the set, which may have been
+// acquired before sampling was turned on.
+static void SampledLockLeave(Mutex *mu) {
+  if (synch_deadlock_detection.load(std::memory_order_acquire) ==
+      OnDeadlockCycle::kIgnore) {
+    return;
+  }
+  SynchLocksHeld *held_locks = Synch_GetAllLocks();
+  int n = held_locks->n;
+  int i = 0;
+  while (i != n && held_locks->locks[i].mu != mu) {
+    i++;
+  }
+  if (i == n) return;
+  if (held_locks->locks[i].count == 1) {
+    held_locks->n = n - 1;
+    held_locks->locks[i] = held_locks->locks[n - 1];
+    held_locks->locks[n - 1].id = InvalidGraphId();
+    held_locks->locks[n - 1].mu = nullptr;
+  } else {
+    held_locks->locks[i].count--;
+  }
+}
+
+// Call LockEnter() if in debug mode and deadlock detection is enabled, or
+// SampledLockEnter() if sampling is.
+static inline void MaybeLockEnter(Mutex *mu) {
+  if (DeadlockSamplingEnabled()) {
+    SampledLockEnter(mu);
+  } else if (kDebugMode) {
     if (synch_deadlock_detection.load(std::memory_order_acquire) !=
         OnDeadlockCycle::kIgnore) {
       LockEnter(mu, GetGraphId(mu), Synch_GetAllLocks());
@@ -1206,9 +1922,12 @@ static inline void DebugOnlyLockEnter(Mutex *mu) {
   }
 }
 
-// Call LockEnter() if in debug mode and deadlock detection is enabled.
-static inline void DebugOnlyLockEnter(Mutex *mu, GraphId id) {
-  if (kDebugMode) {
+// Call LockEnter() if in debug mode and deadlock detection is enabled, or
+// SampledLockEnter() if sampling is.
+static inline void MaybeLockEnter(Mutex *mu, GraphId id) {
+  if (DeadlockSamplingEnabled()) {
+    SampledLockEnter(mu);
+  } else if (kDebugMode) {
     if (synch_deadlock_detection.load(std::memory_order_acquire) !=
         OnDeadlockCycle::kIgnore) {
       LockEnter(mu, id, Synch_GetAllLocks());
@@ -1216,9 +1935,12 @@ static inline void DebugOnlyLockEnter(Mutex *mu, GraphId id) {
   }
 }
 
-// Call LockLeave() if in debug mode and deadlock detection is enabled.
-static inline void DebugOnlyLockLeave(Mutex *mu) {
-  if (kDebugMode) {
+// Call LockLeave() if in debug mode and deadlock detection is enabled, or
+// SampledLockLeave() if sampling is.
+static inline void MaybeLockLeave(Mutex *mu) {
+  if (DeadlockSamplingEnabled()) {
+    SampledLockLeave(mu);
+  } else if (kDebugMode) {
     if (synch_deadlock_detection.load(std::memory_order_acquire) !=
         OnDeadlockCycle::kIgnore) {
       LockLeave(mu, GetGraphId(mu), Synch_GetAllLocks());
@@ -1278,27 +2000,12 @@ int GetStack(void** stack, int max_depth) {
 }
 }  // anonymous namespace
 
-// Called in debug mode when a thread is about to acquire a lock in a way that
-// may block.
-static GraphId DeadlockCheck(Mutex *mu) {
-  if (synch_deadlock_detection.load(std::memory_order_acquire) ==
-      OnDeadlockCycle::kIgnore) {
-    return InvalidGraphId();
-  }
-
-  SynchLocksHeld *all_locks = Synch_GetAllLocks();
-
-  absl::base_internal::SpinLockHolder lock(&deadlock_graph_mu);
-  const GraphId mu_id = GetGraphIdLocked(mu);
-
-  if (all_locks->n == 0) {
-    // There are no other locks held. Return now so that we don't need to
-    // call GetSynchEvent(). This way we do not record the stack trace
-    // for this Mutex. It's ok, since if this Mutex is involved in a deadlock,
-    // it can't always be the first lock acquired by a thread.
-    return mu_id;
-  }
-
+// Adds the edges from each lock in `all_locks`, which must not be empty, to
+// `mu`, whose id is `mu_id`, to the deadlock graph, all at once, and reports
+// the first cycle that one of them closes.
+static void InsertLockOrderEdges(Mutex *mu, GraphId mu_id,
+                                 SynchLocksHeld *all_locks)
+    EXCLUSIVE_LOCKS_REQUIRED(deadlock_graph_mu) {
   // We prefer to keep stack traces that show a thread holding and acquiring
   // as many locks as possible.  This increases the chances that a given edge
   // in the acquires-before graph will be represented in the stack traces
@@ -1355,20 +2062,72 @@ static GraphId DeadlockCheck(Mutex *mu) {
           OnDeadlockCycle::kAbort) {
         deadlock_graph_mu.Unlock();  // avoid deadlock in fatal sighandler
         ABSL_RAW_LOG(FATAL, "dying due to potential deadlock");
-        return mu_id;
+        return;
       }
       break;   // report at most one potential deadlock per acquisition
     }
   }
+}
 
+// Called in debug mode when a thread is about to acquire a lock in a way that
+// may block.
+static GraphId DeadlockCheck(Mutex *mu) {
+  if (synch_deadlock_detection.load(std::memory_order_acquire) ==
+      OnDeadlockCycle::kIgnore) {
+    return InvalidGraphId();
+  }
+
+  SynchLocksHeld *all_locks = Synch_GetAllLocks();
+
+  absl::base_internal::SpinLockHolder lock(&deadlock_graph_mu);
+  const GraphId mu_id = GetGraphIdLocked(mu);
+
+  if (all_locks->n == 0) {
+    // There are no other locks held. Return now so that we don't need to
+    // call GetSynchEvent(). This way we do not record the stack trace
+    // for this Mutex. It's ok, since if this Mutex is involved in a deadlock,
+    // it can't always be the first lock acquired by a thread.
+    return mu_id;
+  }
+
+  InsertLockOrderEdges(mu, mu_id, all_locks);
   return mu_id;
 }
 
-// Invoke DeadlockCheck() iff we're in debug mode and
-// deadlock checking has been enabled.
-static inline GraphId DebugOnlyDeadlockCheck(Mutex *mu) {
-  if (kDebugMode && synch_deadlock_detection.load(std::memory_order_acquire) !=
-                        OnDeadlockCycle::kIgnore) {
+// Called when sampling is enabled and a thread is about to acquire a lock in
+// a way that may block.  Only acquisitions made while holding other locks
+// count towards the sampling rate; a sampled one gives ids to the locks held,
+// which are all live, and inserts all its edges under one acquisition of
+// deadlock_graph_mu.
+static void SampledDeadlockCheck(Mutex *mu) {
+  if (synch_deadlock_detection.load(std::memory_order_acquire) ==
+      OnDeadlockCycle::kIgnore) {
+    return;
+  }
+  SynchLocksHeld *all_locks = Synch_GetAllLocks();
+  if (all_locks->n == 0 || --all_locks->sample_countdown > 0) return;
+  all_locks->sample_countdown =
+      deadlock_sampling_rate.load(std::memory_order_relaxed);
+
+  if (!deadlock_graph_sampled.load(std::memory_order_relaxed)) {
+    deadlock_graph_sampled.store(true, std::memory_order_relaxed);
+  }
+  absl::base_internal::SpinLockHolder lock(&deadlock_graph_mu);
+  for (int i = 0; i != all_locks->n; i++) {
+    all_locks->locks[i].id = GetGraphIdLocked(all_locks->locks[i].mu);
+  }
+  InsertLockOrderEdges(mu, GetGraphIdLocked(mu), all_locks);
+}
+
+// Invoke SampledDeadlockCheck() if sampling is enabled, or DeadlockCheck()
+// iff we're in debug mode and deadlock checking has been enabled.
+static inline GraphId MaybeDeadlockCheck(Mutex *mu) {
+  if (DeadlockSamplingEnabled()) {
+    SampledDeadlockCheck(mu);
+    return InvalidGraphId();
+  } else if (kDebugMode &&
+             synch_deadlock_detection.load(std::memory_order_acquire) !=
+                 OnDeadlockCycle::kIgnore) {
     return DeadlockCheck(mu);
   } else {
     return InvalidGraphId();
@@ -1376,8 +2135,9 @@ static inline GraphId DebugOnlyDeadlockCheck(Mutex *mu) {
 }
 
 void Mutex::ForgetDeadlockInfo() {
-  if (kDebugMode && synch_deadlock_detection.load(std::memory_order_acquire) !=
-                        OnDeadlockCycle::kIgnore) {
+  if ((kDebugMode || deadlock_graph_sampled.load(std::memory_order_relaxed)) &&
+      synch_deadlock_detection.load(std::memory_order_acquire) !=
+          OnDeadlockCycle::kIgnore) {
     deadlock_graph_mu.Lock();
     if (deadlock_graph != nullptr) {
       deadlock_graph->RemoveNode(this);
@@ -1409,7 +2169,10 @@ void Mutex::AssertNotHeld() const {
 // Attempt to acquire *mu, and return whether successful.  The implementation
 // may spin for a short while if the lock cannot be acquired immediately.
 static bool TryAcquireWithSpinning(std::atomic<intptr_t>* mu) {
-  int c = mutex_globals.spinloop_iterations;
+  const int limit = base_internal::AdaptiveSpinLimit(
+      mu, mutex_globals.spinloop_iterations,
+      (mu->load(std::memory_order_relaxed) & kMuWait) != 0);
+  int c = limit;
   int result = -1;  // result of operation:  0=false, 1=true, -1=unknown
 
   do {  // do/while somewhat faster on AMD
@@ -1423,12 +2186,16 @@ static bool TryAcquireWithSpinning(std::atomic<intptr_t>* mu) {
       result = 1;
     }
   } while (result == -1 && --c > 0);
+  if (result != 0) {  // acquired, or spun to the limit
+    base_internal::AdaptiveSpinUpdate(mu, mutex_globals.spinloop_iterations,
+                                      limit - c, result == 1);
+  }
   return result == 1;
 }
 
 ABSL_XRAY_LOG_ARGS(1) void Mutex::Lock() {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, 0);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   intptr_t v = mu_.load(std::memory_order_relaxed);
   // try fast acquire, then spin loop
   if ((v & (kMuWriter | kMuReader | kMuEvent)) != 0 ||
@@ -1440,13 +2207,13 @@ ABSL_XRAY_LOG_ARGS(1) void Mutex::Lock() {
       this->LockSlow(kExclusive, nullptr, 0);
     }
   }
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, 0, 0);
 }
 
 ABSL_XRAY_LOG_ARGS(1) void Mutex::ReaderLock() {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, __tsan_mutex_read_lock);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   intptr_t v = mu_.load(std::memory_order_relaxed);
   // try fast acquire, then slow loop
   if ((v & (kMuWriter | kMuWait | kMuEvent)) != 0 ||
@@ -1455,15 +2222,15 @@ ABSL_XRAY_LOG_ARGS(1) void Mutex::ReaderLock() {
                                    std::memory_order_relaxed)) {
     this->LockSlow(kShared, nullptr, 0);
   }
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, __tsan_mutex_read_lock, 0);
 }
 
 void Mutex::LockWhen(const Condition &cond) {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, 0);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   this->LockSlow(kExclusive, &cond, 0);
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, 0, 0);
 }
 
@@ -1473,19 +2240,19 @@ bool Mutex::LockWhenWithTimeout(const Condition &cond, absl::Duration timeout) {
 
 bool Mutex::LockWhenWithDeadline(const Condition &cond, absl::Time deadline) {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, 0);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   bool res = LockSlowWithDeadline(kExclusive, &cond,
                                   KernelTimeout(deadline), 0);
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, 0, 0);
   return res;
 }
 
 void Mutex::ReaderLockWhen(const Condition &cond) {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, __tsan_mutex_read_lock);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   this->LockSlow(kShared, &cond, 0);
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, __tsan_mutex_read_lock, 0);
 }
 
@@ -1497,9 +2264,9 @@ bool Mutex::ReaderLockWhenWithTimeout(const Condition &cond,
 bool Mutex::ReaderLockWhenWithDeadline(const Condition &cond,
                                        absl::Time deadline) {
   ABSL_TSAN_MUTEX_PRE_LOCK(this, __tsan_mutex_read_lock);
-  GraphId id = DebugOnlyDeadlockCheck(this);
+  GraphId id = MaybeDeadlockCheck(this);
   bool res = LockSlowWithDeadline(kShared, &cond, KernelTimeout(deadline), 0);
-  DebugOnlyLockEnter(this, id);
+  MaybeLockEnter(this, id);
   ABSL_TSAN_MUTEX_POST_LOCK(this, __tsan_mutex_read_lock, 0);
   return res;
 }
@@ -1564,7 +2331,7 @@ ABSL_XRAY_LOG_ARGS(1) bool Mutex::TryLock() {
       mu_.compare_exchange_strong(v, kMuWriter | v,
                                   std::memory_order_acquire,
                                   std::memory_order_relaxed)) {
-    DebugOnlyLockEnter(this);
+    MaybeLockEnter(this);
     ABSL_TSAN_MUTEX_POST_LOCK(this, __tsan_mutex_try_lock, 0);
     return true;
   }
@@ -1573,7 +2340,7 @@ ABSL_XRAY_LOG_ARGS(1) bool Mutex::TryLock() {
         mu_.compare_exchange_strong(
             v, (kExclusive->fast_or | v) + kExclusive->fast_add,
             std::memory_order_acquire, std::memory_order_relaxed)) {
-      DebugOnlyLockEnter(this);
+      MaybeLockEnter(this);
       PostSynchEvent(this, SYNCH_EV_TRYLOCK_SUCCESS);
       ABSL_TSAN_MUTEX_POST_LOCK(this, __tsan_mutex_try_lock, 0);
       return true;
@@ -1598,7 +2365,7 @@ ABSL_XRAY_LOG_ARGS(1) bool Mutex::ReaderTryLock() {
     if (mu_.compare_exchange_strong(v, (kMuReader | v) + kMuOne,
                                     std::memory_order_acquire,
                                     std::memory_order_relaxed)) {
-      DebugOnlyLockEnter(this);
+      MaybeLockEnter(this);
       ABSL_TSAN_MUTEX_POST_LOCK(
           this, __tsan_mutex_read_lock | __tsan_mutex_try_lock, 0);
       return true;
@@ -1612,7 +2379,7 @@ ABSL_XRAY_LOG_ARGS(1) bool Mutex::ReaderTryLock() {
       if (mu_.compare_exchange_strong(v, (kMuReader | v) + kMuOne,
                                       std::memory_order_acquire,
                                       std::memory_order_relaxed)) {
-        DebugOnlyLockEnter(this);
+        MaybeLockEnter(this);
         PostSynchEvent(this, SYNCH_EV_READERTRYLOCK_SUCCESS);
         ABSL_TSAN_MUTEX_POST_LOCK(
             this, __tsan_mutex_read_lock | __tsan_mutex_try_lock, 0);
@@ -1634,7 +2401,7 @@ ABSL_XRAY_LOG_ARGS(1) bool Mutex::ReaderTryLock() {
 
 ABSL_XRAY_LOG_ARGS(1) void Mutex::Unlock() {
   ABSL_TSAN_MUTEX_PRE_UNLOCK(this, 0);
-  DebugOnlyLockLeave(this);
+  MaybeLockLeave(this);
   intptr_t v = mu_.load(std::memory_order_relaxed);
 
   if (kDebugMode && ((v & (kMuWriter | kMuReader)) != kMuWriter)) {
@@ -1686,7 +2453,7 @@ static bool ExactlyOneReader(intptr_t v) {
 
 ABSL_XRAY_LOG_ARGS(1) void Mutex::ReaderUnlock() {
   ABSL_TSAN_MUTEX_PRE_UNLOCK(this, __tsan_mutex_read_lock);
-  DebugOnlyLockLeave(this);
+  MaybeLockLeave(this);
   intptr_t v = mu_.load(std::memory_order_relaxed);
   assert((v & (kMuWriter|kMuReader)) == kMuReader);
   if ((v & (kMuReader|kMuWait|kMuEvent)) == kMuReader) {
@@ -1870,6 +2637,11 @@ void Mutex::LockSlowLoop(SynchWaitParams *waitp, int flags) {
   ABSL_RAW_CHECK(
       waitp->thread->waitp == nullptr || waitp->thread->suppress_fatal_errors,
       "detected illegal recursion into Mutex code");
+  ContentionStacks contention;
+  if (waitp->cond == nullptr && (flags & kMuIsCond) == 0 &&
+      ShouldSampleContention(waitp->contention_start_cycles)) {
+    waitp->contention_sample = &contention;
+  }
   for (;;) {
     v = mu_.load(std::memory_order_relaxed);
     CheckForMutexCorruption(v, "Lock");
@@ -1952,6 +2724,9 @@ void Mutex::LockSlowLoop(SynchWaitParams *waitp, int flags) {
         dowait = true;
       }
       if (dowait) {
+        if (waitp->contention_sample != nullptr && !contention.blocked) {
+          RecordContentionWaiter(&contention);
+        }
         this->Block(waitp->thread);  // wait until removed from list or timeout
         flags |= kMuHasBlocked;
         c = 0;
@@ -1965,10 +2740,29 @@ void Mutex::LockSlowLoop(SynchWaitParams *waitp, int flags) {
   ABSL_RAW_CHECK(
       waitp->thread->waitp == nullptr || waitp->thread->suppress_fatal_errors,
       "detected illegal recursion into Mutex code");
+  if (waitp->contention_sample != nullptr) {
+    if (contention.blocked) {
+      int64_t wait_cycles =
+          base_internal::CycleClock::Now() - waitp->contention_start_cycles;
+      RecordContention(this, wait_cycles, contention);
+    }
+    waitp->contention_sample = nullptr;
+  }
+  // Waits for a condition are not waits for the Mutex.
+  const int64_t wait_start =
+      waitp->cond == nullptr && (flags & kMuIsCond) == 0
+          ? waitp->contention_start_cycles
+          : 0;
   if ((v & kMuEvent) != 0) {
     PostSynchEvent(this,
                    waitp->how == kExclusive? SYNCH_EV_LOCK_RETURNING :
-                                      SYNCH_EV_READERLOCK_RETURNING);
+                                      SYNCH_EV_READERLOCK_RETURNING,
+                   wait_start);
+  } else if (wait_start != 0 && mutex_latency_histograms_enabled.load(
+                                    std::memory_order_relaxed)) {
+    RecordLatency(&UnnamedLatencyHistograms()->wait,
+                  std::max<int64_t>(
+                      base_internal::CycleClock::Now() - wait_start, 0));
   }
 }
 
@@ -2260,6 +3054,9 @@ void Mutex::UnlockSlow(SynchWaitParams *waitp) {
   if (wake_list != kPerThreadSynchNull) {
     int64_t enqueue_timestamp = wake_list->waitp->contention_start_cycles;
     bool cond_waiter = wake_list->cond_waiter;
+    if (contention_profiling_rate.load(std::memory_order_relaxed) > 0) {
+      RecordContentionHolder(wake_list);
+    }
     do {
       wake_list = Wakeup(wake_list);              // wake waiters
     } while (wake_list != kPerThreadSynchNull);
@@ -2288,18 +3085,69 @@ void Mutex::Trans(MuHow how) {
   this->LockSlow(how, nullptr, kMuHasBlocked | kMuIsCond);
 }
 
-// Used by CondVar implementation to effectively wake thread w from the
-// condition variable.  If this mutex is free, we simply wake the thread.
-// It will later acquire the mutex with high probability.  Otherwise, we
-// enqueue thread w on this mutex.
+// Queue the threads on the null-terminated list w, which are waiting on a
+// CondVar for this mutex, on this mutex.  Requires that some thread be
+// certain to acquire and release the mutex afterwards: a holder, a thread
+// already queued on it, or one woken by the caller after this returns.
+void Mutex::FerEnqueue(PerThreadSynch *w) {
+  if (w == nullptr) {
+    return;
+  }
+  int c = 0;
+  for (;;) {
+    intptr_t v = mu_.load(std::memory_order_relaxed);
+    // All of w is queued under one acquisition of the spinlock, even if
+    // there are no waiters yet, so that no waiter is queued after the mutex
+    // has been released by the thread that was to wake it.
+    if ((v & kMuSpin) == 0 &&
+        mu_.compare_exchange_strong(v, v | kMuSpin | kMuWait)) {
+      FerEnqueueLocked(w, v);
+      return;
+    }
+    c = Delay(c, GENTLE);
+  }
+}
+
+// Queue the threads on the null-terminated list w on this mutex, as
+// FerEnqueue() does, given that this thread holds the spinlock on the waiter
+// list, and v is the value of mu_ when it was acquired, which may have no
+// waiters.  Releases the spinlock, publishing the whole queue at once.
+void Mutex::FerEnqueueLocked(PerThreadSynch *w, intptr_t v) {
+  // With no waiters, the high bits of v are a reader count, which Enqueue()
+  // moves into the first waiter.
+  PerThreadSynch *h = (v & kMuWait) != 0 ? GetPerThreadSynch(v) : nullptr;
+  do {
+    PerThreadSynch *next = w->next;
+    h = Enqueue(h, w->waitp, v, kMuIsCond);
+    ABSL_RAW_CHECK(h != nullptr,
+                   "Enqueue failed");  // we must queue ourselves
+    w = next;
+  } while (w != nullptr);
+  do {                        // release spinlock
+    v = mu_.load(std::memory_order_relaxed);
+  } while (!mu_.compare_exchange_weak(
+      v, (v & kMuLow & ~kMuSpin) | kMuWait | reinterpret_cast<intptr_t>(h),
+      std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Used by CondVar implementation to effectively wake the threads on the
+// null-terminated list w from the condition variable.  If this mutex is free
+// for the first of them, we simply wake it; it will later acquire the mutex
+// with high probability.  Otherwise, we enqueue it on this mutex.  Either way
+// it is then certain to acquire and release the mutex, so the rest are
+// enqueued on the mutex behind it, and each is woken by an Unlock() only when
+// it can take the mutex, rather than all contending for it at once.
 void Mutex::Fer(PerThreadSynch *w) {
+  for (PerThreadSynch *x = w; x != nullptr; x = x->next) {
+    ABSL_RAW_CHECK(x->waitp->cond == nullptr,
+                   "Mutex::Fer while waiting on Condition");
+    ABSL_RAW_CHECK(!x->waitp->timeout.has_timeout(),
+                   "Mutex::Fer while in timed wait");
+    ABSL_RAW_CHECK(x->waitp->cv_word == nullptr,
+                   "Mutex::Fer with pending CondVar queueing");
+  }
+  PerThreadSynch *rest = w->next;
   int c = 0;
-  ABSL_RAW_CHECK(w->waitp->cond == nullptr,
-                 "Mutex::Fer while waiting on Condition");
-  ABSL_RAW_CHECK(!w->waitp->timeout.has_timeout(),
-                 "Mutex::Fer while in timed wait");
-  ABSL_RAW_CHECK(w->waitp->cv_word == nullptr,
-                 "Mutex::Fer with pending CondVar queueing");
   for (;;) {
     intptr_t v = mu_.load(std::memory_order_relaxed);
     // Note: must not queue if the mutex is unlocked (nobody will wake it).
@@ -2311,36 +3159,22 @@ void Mutex::Fer(PerThreadSynch *w) {
     const intptr_t conflicting =
         kMuWriter | (w->waitp->how == kShared ? 0 : kMuReader);
     if ((v & conflicting) == 0) {
+      // The rest must be queued before w is woken, lest w take and release
+      // the mutex before they are on its queue.
+      FerEnqueue(rest);
       w->next = nullptr;
       w->state.store(PerThreadSynch::kAvailable, std::memory_order_release);
       IncrementSynchSem(this, w);
       return;
-    } else {
-      if ((v & (kMuSpin|kMuWait)) == 0) {       // no waiters
-        // This thread tries to become the one and only waiter.
-        PerThreadSynch *new_h = Enqueue(nullptr, w->waitp, v, kMuIsCond);
-        ABSL_RAW_CHECK(new_h != nullptr,
-                       "Enqueue failed");  // we must queue ourselves
-        if (mu_.compare_exchange_strong(
-                v, reinterpret_cast<intptr_t>(new_h) | (v & kMuLow) | kMuWait,
-                std::memory_order_release, std::memory_order_relaxed)) {
-          return;
-        }
-      } else if ((v & kMuSpin) == 0 &&
-                 mu_.compare_exchange_strong(v, v | kMuSpin | kMuWait)) {
-        PerThreadSynch *h = GetPerThreadSynch(v);
-        PerThreadSynch *new_h = Enqueue(h, w->waitp, v, kMuIsCond);
-        ABSL_RAW_CHECK(new_h != nullptr,
-                       "Enqueue failed");  // we must queue ourselves
-        do {
-          v = mu_.load(std::memory_order_relaxed);
-        } while (!mu_.compare_exchange_weak(
-            v,
-            (v & kMuLow & ~kMuSpin) | kMuWait |
-                reinterpret_cast<intptr_t>(new_h),
-            std::memory_order_release, std::memory_order_relaxed));
-        return;
-      }
+    } else if ((v & kMuSpin) == 0 &&
+               mu_.compare_exchange_strong(v, v | kMuSpin | kMuWait)) {
+      // The mutex cannot be released under us without the spinlock, except
+      // by a holder that leaves a designated waker to take it, so all of w
+      // is queued at once, whether or not there were waiters.  Queuing w
+      // alone first would let the holder wake it, and w take and release
+      // the mutex, before the rest were queued.
+      FerEnqueueLocked(w, v);
+      return;
     }
     c = Delay(c, GENTLE);
   }
@@ -2546,6 +3380,7 @@ void CondVar::Wakeup(PerThreadSynch *w) {
     w->state.store(PerThreadSynch::kAvailable, std::memory_order_release);
     Mutex::IncrementSynchSem(mu, w);
   } else {
+    w->next = nullptr;
     w->waitp->cvmu->Fer(w);
   }
 }
@@ -2605,13 +3440,38 @@ void CondVar::SignalAll () {
                                     std::memory_order_relaxed)) {
       PerThreadSynch *h = reinterpret_cast<PerThreadSynch *>(v & ~kCvLow);
       if (h != nullptr) {
+        // Threads that wait on the same Mutex without a timeout are
+        // transferred to it in batches by Mutex::Fer(), so that they are
+        // woken one at a time as the Mutex becomes free for them.
+        Mutex *batch_mu = nullptr;
+        PerThreadSynch *batch = nullptr;
+        PerThreadSynch *batch_tail = nullptr;
         PerThreadSynch *w;
         PerThreadSynch *n = h->next;
         do {                          // for every thread, wake it up
           w = n;
           n = n->next;
-          CondVar::Wakeup(w);
+          Mutex *mu = w->waitp->cvmu;
+          if (w->waitp->timeout.has_timeout() || mu == nullptr) {
+            CondVar::Wakeup(w);
+            continue;
+          }
+          if (mu != batch_mu && batch != nullptr) {
+            batch_mu->Fer(batch);
+            batch = nullptr;
+          }
+          w->next = nullptr;
+          if (batch == nullptr) {
+            batch_mu = mu;
+            batch = w;
+          } else {
+            batch_tail->next = w;
+          }
+          batch_tail = w;
         } while (w != h);
+        if (batch != nullptr) {
+          batch_mu->Fer(batch);
+        }
         cond_var_tracer("SignalAll wakeup", this);
       }
       if ((v & kCvEvent) != 0) {
@@ -60,6 +60,7 @@
 #include <atomic>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/base/internal/identity.h"
 #include "absl/base/internal/low_level_alloc.h"
@@ -396,6 +397,19 @@ class LOCKABLE Mutex {
   // Note: This method substantially reduces `Mutex` performance.
   void EnableDebugLog(const char *name);
 
+  // Mutex::EnableLatencyHistograms()
+  //
+  // Cause the time threads wait to acquire this `Mutex`, and the time they
+  // hold it, to be recorded in the latency histograms for `name` (see
+  // `GetMutexLatencyHistograms()` below), which all `Mutex`es enabled with the
+  // same name share. As with `EnableDebugLog()`, `name` is ignored in favor of
+  // the one previously given to this `Mutex`, if any.
+  //
+  // Note: This method sends every operation on this `Mutex` through its slow
+  // path. Recording takes no lock, but it is meant for a modest number of
+  // important `Mutex`es, not for every one in a large data structure.
+  void EnableLatencyHistograms(const char *name);
+
   // Deadlock detection
 
   // Mutex::ForgetDeadlockInfo()
@@ -483,6 +497,8 @@ class LOCKABLE Mutex {
   void Trans(MuHow how);  // used for CondVar->Mutex transfer
   void Fer(
       base_internal::PerThreadSynch *w);  // used for CondVar->Mutex transfer
+  void FerEnqueue(base_internal::PerThreadSynch *w);  // helpers for Fer()
+  void FerEnqueueLocked(base_internal::PerThreadSynch *w, intptr_t v);
 #endif
 
   // Catch the error of writing Mutex when intending MutexLock.
@@ -958,6 +974,164 @@ void RegisterMutexTracer(void (*fn)(const char *msg, const void *obj,
 // TODO(gfalcon): Combine RegisterMutexProfiler() and RegisterMutexTracer()
 // into a single interface, since they are only ever called in pairs.
 
+// -----------------------------------------------------------------------------
+// Contention Profiling
+// -----------------------------------------------------------------------------
+//
+// Mutex includes a sampling contention profiler. When it is enabled, a sample
+// of the `Lock()` and `ReaderLock()` calls that had to block records the Mutex,
+// how long the caller waited, and stack traces of the waiting thread and of
+// the thread whose `Unlock()` woke it (the "holder"). Samples are aggregated
+// by their pair of stack traces, so that, for example, a convoy behind a lock
+// held across a slow operation shows up as one heavy entry naming both the
+// slow holder and its victims.
+//
+// Waits for a `Condition` (`Await()`, `LockWhen()`, ...) or on a `CondVar`
+// are not sampled, as that time is spent waiting for the condition rather
+// than for the Mutex.
+//
+// Example:
+//
+//   absl::SetMutexContentionProfilingRate(100);
+//   ...
+//   WriteFile("/tmp/contention.prof", absl::GetMutexContentionProfile());
+//
+//   $ pprof --text path/to/binary /tmp/contention.prof
+
+// SetMutexContentionProfilingRate()
+//
+// Samples on average one in `n` blocking acquisitions. `n == 1` samples every
+// one, and `n <= 0` (the default) turns the profiler off. Turning the profiler
+// off keeps the samples recorded so far; see ResetMutexContentionProfile().
+void SetMutexContentionProfilingRate(int n);
+
+// MutexContentionSample
+//
+// The aggregated contention recorded with one pair of stack traces.
+struct MutexContentionSample {
+  // The Mutex most recently sampled with these stacks.
+  const void *mutex;
+  // The number of sampled acquisitions.
+  int64_t count;
+  // Their total wait time, in base_internal::CycleClock units; see
+  // `base_internal::CycleClock::Frequency()`.
+  int64_t wait_cycles;
+  // The stacks of the waiting and of the releasing thread, innermost frame
+  // first. `holder_stack` is empty if the holder could not be determined.
+  std::vector<void *> waiter_stack;
+  std::vector<void *> holder_stack;
+};
+
+// GetMutexContentionSamples()
+//
+// Returns a snapshot of the samples recorded since the profiler was last
+// reset, in no particular order. At most a few thousand distinct pairs of
+// stacks are kept; later pairs are dropped.
+std::vector<MutexContentionSample> GetMutexContentionSamples();
+
+// MutexContentionStack
+//
+// Selects which stack trace GetMutexContentionProfile() attributes wait time
+// to.
+enum class MutexContentionStack {
+  kWaiter,  // The thread that waited to acquire the Mutex
+  kHolder,  // The thread that held the Mutex and woke the waiter
+};
+
+// GetMutexContentionProfile()
+//
+// Returns the samples in the legacy text format for contention profiles that
+// `pprof` reads, with wait time attributed to the selected stacks. On Linux
+// the profile includes the process's memory map for symbolization.
+std::string GetMutexContentionProfile(
+    MutexContentionStack stack = MutexContentionStack::kWaiter);
+
+// ResetMutexContentionProfile()
+//
+// Discards all samples recorded so far.
+void ResetMutexContentionProfile();
+
+// -----------------------------------------------------------------------------
+// Latency Histograms
+// -----------------------------------------------------------------------------
+//
+// A Mutex enabled with `Mutex::EnableLatencyHistograms(name)` records how long
+// each acquisition waited and how long each hold lasted in a pair of
+// histograms for `name`. Time is measured in cycles of a clock that runs at
+// `MutexLatencyHistogram::cycles_per_second`.
+// Histograms are log-linear: each power of two is split into four buckets,
+// so a bucket's bounds are within 25% of each other whatever the magnitude,
+// and recording a time costs a few relaxed atomic increments.
+//
+// Waits for a `Condition` or on a `CondVar` are not recorded as waits, as
+// that time is spent waiting for the condition, but they do end and restart
+// holds. While a Mutex is held in shared mode, the hold recorded is the time
+// from the first reader's acquisition to the last reader's release.
+//
+// Example:
+//
+//   table_mu.EnableLatencyHistograms("Table::mu_");
+//   ...
+//   for (const absl::MutexLatencyHistogram &h :
+//        absl::GetMutexLatencyHistograms()) {
+//     printf("%s: 99%% of holds < %.1fus\n", h.name.c_str(),
+//            h.hold.Quantile(0.99) * 1e6 / h.cycles_per_second);
+//   }
+
+// EnableMutexLatencyHistograms()
+//
+// Additionally records the waits of all Mutexes that take the slow path to
+// acquire, under the name given to the Mutex, or under the empty name for the
+// Mutexes that have none. Acquisitions that find a Mutex free and its holds
+// are only recorded for Mutexes enabled with `Mutex::EnableLatencyHistograms()`,
+// which are unaffected by this setting. Disabled by default.
+void EnableMutexLatencyHistograms(bool enabled);
+
+// MutexLatencyHistogram
+//
+// A snapshot of the wait and hold time histograms for one name.
+struct MutexLatencyHistogram {
+  // The counts of times t with `lower_bound <= t < upper_bound`, in cycles;
+  // see `cycles_per_second`.
+  struct Bucket {
+    int64_t lower_bound;
+    int64_t upper_bound;
+    int64_t count;
+  };
+
+  struct Distribution {
+    // Returns the upper bound of the bucket holding the `q`-quantile
+    // (`0 <= q <= 1`), which is an upper bound on the times of that fraction
+    // of events; or zero if no event was recorded.
+    int64_t Quantile(double q) const;
+
+    int64_t count;         // The number of times recorded.
+    int64_t total_cycles;  // Their sum.
+    // The buckets with a nonzero count, in increasing order.
+    std::vector<Bucket> buckets;
+  };
+
+  std::string name;
+  // The rate of the clock that all times are measured in, to convert them to
+  // seconds.
+  double cycles_per_second;
+  Distribution wait;
+  Distribution hold;
+};
+
+// GetMutexLatencyHistograms()
+//
+// Returns a snapshot of the histograms recorded since they were last reset,
+// one for each name with which latency recording was enabled, in no
+// particular order. The counts are read without stopping concurrent
+// recording, so a snapshot may be slightly inconsistent.
+std::vector<MutexLatencyHistogram> GetMutexLatencyHistograms();
+
+// ResetMutexLatencyHistograms()
+//
+// Sets the counts of all histograms to zero.
+void ResetMutexLatencyHistograms();
+
 // Register a hook for CondVar tracing.
 //
 // The function pointer registered here will be called here on various CondVar
@@ -987,6 +1161,17 @@ ABSL_DEPRECATED("absl::RegisterSymbolizer() is deprecated and will be removed "
                 "on or after 2023-05-01")
 void RegisterSymbolizer(bool (*fn)(const void *pc, char *out, int out_size));
 
+// EnableMutexAdaptiveSpinning()
+//
+// Enable or disable adaptive spinning. A thread that finds a Mutex held spins
+// for a while before sleeping. With adaptive spinning (the default), how long
+// it spins is tuned per Mutex from how soon recent spinners acquired it, and
+// is shortened while the Mutex has sleeping waiters; a Mutex that is held for
+// long periods is soon hardly spun on at all. When disabled, threads always
+// spin for a fixed number of iterations. The setting also applies to the
+// SpinLocks used internally by Abseil.
+void EnableMutexAdaptiveSpinning(bool enabled);
+
 // EnableMutexInvariantDebugging()
 //
 // Enable or disable global support for Mutex invariant debugging.  If enabled,
@@ -1014,6 +1199,18 @@ enum class OnDeadlockCycle {
 // the manner chosen here.
 void SetMutexDeadlockDetectionMode(OnDeadlockCycle mode);
 
+// SetMutexDeadlockDetectionSamplingRate()
+//
+// Enable sampled deadlock detection, which is cheap enough for production
+// builds: the lock ordering graph is updated for only one in `n` of the
+// acquisitions a thread makes while it holds another `Mutex`, with the edges
+// from all the locks it holds.  A lock ordering inversion that recurs is thus
+// eventually reported, in the manner chosen by SetMutexDeadlockDetectionMode().
+// Sampling works in all builds and, while on, replaces the full tracking of
+// debug builds.  `n == 1` samples every such acquisition, and `n <= 0` (the
+// default) turns sampling off.
+void SetMutexDeadlockDetectionSamplingRate(int n);
+
 }  // namespace absl
 
 // In some build configurations we pass --detect-odr-violations to the
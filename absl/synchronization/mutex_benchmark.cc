@@ -12,13 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "absl/base/internal/spinlock.h"
 #include "absl/base/internal/sysinfo.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/internal/thread_pool.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/sharded_reader_mutex.h"
 
 namespace {
 
@@ -91,4 +98,160 @@ void BM_ContendedMutex(benchmark::State& state) {
 BENCHMARK(BM_ContendedMutex)->Threads(1);
 BENCHMARK(BM_ContendedMutex)->ThreadPerCpu();
 
+// As above, with latency histograms enabled on the Mutex.
+void BM_ContendedMutexWithLatencyHistograms(benchmark::State& state) {
+  static absl::Mutex* mu = [] {
+    absl::Mutex* mu = new absl::Mutex;
+    mu->EnableLatencyHistograms("BM_ContendedMutexWithLatencyHistograms");
+    return mu;
+  }();
+  for (auto _ : state) {
+    absl::MutexLock lock(mu);
+  }
+}
+BENCHMARK(BM_ContendedMutexWithLatencyHistograms)->Threads(1);
+BENCHMARK(BM_ContendedMutexWithLatencyHistograms)->ThreadPerCpu();
+
+// Does about `n` iterations of work that the compiler cannot remove.
+void DelayLoop(int n) {
+  int sink = 0;
+  for (int i = 0; i < n; i++) {
+    benchmark::DoNotOptimize(sink += i);
+  }
+}
+
+// Sweeps the time a lock is held and the number of threads contending for
+// it, with adaptive spinning disabled or enabled. Each thread does as much
+// work outside the lock as inside it, so that with enough threads the lock is
+// always contended, and with few it often is not.
+template <typename MutexType>
+void BM_ContendedHoldTime(benchmark::State& state) {
+  static auto* mu = new MutexType;
+  const int hold = state.range(0);
+  if (state.thread_index == 0) {
+    absl::EnableMutexAdaptiveSpinning(state.range(1) != 0);
+  }
+  for (auto _ : state) {
+    mu->Lock();
+    DelayLoop(hold);
+    mu->Unlock();
+    DelayLoop(hold);
+  }
+  if (state.thread_index == 0) {
+    absl::EnableMutexAdaptiveSpinning(true);
+  }
+}
+
+void SetUpHoldTimeSweep(benchmark::internal::Benchmark* bm) {
+  bm->ArgNames({"hold", "adaptive"});
+  for (int adaptive : {0, 1}) {
+    for (int hold : {0, 10, 100, 1000, 10000}) {
+      bm->Args({hold, adaptive});
+    }
+  }
+  const int max_threads = std::max(2, 2 * absl::base_internal::NumCPUs());
+  bm->ThreadRange(1, max_threads);
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_ContendedHoldTime, absl::Mutex)
+    ->Apply(SetUpHoldTimeSweep);
+BENCHMARK_TEMPLATE(BM_ContendedHoldTime, absl::base_internal::SpinLock)
+    ->Apply(SetUpHoldTimeSweep);
+
+// Readers only, with `work` iterations of work inside the lock. With many
+// threads, absl::Mutex readers contend on the mutex word, while
+// ShardedReaderMutex readers mostly touch separate cache lines.
+template <typename MutexType>
+void BM_ReaderLock(benchmark::State& state) {
+  static auto* mu = new MutexType;
+  const int work = state.range(0);
+  for (auto _ : state) {
+    mu->ReaderLock();
+    DelayLoop(work);
+    mu->ReaderUnlock();
+  }
+}
+
+void SetUpReaderLock(benchmark::internal::Benchmark* bm) {
+  bm->ArgName("work")->Arg(0)->Arg(100);
+  bm->Threads(1)->ThreadPerCpu();
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_ReaderLock, absl::Mutex)->Apply(SetUpReaderLock);
+BENCHMARK_TEMPLATE(BM_ReaderLock, absl::ShardedReaderMutex)
+    ->Apply(SetUpReaderLock);
+
+// Returns the number of context switches of this process so far, or 0 where
+// that is not known.
+int64_t ContextSwitches() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+  }
+#endif
+  return 0;
+}
+
+// Each iteration wakes kWaiters threads blocked on a CondVar with one
+// SignalAll(), and waits for all of them to have run and blocked again.  With
+// range(0) == 1 the Mutex is held during the SignalAll(); otherwise it is
+// released first.  The waiters are handed to the Mutex rather than woken all
+// at once, so "context_switches" per iteration should stay near kWaiters.
+void BM_CondVarSignalAll(benchmark::State& state) {
+  constexpr int kWaiters = 64;
+  const bool signal_with_lock_held = state.range(0) != 0;
+  absl::Mutex mu;
+  absl::CondVar cv;       // signalled when round changes
+  absl::CondVar done_cv;  // signalled when arrived reaches kWaiters
+  int round = 0;
+  int arrived = 0;
+  bool stop = false;
+
+  {
+    absl::synchronization_internal::ThreadPool pool(kWaiters);
+    for (int i = 0; i < kWaiters; i++) {
+      pool.Schedule([&] {
+        absl::MutexLock l(&mu);
+        int seen = round;
+        for (;;) {
+          if (++arrived == kWaiters) done_cv.Signal();
+          while (round == seen && !stop) cv.Wait(&mu);
+          if (stop) break;
+          seen = round;
+        }
+      });
+    }
+
+    const int64_t start = ContextSwitches();
+    for (auto _ : state) {
+      mu.Lock();
+      while (arrived != kWaiters) done_cv.Wait(&mu);
+      arrived = 0;
+      round++;
+      if (signal_with_lock_held) {
+        cv.SignalAll();
+        mu.Unlock();
+      } else {
+        mu.Unlock();
+        cv.SignalAll();
+      }
+    }
+    state.counters["context_switches"] =
+        static_cast<double>(ContextSwitches() - start) / state.iterations();
+
+    mu.Lock();
+    stop = true;
+    cv.SignalAll();
+    mu.Unlock();
+  }
+}
+BENCHMARK(BM_CondVarSignalAll)
+    ->ArgName("locked")
+    ->Arg(0)
+    ->Arg(1)
+    ->UseRealTime();
+
 }  // namespace
@@ -30,10 +30,12 @@
 
 #include "gtest/gtest.h"
 #include "absl/base/attributes.h"
+#include "absl/base/internal/cycleclock.h"
 #include "absl/base/internal/raw_logging.h"
 #include "absl/base/internal/sysinfo.h"
 #include "absl/memory/memory.h"
 #include "absl/synchronization/internal/thread_pool.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
@@ -923,6 +925,111 @@ TEST(Mutex, TestReaderOnCondVar) {
   mu.Unlock();
 }
 
+// Test that one SignalAll() wakes every waiter, half of them readers, when
+// they are transferred to the Mutex in a batch.  If signal_with_lock_held,
+// the Mutex is held during the SignalAll(), so all are queued on it;
+// otherwise one is woken directly and the rest are queued behind it.
+static void TestSignalAllWakesEveryWaiter(bool signal_with_lock_held)
+    NO_THREAD_SAFETY_ANALYSIS {
+  constexpr int kWaiters = 64;
+  absl::Mutex mu;
+  absl::CondVar cv;
+  bool go = false;
+  std::atomic<int> waiting(0);
+  std::atomic<int> woken(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i != kWaiters; i++) {
+    const bool reader = i % 2 == 0;
+    threads.emplace_back([&, reader]() NO_THREAD_SAFETY_ANALYSIS {
+      if (reader) {
+        mu.ReaderLock();
+      } else {
+        mu.Lock();
+      }
+      waiting.fetch_add(1);
+      while (!go) {
+        cv.Wait(&mu);
+      }
+      woken.fetch_add(1);
+      if (reader) {
+        mu.ReaderUnlock();
+      } else {
+        mu.Unlock();
+      }
+    });
+  }
+  while (waiting.load() != kWaiters) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  mu.Lock();  // so every waiter is now blocked in cv.Wait()
+  go = true;
+  if (signal_with_lock_held) {
+    cv.SignalAll();
+    mu.Unlock();
+  } else {
+    mu.Unlock();
+    cv.SignalAll();
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(woken.load(), kWaiters);
+}
+
+TEST(Mutex, CondVarSignalAllWithLockHeld) {
+  for (int i = 0; i != 10; i++) {
+    TestSignalAllWakesEveryWaiter(true);
+  }
+}
+
+TEST(Mutex, CondVarSignalAllWithLockFree) {
+  for (int i = 0; i != 10; i++) {
+    TestSignalAllWakesEveryWaiter(false);
+  }
+}
+
+// Test that a SignalAll() made without the Mutex held, while another thread
+// holds it and then releases it for the last time, queues every waiter where
+// some thread will wake it.  A waiter left queued on the Mutex after that
+// release would never be woken.
+TEST(Mutex, CondVarSignalAllWhileLockChangesHands) NO_THREAD_SAFETY_ANALYSIS {
+  constexpr int kWaiters = 16;
+  for (int i = 0; i != 100; i++) {
+    absl::Mutex mu;
+    absl::CondVar cv;
+    bool go = false;
+    int waiting = 0;
+    absl::Notification held;
+    std::vector<std::thread> threads;
+    for (int j = 0; j != kWaiters; j++) {
+      threads.emplace_back([&]() NO_THREAD_SAFETY_ANALYSIS {
+        mu.Lock();
+        waiting++;
+        while (!go) {
+          cv.Wait(&mu);
+        }
+        mu.Unlock();
+      });
+    }
+    mu.LockWhen(absl::Condition(
+        +[](int *waiting) { return *waiting == kWaiters; }, &waiting));
+    go = true;
+    mu.Unlock();
+    std::thread holder([&]() NO_THREAD_SAFETY_ANALYSIS {
+      mu.Lock();
+      held.Notify();
+      absl::SleepFor(absl::Microseconds(i % 10));
+      mu.Unlock();
+    });
+    held.WaitForNotification();
+    cv.SignalAll();
+    holder.join();
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+}
+
 // --------------------------------------------------------
 struct AcquireFromConditionStruct {
   absl::Mutex mu0;   // protects value, done
@@ -1142,6 +1249,281 @@ TEST(Mutex, DeadlockIdBug) NO_THREAD_SAFETY_ANALYSIS {
   c.Lock();
   c.Unlock();
 }
+
+TEST(Mutex, SampledDeadlockDetectorFindsInversion) NO_THREAD_SAFETY_ANALYSIS {
+  // Sampling works in all builds, so this runs whether or not NDEBUG is set.
+  absl::SetMutexDeadlockDetectionMode(absl::OnDeadlockCycle::kAbort);
+  absl::SetMutexDeadlockDetectionSamplingRate(1);
+  absl::Mutex mu0;
+  absl::Mutex mu1;
+  mu0.Lock();
+  mu1.Lock();  // acquire mu1 while holding mu0
+  mu1.Unlock();
+  mu0.Unlock();
+  EXPECT_DEATH(
+      {
+        mu1.Lock();
+        mu0.Lock();  // acquire mu0 while holding mu1
+      },
+      "Potential Mutex deadlock");
+  absl::SetMutexDeadlockDetectionSamplingRate(0);
+}
+
+TEST(Mutex, SampledDeadlockDetectorSkipsAcquisitions) {
+  absl::SetMutexDeadlockDetectionMode(absl::OnDeadlockCycle::kAbort);
+  absl::SetMutexDeadlockDetectionSamplingRate(1000);
+  absl::Mutex mu0;
+  absl::Mutex mu1;
+  {
+    absl::MutexLock l0(&mu0);
+    absl::MutexLock l1(&mu1);
+  }
+  {
+    // The inversion is not sampled, as it is only the second acquisition
+    // made while holding another lock.
+    absl::MutexLock l1(&mu1);
+    absl::MutexLock l0(&mu0);
+  }
+  absl::SetMutexDeadlockDetectionSamplingRate(0);
+}
+
+// Returns the samples recorded for "mu".
+static std::vector<absl::MutexContentionSample> SamplesFor(
+    const absl::Mutex *mu) {
+  std::vector<absl::MutexContentionSample> samples;
+  for (auto &sample : absl::GetMutexContentionSamples()) {
+    if (sample.mutex == mu) samples.push_back(std::move(sample));
+  }
+  return samples;
+}
+
+// Makes another thread block in Lock() on "mu" for about "hold", then
+// releases it.
+static void BlockOtherThread(absl::Mutex *mu, absl::Duration hold) {
+  std::atomic<bool> started(false);
+  mu->Lock();
+  std::thread waiter([mu, &started] {
+    started.store(true);
+    mu->Lock();
+    mu->Unlock();
+  });
+  while (!started.load()) absl::SleepFor(absl::Milliseconds(1));
+  absl::SleepFor(hold);
+  mu->Unlock();
+  waiter.join();
+}
+
+TEST(Mutex, ContentionProfiler) {
+  absl::ResetMutexContentionProfile();
+  absl::Mutex mu;
+
+  // Disabled by default.
+  BlockOtherThread(&mu, absl::Milliseconds(50));
+  EXPECT_TRUE(SamplesFor(&mu).empty());
+
+  absl::SetMutexContentionProfilingRate(1);
+  for (int i = 0; i < 2; i++) {
+    BlockOtherThread(&mu, absl::Milliseconds(50));
+  }
+  absl::SetMutexContentionProfilingRate(0);
+
+  // Both waits have the same stacks, so they are aggregated.
+  const std::vector<absl::MutexContentionSample> samples = SamplesFor(&mu);
+  ASSERT_EQ(samples.size(), 1);
+  EXPECT_EQ(samples[0].count, 2);
+  EXPECT_GT(samples[0].wait_cycles, 0);
+  if (!samples[0].waiter_stack.empty()) {
+    // Stack traces work here, so the unlocking thread must have recorded
+    // its stack too.
+    EXPECT_FALSE(samples[0].holder_stack.empty());
+    const std::string profile = absl::GetMutexContentionProfile();
+    EXPECT_EQ(profile.find("--- contention\n"), 0) << profile;
+    EXPECT_NE(profile.find(" @ 0x"), std::string::npos) << profile;
+  }
+
+  absl::ResetMutexContentionProfile();
+  EXPECT_TRUE(SamplesFor(&mu).empty());
+}
+
+TEST(Mutex, ContentionProfilerIgnoresConditionWaits) {
+  absl::ResetMutexContentionProfile();
+  absl::SetMutexContentionProfilingRate(1);
+  absl::Mutex mu;
+  bool ready = false;
+  std::thread waiter([&mu, &ready] {
+    mu.LockWhen(absl::Condition(&ready));
+    mu.Unlock();
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  mu.Lock();
+  ready = true;
+  mu.Unlock();
+  waiter.join();
+  absl::SetMutexContentionProfilingRate(0);
+  EXPECT_TRUE(SamplesFor(&mu).empty());
+}
+
+// Returns the histograms recorded under "name", or empty ones.
+static absl::MutexLatencyHistogram HistogramFor(const std::string &name) {
+  for (auto &histogram : absl::GetMutexLatencyHistograms()) {
+    if (histogram.name == name) return histogram;
+  }
+  absl::MutexLatencyHistogram empty;
+  empty.name = name;
+  empty.cycles_per_second = absl::base_internal::CycleClock::Frequency();
+  empty.wait.count = empty.hold.count = 0;
+  empty.wait.total_cycles = empty.hold.total_cycles = 0;
+  return empty;
+}
+
+static int64_t ToCycles(absl::Duration d) {
+  return static_cast<int64_t>(absl::ToDoubleSeconds(d) *
+                              absl::base_internal::CycleClock::Frequency());
+}
+
+TEST(Mutex, LatencyHistograms) {
+  absl::ResetMutexLatencyHistograms();
+  absl::Mutex mu;
+  mu.EnableLatencyHistograms("LatencyHistograms mu");
+  for (int i = 0; i < 100; i++) {
+    absl::MutexLock l(&mu);
+  }
+  EXPECT_TRUE(mu.TryLock());
+  absl::SleepFor(absl::Milliseconds(20));
+  mu.Unlock();
+  BlockOtherThread(&mu, absl::Milliseconds(50));
+
+  const absl::MutexLatencyHistogram h = HistogramFor("LatencyHistograms mu");
+  // Lock() counts as a wait even when the Mutex is free, but TryLock() not.
+  EXPECT_EQ(h.wait.count, 102);
+  EXPECT_EQ(h.hold.count, 103);
+  // One wait and two holds took at least 20ms.
+  EXPECT_GE(h.wait.Quantile(1.0), ToCycles(absl::Milliseconds(20)));
+  EXPECT_GE(h.hold.Quantile(1.0), ToCycles(absl::Milliseconds(20)));
+  EXPECT_GE(h.hold.total_cycles, ToCycles(absl::Milliseconds(60)));
+  EXPECT_LT(h.hold.Quantile(0.9), ToCycles(absl::Milliseconds(20)));
+  // Times convert to seconds without CycleClock.
+  EXPECT_EQ(h.cycles_per_second, absl::base_internal::CycleClock::Frequency());
+  EXPECT_GE(h.hold.Quantile(1.0) / h.cycles_per_second, 0.02);
+
+  int64_t count = 0;
+  int64_t previous_upper_bound = 0;
+  for (const absl::MutexLatencyHistogram::Bucket &b : h.hold.buckets) {
+    EXPECT_GT(b.count, 0);
+    EXPECT_GE(b.lower_bound, previous_upper_bound);
+    EXPECT_LT(b.lower_bound, b.upper_bound);
+    if (b.lower_bound >= 4) {
+      // Log-linear buckets are at most 25% wide.
+      EXPECT_LE(b.upper_bound - b.lower_bound, b.lower_bound / 4);
+    }
+    previous_upper_bound = b.upper_bound;
+    count += b.count;
+  }
+  EXPECT_EQ(count, h.hold.count);
+
+  absl::ResetMutexLatencyHistograms();
+  const absl::MutexLatencyHistogram reset =
+      HistogramFor("LatencyHistograms mu");
+  EXPECT_EQ(reset.wait.count, 0);
+  EXPECT_EQ(reset.hold.count, 0);
+  EXPECT_TRUE(reset.hold.buckets.empty());
+  EXPECT_EQ(reset.hold.Quantile(0.5), 0);
+}
+
+TEST(Mutex, LatencyHistogramsAreSharedByName) {
+  absl::ResetMutexLatencyHistograms();
+  for (int i = 0; i < 3; i++) {
+    absl::Mutex mu;
+    mu.EnableLatencyHistograms("LatencyHistogramsAreSharedByName mu");
+    absl::MutexLock l(&mu);
+  }
+  EXPECT_EQ(HistogramFor("LatencyHistogramsAreSharedByName mu").hold.count, 3);
+}
+
+// A Mutex created where one with latency histograms was destroyed does not
+// inherit them, and one that also logs its events records each hold once.
+TEST(Mutex, LatencyHistogramsEndWithTheMutex) {
+  absl::ResetMutexLatencyHistograms();
+  alignas(absl::Mutex) char storage[sizeof(absl::Mutex)];
+  absl::Mutex *mu = new (storage) absl::Mutex;
+  mu->EnableLatencyHistograms("LatencyHistogramsEndWithTheMutex mu");
+  mu->EnableDebugLog(nullptr);
+  mu->Lock();
+  mu->Unlock();
+  mu->~Mutex();
+  mu = new (storage) absl::Mutex;
+  mu->Lock();
+  mu->Unlock();
+  mu->~Mutex();
+  const absl::MutexLatencyHistogram h =
+      HistogramFor("LatencyHistogramsEndWithTheMutex mu");
+  EXPECT_EQ(h.wait.count, 1);
+  EXPECT_EQ(h.hold.count, 1);
+}
+
+TEST(Mutex, LatencyHistogramsCountOverlappingReadersAsOneHold) {
+  absl::ResetMutexLatencyHistograms();
+  absl::Mutex mu;
+  mu.EnableLatencyHistograms("LatencyHistogramsCountOverlappingReaders mu");
+  mu.ReaderLock();
+  std::thread reader([&mu] {
+    mu.ReaderLock();
+    mu.ReaderUnlock();
+  });
+  reader.join();
+  mu.ReaderUnlock();
+  mu.ReaderLock();
+  mu.ReaderUnlock();
+  const absl::MutexLatencyHistogram h =
+      HistogramFor("LatencyHistogramsCountOverlappingReaders mu");
+  EXPECT_EQ(h.wait.count, 3);
+  EXPECT_EQ(h.hold.count, 2);
+}
+
+TEST(Mutex, LatencyHistogramsIgnoreConditionWaits) {
+  absl::ResetMutexLatencyHistograms();
+  absl::Mutex mu;
+  mu.EnableLatencyHistograms("LatencyHistogramsIgnoreConditionWaits mu");
+  bool ready = false;
+  std::thread waiter([&mu, &ready] {
+    mu.LockWhen(absl::Condition(&ready));
+    mu.Unlock();
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  mu.Lock();
+  ready = true;
+  mu.Unlock();
+  waiter.join();
+  const absl::MutexLatencyHistogram h =
+      HistogramFor("LatencyHistogramsIgnoreConditionWaits mu");
+  EXPECT_LT(h.wait.Quantile(1.0), ToCycles(absl::Milliseconds(50)));
+}
+
+TEST(Mutex, GlobalLatencyHistograms) {
+  absl::ResetMutexLatencyHistograms();
+  absl::Mutex mu;
+
+  // Disabled by default.
+  BlockOtherThread(&mu, absl::Milliseconds(20));
+  EXPECT_EQ(HistogramFor("").wait.count, 0);
+
+  absl::EnableMutexLatencyHistograms(true);
+  BlockOtherThread(&mu, absl::Milliseconds(20));
+  absl::Mutex named;
+  named.EnableDebugLog("GlobalLatencyHistograms named");
+  BlockOtherThread(&named, absl::Milliseconds(20));
+  absl::EnableMutexLatencyHistograms(false);
+
+  // The blocked waits are recorded, but not holds.
+  EXPECT_EQ(HistogramFor("").wait.count, 1);
+  EXPECT_GE(HistogramFor("").wait.Quantile(1.0),
+            ToCycles(absl::Milliseconds(20)));
+  // Every acquisition of a Mutex with a name takes the slow path.
+  const absl::MutexLatencyHistogram h =
+      HistogramFor("GlobalLatencyHistograms named");
+  EXPECT_EQ(h.wait.count, 2);
+  EXPECT_EQ(h.hold.count, 0);
+}
 #endif  // !defined(ABSL_INTERNAL_USE_NONPROD_MUTEX)
 
 // --------------------------------------------------------
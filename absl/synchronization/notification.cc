@@ -14,71 +14,150 @@
 
 #include "absl/synchronization/notification.h"
 
+#include <errno.h>
+
 #include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "absl/base/attributes.h"
 #include "absl/base/internal/raw_logging.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 
 namespace absl {
-void Notification::Notify() {
-  MutexLock l(&this->mutex_);
 
+constexpr int32_t Notification::kUnnotified;
+constexpr int32_t Notification::kWaiters;
+constexpr int32_t Notification::kNotifying;
+constexpr int32_t Notification::kNotified;
+constexpr uintptr_t Notification::kAsyncWaitersClosed;
+
+void Notification::Notify() {
+  const int32_t prev = state_.exchange(kNotifying, std::memory_order_acq_rel);
 #ifndef NDEBUG
-  if (ABSL_PREDICT_FALSE(notified_yet_.load(std::memory_order_relaxed))) {
+  if (ABSL_PREDICT_FALSE(prev >= kNotifying)) {
     ABSL_RAW_LOG(
         FATAL,
         "Notify() method called more than once for Notification object %p",
         static_cast<void *>(this));
   }
 #endif
+  if (prev == kWaiters) WakeThreads();
 
-  notified_yet_.store(true, std::memory_order_release);
-}
+  uintptr_t head =
+      async_waiters_.exchange(kAsyncWaitersClosed, std::memory_order_acq_rel);
+  if (head == kAsyncWaitersClosed) head = 0;
 
-Notification::~Notification() {
-  // Make sure that the thread running Notify() exits before the object is
-  // destructed.
-  MutexLock l(&this->mutex_);
+  // Waiters that see kNotifying may return, but the destructor waits for
+  // kNotified, after which this notification must not be touched.
+  state_.store(kNotified, std::memory_order_release);
+
+  // A woken waiter may destroy this notification, so wake them only now,
+  // and without touching *this.
+  AsyncWaiter *async_waiters = reinterpret_cast<AsyncWaiter *>(head);
+  while (async_waiters != nullptr) {
+    AsyncWaiter *w = async_waiters;
+    async_waiters = w->next;
+    w->wake(w->arg);
+  }
 }
 
-static inline bool HasBeenNotifiedInternal(
-    const std::atomic<bool> *notified_yet) {
-  return notified_yet->load(std::memory_order_acquire);
+bool Notification::AddAsyncWaiter(AsyncWaiter *w) const {
+  uintptr_t head = async_waiters_.load(std::memory_order_acquire);
+  do {
+    if (head == kAsyncWaitersClosed) return false;
+    w->next = reinterpret_cast<AsyncWaiter *>(head);
+  } while (!async_waiters_.compare_exchange_weak(
+      head, reinterpret_cast<uintptr_t>(w), std::memory_order_release,
+      std::memory_order_acquire));
+  return true;
 }
 
-bool Notification::HasBeenNotified() const {
-  return HasBeenNotifiedInternal(&this->notified_yet_);
+Notification::~Notification() {
+  // Make sure that the thread running Notify() exits before the object is
+  // destructed.
+  while (state_.load(std::memory_order_acquire) == kNotifying) {
+    std::this_thread::yield();
+  }
 }
 
 void Notification::WaitForNotification() const {
-  if (!HasBeenNotifiedInternal(&this->notified_yet_)) {
-    this->mutex_.LockWhen(Condition(&HasBeenNotifiedInternal,
-                                    &this->notified_yet_));
-    this->mutex_.Unlock();
+  if (!HasBeenNotified()) {
+    WaitUntil(absl::InfiniteFuture());
   }
 }
 
 bool Notification::WaitForNotificationWithTimeout(
     absl::Duration timeout) const {
-  bool notified = HasBeenNotifiedInternal(&this->notified_yet_);
+  bool notified = HasBeenNotified();
   if (!notified) {
-    notified = this->mutex_.LockWhenWithTimeout(
-        Condition(&HasBeenNotifiedInternal, &this->notified_yet_), timeout);
-    this->mutex_.Unlock();
+    notified = WaitUntil(absl::Now() + timeout);
   }
   return notified;
 }
 
 bool Notification::WaitForNotificationWithDeadline(absl::Time deadline) const {
-  bool notified = HasBeenNotifiedInternal(&this->notified_yet_);
+  bool notified = HasBeenNotified();
   if (!notified) {
-    notified = this->mutex_.LockWhenWithDeadline(
-        Condition(&HasBeenNotifiedInternal, &this->notified_yet_), deadline);
-    this->mutex_.Unlock();
+    notified = WaitUntil(deadline);
   }
   return notified;
 }
 
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+bool Notification::WaitUntil(absl::Time deadline) const {
+  const synchronization_internal::KernelTimeout t(deadline);
+  int32_t s = state_.load(std::memory_order_acquire);
+  while (s < kNotifying) {
+    // Tell Notify() that it must wake this thread.
+    if (s == kUnnotified &&
+        !state_.compare_exchange_weak(s, kWaiters, std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+      continue;
+    }
+    const int err = synchronization_internal::Futex::WaitUntil(&state_,
+                                                                kWaiters, t);
+    if (err == -ETIMEDOUT) {
+      return HasBeenNotified();
+    }
+    if (err != 0 && err != -EINTR && err != -EWOULDBLOCK) {
+      ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+    }
+    s = state_.load(std::memory_order_acquire);
+  }
+  return true;
+}
+
+void Notification::WakeThreads() {
+  const int err = synchronization_internal::Futex::Wake(
+      &state_, std::numeric_limits<int32_t>::max());
+  if (ABSL_PREDICT_FALSE(err < 0)) {
+    ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+  }
+}
+
+#else  // ABSL_INTERNAL_HAVE_FUTEX
+
+bool Notification::WaitUntil(absl::Time deadline) const {
+  // Tell Notify() that it must wake this thread.
+  int32_t s = kUnnotified;
+  state_.compare_exchange_strong(s, kWaiters, std::memory_order_relaxed,
+                                 std::memory_order_relaxed);
+  const bool notified = this->mutex_.LockWhenWithDeadline(
+      Condition(this, &Notification::HasBeenNotified), deadline);
+  this->mutex_.Unlock();
+  return notified;
+}
+
+void Notification::WakeThreads() {
+  MutexLock l(&this->mutex_);
+}
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
+
 }  // namespace absl
@@ -51,20 +51,33 @@
 #define ABSL_SYNCHRONIZATION_NOTIFICATION_H_
 
 #include <atomic>
+#include <cstdint>
 
+#include "absl/synchronization/internal/futex.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 
 namespace absl {
 
+namespace coroutine_internal {
+class NotificationAwaiter;
+}  // namespace coroutine_internal
+
 // -----------------------------------------------------------------------------
 // Notification
 // -----------------------------------------------------------------------------
+//
+// A `Notification` is a single atomic word that threads wait on directly
+// (with a futex, where the platform has one), so none of its methods takes a
+// lock, and calls on a notification that has already been notified do a
+// single atomic load.
 class Notification {
  public:
   // Initializes the "notified" state to unnotified.
-  Notification() : notified_yet_(false) {}
-  explicit Notification(bool prenotify) : notified_yet_(prenotify) {}
+  Notification() : state_(kUnnotified), async_waiters_(0) {}
+  explicit Notification(bool prenotify)
+      : state_(prenotify ? kNotified : kUnnotified),
+        async_waiters_(prenotify ? kAsyncWaitersClosed : 0) {}
   Notification(const Notification&) = delete;
   Notification& operator=(const Notification&) = delete;
   ~Notification();
@@ -72,7 +85,9 @@ class Notification {
   // Notification::HasBeenNotified()
   //
   // Returns the value of the notification's internal "notified" state.
-  bool HasBeenNotified() const;
+  bool HasBeenNotified() const {
+    return state_.load(std::memory_order_acquire) >= kNotifying;
+  }
 
   // Notification::WaitForNotification()
   //
@@ -104,8 +119,47 @@ class Notification {
   void Notify();
 
  private:
+  // Support for `co_await notification` (see coroutine.h), which suspends a
+  // coroutine instead of blocking its thread.
+  friend class coroutine_internal::NotificationAwaiter;
+
+  // A waiter other than a blocked thread, woken by calling `wake(arg)`.
+  struct AsyncWaiter {
+    void (*wake)(void* arg);
+    void* arg;
+    AsyncWaiter* next;
+  };
+
+  // Adds `w` to the waiters that Notify() wakes, and returns true, unless
+  // this notification has already been notified, in which case it returns
+  // false.
+  bool AddAsyncWaiter(AsyncWaiter* w) const;
+
+  // Blocks until this notification has been notified or `deadline` has
+  // passed, and returns whether it has been notified.
+  bool WaitUntil(absl::Time deadline) const;
+
+  // Wakes the threads blocked in WaitUntil().
+  void WakeThreads();
+
+  // Values of state_. Notify() moves it to kNotifying, and to kNotified once
+  // it no longer touches this notification.
+  static constexpr int32_t kUnnotified = 0;
+  static constexpr int32_t kWaiters = 1;  // threads may be blocked
+  static constexpr int32_t kNotifying = 2;
+  static constexpr int32_t kNotified = 3;
+
+  // The value of async_waiters_ once Notify() has taken the list.
+  static constexpr uintptr_t kAsyncWaitersClosed = 1;
+
+  mutable std::atomic<int32_t> state_;
+  // The top of a stack of AsyncWaiters, or kAsyncWaitersClosed.
+  mutable std::atomic<uintptr_t> async_waiters_;
+#ifndef ABSL_INTERNAL_HAVE_FUTEX
+  // Without a futex, threads block in mutex_.LockWhen(), and Notify()
+  // acquires and releases mutex_ to make them re-evaluate their Condition.
   mutable Mutex mutex_;
-  std::atomic<bool> notified_yet_;  // written under mutex_
+#endif
 };
 
 }  // namespace absl
@@ -121,4 +121,38 @@ TEST(NotificationTest, SanityTest) {
   BasicTests(true, &local_notification2);
 }
 
+TEST(NotificationTest, WaiterMayDestroyNotification) {
+  for (int i = 0; i < 1000; ++i) {
+    Notification* notification = new Notification;
+    std::thread notifier([notification] { notification->Notify(); });
+    notification->WaitForNotification();
+    // Notify() may still be running in the other thread.
+    delete notification;
+    notifier.join();
+  }
+}
+
+TEST(NotificationTest, TimedAndUntimedWaiters) {
+  Notification notification;
+  ThreadSafeCounter done_counter;
+  const int kNumThreads = 8;
+  std::vector<std::thread> workers;
+  for (int i = 0; i < kNumThreads; ++i) {
+    workers.push_back(std::thread([&notification, &done_counter, i] {
+      if (i % 2 == 0) {
+        notification.WaitForNotification();
+      } else {
+        EXPECT_TRUE(
+            notification.WaitForNotificationWithTimeout(absl::Seconds(100)));
+      }
+      done_counter.Increment();
+    }));
+  }
+  notification.Notify();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  EXPECT_EQ(kNumThreads, done_counter.Get());
+}
+
 }  // namespace absl
@@ -0,0 +1,189 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// read_mostly.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::ReadMostly<T>`, which holds an immutable `T`
+// that many threads read and that is occasionally replaced as a whole, such as
+// a server's configuration.
+//
+//   absl::ReadMostly<Config> config(absl::make_unique<Config>(...));
+//
+//   // Readers
+//   {
+//     absl::ReadMostly<Config>::Reader reader(&config);
+//     Use(reader->some_field);
+//   }
+//
+//   // Writer
+//   config.Update(absl::make_unique<Config>(...));
+//
+// Readers take no lock and write only to their own thread's state, so any
+// number of them proceed in parallel without contending on a cache line, as
+// they would on a `Mutex` or on the reference count of a shared `shared_ptr`.
+// A reader may keep using the value it found for as long as its `Reader`
+// lives, even if the value has since been replaced.
+//
+// Replaced values are freed by epoch-based reclamation: each reader records
+// in its thread's identity the epoch in which it started, and a replaced value
+// is freed once every reader that started before the replacement has
+// finished. `Update()` frees the replaced values that are no longer in use
+// without waiting; `Synchronize()` waits for the rest. Readers should
+// therefore be short, as a long one keeps every value replaced during its
+// lifetime alive.
+//
+// Unlike `absl::SeqLock`, values are never copied, so `T` may be large and of
+// any type; in exchange, every update allocates.
+
+#ifndef ABSL_SYNCHRONIZATION_READ_MOSTLY_H_
+#define ABSL_SYNCHRONIZATION_READ_MOSTLY_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/internal/epoch.h"
+#include "absl/synchronization/mutex.h"
+
+namespace absl {
+
+// ReadMostly
+//
+// Holds a pointer to an immutable `T`, which may be null. All member functions
+// except the destructor are thread-safe.
+template <typename T>
+class ReadMostly {
+ public:
+  // Creates a ReadMostly holding `value`.
+  explicit ReadMostly(std::unique_ptr<const T> value = nullptr)
+      : value_(value.release()) {}
+
+  ReadMostly(const ReadMostly&) = delete;
+  ReadMostly& operator=(const ReadMostly&) = delete;
+
+  // Destroys the current and all replaced values. No other thread may be
+  // using the ReadMostly, and no `Reader` of it may be alive.
+  ~ReadMostly();
+
+  // ReadMostly::Reader
+  //
+  // A read-side section: gives access to the value current at its creation,
+  // which remains valid until it is destroyed. Readers may nest, including
+  // readers of different ReadMostly objects. A thread must not call
+  // `Synchronize()` while it has a Reader.
+  class Reader {
+   public:
+    explicit Reader(const ReadMostly* cell) {
+      synchronization_internal::EpochEnter();
+      value_ = cell->value_.load(std::memory_order_acquire);
+    }
+    ~Reader() { synchronization_internal::EpochExit(); }
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    const T* get() const { return value_; }
+    const T& operator*() const { return *value_; }
+    const T* operator->() const { return value_; }
+
+   private:
+    const T* value_;
+  };
+
+  // ReadMostly::Read()
+  //
+  // Returns `f(value)`, where `value` is a const pointer to the current value,
+  // and remains valid only until `f` returns.
+  template <typename F>
+  auto Read(F f) const -> decltype(f(static_cast<const T*>(nullptr))) {
+    Reader reader(this);
+    return f(reader.get());
+  }
+
+  // ReadMostly::Update()
+  //
+  // Replaces the value with `value`. The previous value is freed once no
+  // reader can be using it, possibly by a later call. Updates are serialized.
+  void Update(std::unique_ptr<const T> value) LOCKS_EXCLUDED(mu_);
+
+  // ReadMostly::Synchronize()
+  //
+  // Blocks until all the values replaced before the call have been freed,
+  // which requires the readers that started before the call to finish.
+  void Synchronize() LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Retired {
+    const T* value;
+    uint64_t epoch;  // in which it was replaced
+  };
+
+  // Frees the replaced values that no reader can be using.
+  void ReclaimLocked(uint64_t oldest_reader) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::atomic<const T*> value_;
+  Mutex mu_;  // serializes writers
+  std::vector<Retired> retired_ GUARDED_BY(mu_);  // in order of epoch
+};
+
+// -----------------------------------------------------------------------------
+// Implementation details follow
+// -----------------------------------------------------------------------------
+
+template <typename T>
+ReadMostly<T>::~ReadMostly() {
+  MutexLock l(&mu_);
+  for (const Retired& r : retired_) delete r.value;
+  delete value_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void ReadMostly<T>::Update(std::unique_ptr<const T> value) {
+  MutexLock l(&mu_);
+  const T* old = value_.exchange(value.release(), std::memory_order_acq_rel);
+  if (old != nullptr) {
+    retired_.push_back({old, synchronization_internal::EpochAdvance()});
+  }
+  if (!retired_.empty()) {
+    ReclaimLocked(synchronization_internal::EpochOldestReader());
+  }
+}
+
+template <typename T>
+void ReadMostly<T>::Synchronize() {
+  MutexLock l(&mu_);
+  if (retired_.empty()) return;
+  const uint64_t epoch = retired_.back().epoch;
+  synchronization_internal::EpochWaitForReaders(epoch);
+  ReclaimLocked(epoch + 1);
+}
+
+template <typename T>
+void ReadMostly<T>::ReclaimLocked(uint64_t oldest_reader) {
+  size_t n = 0;
+  while (n != retired_.size() && retired_[n].epoch < oldest_reader) {
+    delete retired_[n].value;
+    n++;
+  }
+  retired_.erase(retired_.begin(), retired_.begin() + n);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_READ_MOSTLY_H_
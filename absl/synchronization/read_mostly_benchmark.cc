@@ -0,0 +1,115 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/read_mostly.h"
+
+namespace {
+
+struct Config {
+  int64_t fields[16] = {};
+};
+
+// A shared_ptr guarded by a Mutex, of which readers take a copy; for
+// comparison.
+class SharedPtrConfig {
+ public:
+  SharedPtrConfig() : config_(std::make_shared<const Config>()) {}
+
+  int64_t ReadField() {
+    std::shared_ptr<const Config> config;
+    {
+      absl::ReaderMutexLock l(&mu_);
+      config = config_;
+    }
+    return config->fields[0];
+  }
+
+  void Update(std::unique_ptr<const Config> config) {
+    std::shared_ptr<const Config> old;
+    absl::MutexLock l(&mu_);
+    old = std::move(config_);
+    config_ = std::move(config);
+  }
+
+ private:
+  absl::Mutex mu_;
+  std::shared_ptr<const Config> config_ GUARDED_BY(mu_);
+};
+
+class ReadMostlyConfig {
+ public:
+  ReadMostlyConfig() : config_(absl::make_unique<const Config>()) {}
+
+  int64_t ReadField() {
+    absl::ReadMostly<Config>::Reader reader(&config_);
+    return reader->fields[0];
+  }
+
+  void Update(std::unique_ptr<const Config> config) {
+    config_.Update(std::move(config));
+  }
+
+ private:
+  absl::ReadMostly<Config> config_;
+};
+
+// Every thread reads a field of the current Config.
+template <typename Holder>
+void BM_Read(benchmark::State& state) {
+  static Holder* holder = new Holder;
+  int64_t sum = 0;
+  for (auto _ : state) {
+    sum += holder->ReadField();
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK_TEMPLATE(BM_Read, SharedPtrConfig)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Read, ReadMostlyConfig)
+    ->ThreadRange(1, 64)
+    ->UseRealTime();
+
+// Replaces the Config, while state.range(0) background threads read it.
+template <typename Holder>
+void BM_Update(benchmark::State& state) {
+  Holder holder;
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < state.range(0); ++i) {
+    readers.emplace_back([&holder, &done] {
+      int64_t sum = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        sum += holder.ReadField();
+      }
+      benchmark::DoNotOptimize(sum);
+    });
+  }
+  for (auto _ : state) {
+    holder.Update(absl::make_unique<const Config>());
+  }
+  done.store(true);
+  for (std::thread& reader : readers) reader.join();
+}
+BENCHMARK_TEMPLATE(BM_Update, SharedPtrConfig)->Arg(0)->Arg(1)->Arg(8);
+BENCHMARK_TEMPLATE(BM_Update, ReadMostlyConfig)->Arg(0)->Arg(1)->Arg(8);
+
+}  // namespace
@@ -0,0 +1,154 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/read_mostly.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/notification.h"
+
+namespace {
+
+std::atomic<int> live_values(0);
+
+// A value that counts its live instances, and that readers can check has not
+// been destroyed.
+class Value {
+ public:
+  explicit Value(int version) : version_(version), magic_(kMagic) {
+    live_values++;
+  }
+  ~Value() {
+    magic_ = 0;
+    live_values--;
+  }
+
+  int version() const {
+    EXPECT_EQ(magic_, kMagic) << "use after free";
+    return version_;
+  }
+
+ private:
+  static constexpr int kMagic = 0x5eed;
+
+  const int version_;
+  volatile int magic_;
+};
+
+constexpr int Value::kMagic;
+
+TEST(ReadMostly, ReadsTheCurrentValue) {
+  {
+    absl::ReadMostly<Value> cell;
+    {
+      absl::ReadMostly<Value>::Reader reader(&cell);
+      EXPECT_EQ(reader.get(), nullptr);
+    }
+    cell.Update(absl::make_unique<Value>(1));
+    {
+      absl::ReadMostly<Value>::Reader reader(&cell);
+      EXPECT_EQ(reader->version(), 1);
+    }
+    cell.Update(absl::make_unique<Value>(2));
+    EXPECT_EQ(cell.Read([](const Value* v) { return v->version(); }), 2);
+  }
+  EXPECT_EQ(live_values.load(), 0);
+}
+
+TEST(ReadMostly, ReplacedValueIsFreedWhenNoReaderRemains) {
+  absl::ReadMostly<Value> cell(absl::make_unique<Value>(1));
+  cell.Update(absl::make_unique<Value>(2));
+  EXPECT_EQ(live_values.load(), 1);
+
+  {
+    absl::ReadMostly<Value>::Reader outer(&cell);
+    absl::ReadMostly<Value>::Reader inner(&cell);  // nested
+    cell.Update(absl::make_unique<Value>(3));
+    cell.Update(absl::make_unique<Value>(4));
+    // Value 2 is held by the readers, and 3 by the epoch they started in.
+    EXPECT_EQ(live_values.load(), 3);
+    EXPECT_EQ(outer->version(), 2);
+    EXPECT_EQ(inner->version(), 2);
+  }
+  cell.Synchronize();
+  EXPECT_EQ(live_values.load(), 1);
+}
+
+TEST(ReadMostly, SynchronizeWaitsForReaders) {
+  absl::ReadMostly<Value> cell(absl::make_unique<Value>(1));
+  absl::Notification reading;
+  absl::Notification done_reading;
+  std::atomic<bool> synchronized(false);
+  std::thread reader_thread([&] {
+    absl::ReadMostly<Value>::Reader reader(&cell);
+    reading.Notify();
+    done_reading.WaitForNotification();
+    EXPECT_FALSE(synchronized.load());
+    EXPECT_EQ(reader->version(), 1);
+  });
+  reading.WaitForNotification();
+  cell.Update(absl::make_unique<Value>(2));
+  EXPECT_EQ(live_values.load(), 2);
+  std::thread writer_thread([&] {
+    cell.Synchronize();
+    synchronized.store(true);
+  });
+  done_reading.Notify();
+  reader_thread.join();
+  writer_thread.join();
+  EXPECT_EQ(live_values.load(), 1);
+}
+
+// Readers check that the values they see are alive and never go backwards,
+// while a writer replaces the value, and threads come and go so that their
+// identities are reused.
+TEST(ReadMostly, ConcurrentReadersAndWriter) {
+  constexpr int kReaders = 4;
+  constexpr int kVersions = 5000;
+  {
+    absl::ReadMostly<Value> cell(absl::make_unique<Value>(0));
+    std::atomic<bool> done(false);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+      readers.emplace_back([&cell, &done] {
+        int last_version = 0;
+        while (!done.load(std::memory_order_relaxed)) {
+          std::thread short_lived([&cell, &last_version] {
+            for (int j = 0; j < 100; j++) {
+              absl::ReadMostly<Value>::Reader reader(&cell);
+              ASSERT_GE(reader->version(), last_version);
+              last_version = reader->version();
+            }
+          });
+          short_lived.join();
+        }
+      });
+    }
+    for (int version = 1; version <= kVersions; ++version) {
+      cell.Update(absl::make_unique<Value>(version));
+    }
+    done.store(true);
+    for (std::thread& reader : readers) reader.join();
+    cell.Synchronize();
+    EXPECT_EQ(live_values.load(), 1);
+  }
+  EXPECT_EQ(live_values.load(), 0);
+}
+
+}  // namespace
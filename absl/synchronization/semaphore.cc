@@ -0,0 +1,135 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/semaphore.h"
+
+#include <errno.h>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "absl/base/internal/raw_logging.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace absl {
+
+constexpr uint64_t Semaphore::kWaiter;
+constexpr uint64_t Semaphore::kBulkWaiter;
+
+static_assert(sizeof(std::atomic<uint64_t>) ==
+                  2 * sizeof(std::atomic<int32_t>),
+              "Semaphore::CountWord() needs atomics laid out as integers");
+
+bool Semaphore::AcquireWithTimeout(absl::Duration timeout, int n) {
+  return TryAcquire(n) || AcquireSlow(n, absl::Now() + timeout);
+}
+
+bool Semaphore::AcquireWithDeadline(absl::Time deadline, int n) {
+  return TryAcquire(n) || AcquireSlow(n, deadline);
+}
+
+// A waiter for one unit can use any release, so Release() wakes only as many
+// of them as it released units. A waiter for more units might not be able to
+// use the release that woke it, and would absorb a wakeup that another waiter
+// could have used, so while there is one, every waiter is woken.
+void Semaphore::WakeWaiters(uint64_t word, int n) {
+  const int32_t count =
+      word >= kBulkWaiter ? std::numeric_limits<int32_t>::max() : n;
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+  const int err = synchronization_internal::Futex::Wake(CountWord(), count);
+  if (ABSL_PREDICT_FALSE(err < 0)) {
+    ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+  }
+#else
+  static_cast<void>(count);
+  MutexLock l(&mutex_);
+#endif
+}
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+bool Semaphore::AcquireSlow(int n, absl::Time deadline) {
+  const synchronization_internal::KernelTimeout t(deadline);
+  const uint64_t weight = n > 1 ? kBulkWaiter : kWaiter;
+  uint64_t word = word_.fetch_add(weight, std::memory_order_relaxed) + weight;
+  bool acquired = false;
+  for (;;) {
+    if (Count(word) >= n) {
+      if (word_.compare_exchange_weak(word, word - static_cast<uint64_t>(n),
+                                      std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+        acquired = true;
+        break;
+      }
+      continue;
+    }
+    const int err = synchronization_internal::Futex::WaitUntil(
+        CountWord(), Count(word), t);
+    if (err == -ETIMEDOUT) {
+      // Units released as the deadline passed are still taken, so that a
+      // wakeup meant for this thread is not lost.
+      acquired = TryAcquire(n);
+      break;
+    }
+    if (err != 0 && err != -EINTR && err != -EWOULDBLOCK) {
+      ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+    }
+    word = word_.load(std::memory_order_relaxed);
+  }
+  word_.fetch_sub(weight, std::memory_order_relaxed);
+  return acquired;
+}
+
+#else  // ABSL_INTERNAL_HAVE_FUTEX
+
+namespace {
+
+struct CountAtLeast {
+  static bool Eval(const CountAtLeast* c) {
+    return static_cast<int32_t>(c->word->load(std::memory_order_relaxed)) >=
+           c->n;
+  }
+
+  const std::atomic<uint64_t>* word;
+  int n;
+};
+
+}  // namespace
+
+bool Semaphore::AcquireSlow(int n, absl::Time deadline) {
+  const uint64_t weight = n > 1 ? kBulkWaiter : kWaiter;
+  word_.fetch_add(weight, std::memory_order_relaxed);
+  const CountAtLeast cond = {&word_, n};
+  bool acquired;
+  mutex_.Lock();
+  // Units may be taken by threads that do not hold mutex_, so check again.
+  while (!(acquired = TryAcquire(n))) {
+    if (!mutex_.AwaitWithDeadline(Condition(&CountAtLeast::Eval, &cond),
+                                  deadline)) {
+      acquired = TryAcquire(n);
+      break;
+    }
+  }
+  mutex_.Unlock();
+  word_.fetch_sub(weight, std::memory_order_relaxed);
+  return acquired;
+}
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
+
+}  // namespace absl
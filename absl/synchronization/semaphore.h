@@ -0,0 +1,154 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// semaphore.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::Semaphore`, a counting semaphore, which is
+// typically used to bound the number of threads doing something at once:
+//
+//   absl::Semaphore slots(kMaxConcurrentRpcs);
+//
+//   void IssueRpc() {
+//     slots.Acquire();
+//     ...
+//     slots.Release();
+//   }
+//
+// A `Semaphore` is a single atomic word, holding the count and the number of
+// waiting threads, that threads wait on directly (with a futex, where the
+// platform has one), so acquiring available units and releasing units each
+// take one atomic operation and no lock. Waiting threads are not served in
+// any particular order.
+//
+// Memory ordering: For any threads X and Y, any action taken by X before it
+// calls `Release()` is visible to Y after Y acquires units that X released.
+
+#ifndef ABSL_SYNCHRONIZATION_SEMAPHORE_H_
+#define ABSL_SYNCHRONIZATION_SEMAPHORE_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/config.h"
+#include "absl/synchronization/internal/futex.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace absl {
+
+// Semaphore
+//
+// Holds a count of units, never negative. The count may not exceed
+// `INT32_MAX`, and a Semaphore must not be destroyed while any of its methods
+// may still be running in another thread.
+class Semaphore {
+ public:
+  explicit Semaphore(int initial_count = 0)
+      : word_(static_cast<uint32_t>(initial_count)) {}
+
+  Semaphore(const Semaphore&) = delete;
+  Semaphore& operator=(const Semaphore&) = delete;
+
+  // Semaphore::TryAcquire()
+  //
+  // Takes `n` units if the count is at least `n`, and returns whether it did.
+  bool TryAcquire(int n = 1) {
+    uint64_t word = word_.load(std::memory_order_relaxed);
+    while (Count(word) >= n) {
+      if (word_.compare_exchange_weak(word, word - static_cast<uint64_t>(n),
+                                      std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Semaphore::Acquire()
+  //
+  // Blocks until the count is at least `n`, and takes `n` units. The units are
+  // taken all at once, so threads waiting for different numbers of units never
+  // hold some of them while waiting for the rest.
+  void Acquire(int n = 1) {
+    if (!TryAcquire(n)) AcquireSlow(n, absl::InfiniteFuture());
+  }
+
+  // Semaphore::AcquireWithTimeout()
+  //
+  // Like `Acquire()`, but gives up once `timeout` has elapsed, returning
+  // whether the units were taken.
+  bool AcquireWithTimeout(absl::Duration timeout, int n = 1);
+
+  // Semaphore::AcquireWithDeadline()
+  //
+  // Like `Acquire()`, but gives up once `deadline` has passed, returning
+  // whether the units were taken.
+  bool AcquireWithDeadline(absl::Time deadline, int n = 1);
+
+  // Semaphore::Release()
+  //
+  // Adds `n` units to the count, and wakes threads waiting for them.
+  void Release(int n = 1) {
+    // A thread in AcquireSlow() adds itself to the same word before it reads
+    // the count, so either this thread sees the waiter, or the waiter sees
+    // the new count.
+    const uint64_t word =
+        word_.fetch_add(static_cast<uint64_t>(n), std::memory_order_release);
+    if (word >= kWaiter) WakeWaiters(word, n);
+  }
+
+ private:
+  // The low 32 bits of word_ hold the count, and the high 32 bits the threads
+  // in AcquireSlow(), each waiter for a single unit counting as kWaiter and
+  // each waiter for more than one as kBulkWaiter. As the count never exceeds
+  // INT32_MAX, adding to it never carries into the waiters.
+  static constexpr uint64_t kWaiter = uint64_t{1} << 32;
+  static constexpr uint64_t kBulkWaiter = uint64_t{1} << 48;
+
+  static int32_t Count(uint64_t word) { return static_cast<int32_t>(word); }
+
+  // The half of word_ that holds the count, on which waiters block.
+  std::atomic<int32_t>* CountWord() {
+    return reinterpret_cast<std::atomic<int32_t>*>(
+        reinterpret_cast<char*>(&word_) +
+#ifdef ABSL_IS_BIG_ENDIAN
+        sizeof(int32_t)
+#else
+        0
+#endif
+    );
+  }
+
+  // Blocks until `n` units have been taken, returning true, or `deadline` has
+  // passed, returning false.
+  bool AcquireSlow(int n, absl::Time deadline);
+
+  // Wakes threads after `n` units have been released, given the value of
+  // word_ before the release.
+  void WakeWaiters(uint64_t word, int n);
+
+  std::atomic<uint64_t> word_;
+#ifndef ABSL_INTERNAL_HAVE_FUTEX
+  // Without a futex, threads block in mutex_.AwaitWithDeadline(), and
+  // Release() acquires and releases mutex_ to make them re-evaluate their
+  // Condition.
+  Mutex mutex_;
+#endif
+};
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_SEMAPHORE_H_
@@ -0,0 +1,66 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark/benchmark.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/semaphore.h"
+
+namespace {
+
+// A counting semaphore built from a Mutex and a Condition, for comparison.
+class MutexSemaphore {
+ public:
+  explicit MutexSemaphore(int count) : count_(count) {}
+
+  void Acquire() {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &MutexSemaphore::Available));
+    count_--;
+  }
+  void Release() {
+    absl::MutexLock l(&mu_);
+    count_++;
+  }
+
+ private:
+  bool Available() const EXCLUSIVE_LOCKS_REQUIRED(mu_) { return count_ > 0; }
+
+  absl::Mutex mu_;
+  int count_ GUARDED_BY(mu_);
+};
+
+// Every thread repeatedly acquires and releases one of state.range(0) units.
+template <typename Semaphore>
+void BM_AcquireRelease(benchmark::State& state) {
+  static Semaphore* sem;
+  if (state.thread_index == 0) sem = new Semaphore(state.range(0));
+  for (auto _ : state) {
+    sem->Acquire();
+    sem->Release();
+  }
+  if (state.thread_index == 0) delete sem;
+}
+
+void SetUpAcquireRelease(benchmark::internal::Benchmark* bm) {
+  bm->Arg(1)->Arg(4)->Arg(64);
+  bm->ThreadRange(1, 64);
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_AcquireRelease, MutexSemaphore)
+    ->Apply(SetUpAcquireRelease);
+BENCHMARK_TEMPLATE(BM_AcquireRelease, absl::Semaphore)
+    ->Apply(SetUpAcquireRelease);
+
+}  // namespace
@@ -0,0 +1,127 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/semaphore.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+TEST(Semaphore, TryAcquire) {
+  absl::Semaphore sem(3);
+  EXPECT_TRUE(sem.TryAcquire());
+  EXPECT_FALSE(sem.TryAcquire(3));
+  EXPECT_TRUE(sem.TryAcquire(2));
+  EXPECT_FALSE(sem.TryAcquire());
+  sem.Release(2);
+  EXPECT_TRUE(sem.TryAcquire(2));
+  EXPECT_FALSE(sem.TryAcquire());
+}
+
+TEST(Semaphore, AcquireWithTimeout) {
+  absl::Semaphore sem(1);
+  EXPECT_TRUE(sem.AcquireWithTimeout(absl::ZeroDuration()));
+  EXPECT_FALSE(sem.AcquireWithTimeout(absl::ZeroDuration()));
+  EXPECT_FALSE(sem.AcquireWithDeadline(absl::InfinitePast()));
+
+  absl::Time start = absl::Now();
+  EXPECT_FALSE(sem.AcquireWithTimeout(absl::Milliseconds(50)));
+  EXPECT_LE(start + absl::Milliseconds(50), absl::Now());
+
+  std::thread releaser([&sem] {
+    absl::SleepFor(absl::Milliseconds(50));
+    sem.Release();
+  });
+  EXPECT_TRUE(sem.AcquireWithTimeout(absl::Seconds(60)));
+  releaser.join();
+}
+
+TEST(Semaphore, AcquireBlocksUntilRelease) {
+  absl::Semaphore sem;
+  std::atomic<bool> acquired(false);
+  std::thread waiter([&sem, &acquired] {
+    sem.Acquire(2);
+    acquired.store(true);
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  sem.Release();
+  absl::SleepFor(absl::Milliseconds(50));
+  // One unit is not enough.
+  EXPECT_FALSE(acquired.load());
+  sem.Release();
+  waiter.join();
+  EXPECT_TRUE(acquired.load());
+  EXPECT_FALSE(sem.TryAcquire());
+}
+
+// A release of one unit must reach a waiter for one unit even while a waiter
+// for more units that it cannot satisfy is also blocked.
+TEST(Semaphore, MixedWaiters) {
+  absl::Semaphore sem;
+  absl::Notification small_acquired;
+  std::thread large([&sem] { sem.Acquire(3); });
+  std::thread small([&sem, &small_acquired] {
+    sem.Acquire(1);
+    small_acquired.Notify();
+  });
+  absl::SleepFor(absl::Milliseconds(50));
+  sem.Release();
+  EXPECT_TRUE(small_acquired.WaitForNotificationWithTimeout(absl::Seconds(60)));
+  sem.Release(3);
+  large.join();
+  small.join();
+}
+
+// Threads bounded by the semaphore never exceed its count, and all units are
+// returned at the end.
+TEST(Semaphore, BoundsConcurrency) {
+  constexpr int kSlots = 3;
+  constexpr int kThreads = 8;
+  constexpr int kIterations = 2000;
+  absl::Semaphore sem(kSlots);
+  std::atomic<int> inside(0);
+  std::atomic<int> max_inside(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < kIterations; j++) {
+        const int n = (i + j) % 2 + 1;
+        if (j % 3 == 0) {
+          if (!sem.AcquireWithTimeout(absl::Microseconds(100), n)) continue;
+        } else {
+          sem.Acquire(n);
+        }
+        const int now = inside.fetch_add(n) + n;
+        int max = max_inside.load();
+        while (now > max && !max_inside.compare_exchange_weak(max, now)) {
+        }
+        inside.fetch_sub(n);
+        sem.Release(n);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_LE(max_inside.load(), kSlots);
+  EXPECT_TRUE(sem.TryAcquire(kSlots));
+  EXPECT_FALSE(sem.TryAcquire());
+}
+
+}  // namespace
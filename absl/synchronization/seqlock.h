@@ -0,0 +1,223 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// seqlock.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::SeqLock<T>`, which holds a value of a
+// trivially copyable type `T` that many threads read and few threads write,
+// such as a configuration snapshot or a small routing table.
+//
+//   absl::SeqLock<RoutingTable> table;
+//
+//   // Readers
+//   RoutingTable snapshot = table.Load();
+//
+//   // Writer
+//   table.Store(new_table);
+//
+// Readers take no lock and write no shared memory, so any number of them
+// proceed in parallel without contending on a cache line. This is Lamport's
+// method for reading a multiword clock, as used by `absl::Now()`: a writer
+// makes a sequence number odd, writes the value, and makes the sequence number
+// even again, and a reader copies the value between two reads of the sequence
+// number and retries if they differ or are odd. Writers are serialized by a
+// `Mutex`.
+//
+// A reader that overlaps a write copies the value again, so `SeqLock` suits
+// values that are small and rarely written. For values that are large, or
+// that are not trivially copyable, consider `absl::ShardedReaderMutex`.
+
+#ifndef ABSL_SYNCHRONIZATION_SEQLOCK_H_
+#define ABSL_SYNCHRONIZATION_SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace absl {
+
+// SeqLock
+//
+// Holds a value of type `T`, which must be trivially copyable and default
+// constructible. All member functions are thread-safe.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock requires a trivially copyable type");
+
+ public:
+  // Creates a SeqLock holding a value-initialized `T`.
+  SeqLock() : SeqLock(T()) {}
+
+  // Creates a SeqLock holding `value`.
+  explicit SeqLock(const T& value);
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  // SeqLock::Load()
+  //
+  // Returns a copy of the value. Retries while a writer is changing the value;
+  // after a number of retries, it waits for the writer to finish instead.
+  T Load() const LOCKS_EXCLUDED(mu_);
+
+  // SeqLock::TryLoad()
+  //
+  // Copies the value to `*value` and returns true, unless a writer was
+  // changing the value at the time, in which case it returns false and
+  // `*value` is unspecified. Never blocks.
+  bool TryLoad(T* value) const;
+
+  // SeqLock::Store()
+  //
+  // Replaces the value with `value`.
+  void Store(const T& value) LOCKS_EXCLUDED(mu_);
+
+  // SeqLock::Update()
+  //
+  // Calls `f(&value)` on a copy of the current value, and stores the result.
+  // Concurrent `Store()` and `Update()` calls are serialized, so no update is
+  // lost. `f` must not call into this SeqLock.
+  template <typename F>
+  void Update(F f) LOCKS_EXCLUDED(mu_);
+
+ private:
+  // The value is kept in relaxed atomic words, so that readers racing with a
+  // writer see torn data, which the sequence number check rejects, rather
+  // than invoke undefined behavior.
+  static constexpr size_t kWords = (sizeof(T) + 7) / 8;
+
+  // The number of times Load() tries to read the value before it waits for
+  // the writer.
+  static constexpr int kMaxLoadAttempts = 100;
+
+  bool TryLoadWords(uint64_t* words) const;
+  void LoadWordsLocked(uint64_t* words) const SHARED_LOCKS_REQUIRED(mu_);
+  void StoreLocked(const T& value) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Odd while a writer is changing the value.
+  std::atomic<uint64_t> seq_;
+  std::atomic<uint64_t> words_[kWords];
+  mutable Mutex mu_;  // held exclusively by writers
+};
+
+// -----------------------------------------------------------------------------
+// Implementation details follow
+// -----------------------------------------------------------------------------
+
+template <typename T>
+SeqLock<T>::SeqLock(const T& value) : seq_(0) {
+  uint64_t words[kWords] = {};
+  std::memcpy(words, &value, sizeof(T));
+  for (size_t i = 0; i < kWords; i++) {
+    words_[i].store(words[i], std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+bool SeqLock<T>::TryLoadWords(uint64_t* words) const {
+  // Acquire pairs with the release store that ends a write: if this load
+  // sees it, the reads of the words below see that write's words.
+  const uint64_t seq0 = seq_.load(std::memory_order_acquire);
+  if ((seq0 & 1) != 0) return false;
+  for (size_t i = 0; i < kWords; i++) {
+    words[i] = words_[i].load(std::memory_order_relaxed);
+  }
+  // This fence pairs with the release fence in StoreLocked(): if the reads
+  // above saw any word written by a later write, the load below sees that
+  // write's increment of seq_.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return seq_.load(std::memory_order_relaxed) == seq0;
+}
+
+template <typename T>
+void SeqLock<T>::LoadWordsLocked(uint64_t* words) const {
+  for (size_t i = 0; i < kWords; i++) {
+    words[i] = words_[i].load(std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+T SeqLock<T>::Load() const {
+  uint64_t words[kWords];
+  bool loaded = false;
+  for (int i = 0; i != kMaxLoadAttempts && !loaded; i++) {
+    loaded = TryLoadWords(words);
+  }
+  if (!loaded) {
+    // The writer is slow, perhaps preempted; wait for it rather than spin.
+    ReaderMutexLock l(&mu_);
+    LoadWordsLocked(words);
+  }
+  T value;
+  std::memcpy(&value, words, sizeof(T));
+  return value;
+}
+
+template <typename T>
+bool SeqLock<T>::TryLoad(T* value) const {
+  uint64_t words[kWords];
+  if (!TryLoadWords(words)) return false;
+  std::memcpy(value, words, sizeof(T));
+  return true;
+}
+
+template <typename T>
+void SeqLock<T>::StoreLocked(const T& value) {
+  uint64_t words[kWords] = {};
+  std::memcpy(words, &value, sizeof(T));
+  const uint64_t seq = seq_.load(std::memory_order_relaxed);
+  seq_.store(seq + 1, std::memory_order_relaxed);
+  // Orders the store above before the stores of the words below, for readers
+  // that see any of them; see TryLoadWords().
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < kWords; i++) {
+    words_[i].store(words[i], std::memory_order_relaxed);
+  }
+  seq_.store(seq + 2, std::memory_order_release);
+}
+
+template <typename T>
+void SeqLock<T>::Store(const T& value) {
+  MutexLock l(&mu_);
+  StoreLocked(value);
+}
+
+template <typename T>
+template <typename F>
+void SeqLock<T>::Update(F f) {
+  MutexLock l(&mu_);
+  uint64_t words[kWords];
+  LoadWordsLocked(words);
+  T value;
+  std::memcpy(&value, words, sizeof(T));
+  f(&value);
+  StoreLocked(value);
+}
+
+template <typename T>
+constexpr size_t SeqLock<T>::kWords;
+
+template <typename T>
+constexpr int SeqLock<T>::kMaxLoadAttempts;
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_SEQLOCK_H_
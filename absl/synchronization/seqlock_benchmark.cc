@@ -0,0 +1,72 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/seqlock.h"
+
+namespace {
+
+struct Config {
+  int64_t fields[8];
+};
+
+// A Config guarded by a reader lock, for comparison.
+class MutexConfig {
+ public:
+  Config Load() {
+    absl::ReaderMutexLock l(&mu_);
+    return config_;
+  }
+  void Store(const Config& config) {
+    absl::MutexLock l(&mu_);
+    config_ = config;
+  }
+
+ private:
+  absl::Mutex mu_;
+  Config config_ GUARDED_BY(mu_) = {};
+};
+
+// Every thread loads the Config; thread 0 also stores it once every
+// state.range(0) iterations, or never if that is 0.
+template <typename Holder>
+void BM_Load(benchmark::State& state) {
+  static Holder* holder = new Holder;
+  const int64_t store_every = state.thread_index == 0 ? state.range(0) : 0;
+  Config config = {};
+  int64_t n = 0;
+  for (auto _ : state) {
+    if (store_every != 0 && ++n == store_every) {
+      n = 0;
+      config.fields[0]++;
+      holder->Store(config);
+    } else {
+      benchmark::DoNotOptimize(holder->Load());
+    }
+  }
+}
+
+void SetUpLoad(benchmark::internal::Benchmark* bm) {
+  bm->Arg(0)->Arg(1000)->Arg(10);
+  bm->ThreadRange(1, 64);
+  bm->UseRealTime();
+}
+
+BENCHMARK_TEMPLATE(BM_Load, MutexConfig)->Apply(SetUpLoad);
+BENCHMARK_TEMPLATE(BM_Load, absl::SeqLock<Config>)->Apply(SetUpLoad);
+
+}  // namespace
@@ -0,0 +1,118 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/seqlock.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+// An odd size, so that the last word is partly padding.
+struct Snapshot {
+  int64_t version;
+  int32_t values[9];
+};
+
+Snapshot MakeSnapshot(int64_t version) {
+  Snapshot s;
+  s.version = version;
+  for (int32_t& v : s.values) v = static_cast<int32_t>(version * 3);
+  return s;
+}
+
+bool IsConsistent(const Snapshot& s) {
+  for (int32_t v : s.values) {
+    if (v != static_cast<int32_t>(s.version * 3)) return false;
+  }
+  return true;
+}
+
+TEST(SeqLock, DefaultConstructedValueIsValueInitialized) {
+  absl::SeqLock<Snapshot> lock;
+  Snapshot s = lock.Load();
+  EXPECT_EQ(s.version, 0);
+  EXPECT_TRUE(IsConsistent(s));
+}
+
+TEST(SeqLock, LoadReturnsLastStore) {
+  absl::SeqLock<Snapshot> lock(MakeSnapshot(1));
+  EXPECT_EQ(lock.Load().version, 1);
+  lock.Store(MakeSnapshot(2));
+  Snapshot s = lock.Load();
+  EXPECT_EQ(s.version, 2);
+  EXPECT_TRUE(IsConsistent(s));
+  ASSERT_TRUE(lock.TryLoad(&s));
+  EXPECT_EQ(s.version, 2);
+}
+
+TEST(SeqLock, Update) {
+  absl::SeqLock<int> lock(5);
+  lock.Update([](int* value) { *value *= 2; });
+  EXPECT_EQ(lock.Load(), 10);
+}
+
+TEST(SeqLock, ReadersNeverSeeTornValues) {
+  constexpr int kReaders = 4;
+  constexpr int64_t kVersions = 20000;
+  absl::SeqLock<Snapshot> lock;
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < kReaders; ++i) {
+    readers.emplace_back([&lock, &done, i] {
+      int64_t last_version = 0;
+      while (!done.load(std::memory_order_relaxed)) {
+        Snapshot s;
+        if (i % 2 == 0) {
+          s = lock.Load();
+        } else if (!lock.TryLoad(&s)) {
+          continue;
+        }
+        ASSERT_TRUE(IsConsistent(s)) << s.version;
+        ASSERT_GE(s.version, last_version);
+        last_version = s.version;
+      }
+    });
+  }
+  for (int64_t version = 1; version <= kVersions; ++version) {
+    lock.Store(MakeSnapshot(version));
+  }
+  done.store(true);
+  for (std::thread& reader : readers) reader.join();
+  EXPECT_EQ(lock.Load().version, kVersions);
+}
+
+TEST(SeqLock, ConcurrentUpdatesAreNotLost) {
+  constexpr int kWriters = 4;
+  constexpr int kIncrements = 5000;
+  absl::SeqLock<Snapshot> lock;
+  std::vector<std::thread> writers;
+  for (int i = 0; i < kWriters; ++i) {
+    writers.emplace_back([&lock] {
+      for (int j = 0; j < kIncrements; ++j) {
+        lock.Update([](Snapshot* s) { *s = MakeSnapshot(s->version + 1); });
+      }
+    });
+  }
+  for (std::thread& writer : writers) writer.join();
+  Snapshot s = lock.Load();
+  EXPECT_EQ(s.version, kWriters * kIncrements);
+  EXPECT_TRUE(IsConsistent(s));
+}
+
+}  // namespace
@@ -0,0 +1,138 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A reader holds a share of the mutex while it is counted in its slot and
+// writer_ is false. A reader increments its slot and then checks writer_,
+// while a writer sets writer_ and then checks the slots; with sequentially
+// consistent accesses on both sides, at least one of them sees the other.
+// A reader that sees writer_ set backs out and waits for the writer by
+// acquiring writer_mu_ in shared mode, which the writer holds exclusively.
+//
+// A writer waits for the slots to drain on drain_mu_ with a Condition. A
+// reader that leaves while writer_ is set acquires and releases drain_mu_,
+// which makes the waiting writer re-evaluate that Condition.
+
+#include "absl/synchronization/sharded_reader_mutex.h"
+
+#include <algorithm>
+#include <new>
+
+#include "absl/base/internal/sysinfo.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
+
+namespace absl {
+
+struct ShardedReaderMutex::Slot {
+  std::atomic<int64_t> readers;
+  char padding[ABSL_CACHELINE_SIZE - sizeof(std::atomic<int64_t>)];
+};
+
+namespace {
+
+// Beyond this many slots, the cost of draining them in Lock() outweighs the
+// reduction in contention between readers.
+constexpr uint32_t kMaxSlots = 256;
+
+// Returns the number of slots per mutex: the number of CPUs rounded up to a
+// power of two, at most kMaxSlots.
+uint32_t NumSlots() {
+  static const uint32_t num_slots = [] {
+    const uint32_t cpus =
+        static_cast<uint32_t>(std::max(1, base_internal::NumCPUs()));
+    uint32_t n = 1;
+    while (n < cpus && n < kMaxSlots) n <<= 1;
+    return n;
+  }();
+  return num_slots;
+}
+
+}  // namespace
+
+ShardedReaderMutex::ShardedReaderMutex() : writer_(false) {
+  const uint32_t num_slots = NumSlots();
+  slot_mask_ = num_slots - 1;
+  slots_storage_ = new char[(num_slots + 1) * ABSL_CACHELINE_SIZE];
+  uintptr_t p = reinterpret_cast<uintptr_t>(slots_storage_);
+  p = (p + ABSL_CACHELINE_SIZE - 1) & ~uintptr_t{ABSL_CACHELINE_SIZE - 1};
+  slots_ = reinterpret_cast<Slot*>(p);
+  for (uint32_t i = 0; i != num_slots; i++) {
+    new (&slots_[i]) Slot;
+    slots_[i].readers.store(0, std::memory_order_relaxed);
+  }
+}
+
+ShardedReaderMutex::~ShardedReaderMutex() {
+  // Slot is trivially destructible.
+  delete[] slots_storage_;
+}
+
+ShardedReaderMutex::Slot* ShardedReaderMutex::SlotForCurrentThread() const {
+  const base_internal::ThreadIdentity* identity =
+      synchronization_internal::GetOrCreateCurrentThreadIdentity();
+  const uint64_t h = static_cast<uint64_t>(
+                         reinterpret_cast<uintptr_t>(identity)) *
+                     uint64_t{0x9E3779B97F4A7C15};
+  return &slots_[(h >> 32) & slot_mask_];
+}
+
+bool ShardedReaderMutex::NoReaders() const {
+  for (uint32_t i = 0; i <= slot_mask_; i++) {
+    if (slots_[i].readers.load(std::memory_order_seq_cst) != 0) return false;
+  }
+  return true;
+}
+
+void ShardedReaderMutex::Lock() NO_THREAD_SAFETY_ANALYSIS {
+  writer_mu_.Lock();
+  writer_.store(true, std::memory_order_seq_cst);
+  drain_mu_.LockWhen(Condition(this, &ShardedReaderMutex::NoReaders));
+  drain_mu_.Unlock();
+}
+
+void ShardedReaderMutex::Unlock() NO_THREAD_SAFETY_ANALYSIS {
+  writer_.store(false, std::memory_order_seq_cst);
+  writer_mu_.Unlock();
+}
+
+void ShardedReaderMutex::ReaderLock() NO_THREAD_SAFETY_ANALYSIS {
+  Slot* slot = SlotForCurrentThread();
+  slot->readers.fetch_add(1, std::memory_order_seq_cst);
+  if (ABSL_PREDICT_TRUE(!writer_.load(std::memory_order_seq_cst))) {
+    return;
+  }
+  // A writer holds the mutex or is draining readers. Back out, letting it
+  // know if it is waiting for this slot, then wait for it to finish.
+  slot->readers.fetch_sub(1, std::memory_order_seq_cst);
+  drain_mu_.Lock();
+  drain_mu_.Unlock();
+  // While writer_mu_ is held in shared mode no writer can set writer_, so
+  // the increment cannot race with a drain; the next writer to acquire
+  // writer_mu_ sees it.
+  writer_mu_.ReaderLock();
+  slot->readers.fetch_add(1, std::memory_order_relaxed);
+  writer_mu_.ReaderUnlock();
+}
+
+void ShardedReaderMutex::ReaderUnlock() NO_THREAD_SAFETY_ANALYSIS {
+  SlotForCurrentThread()->readers.fetch_sub(1, std::memory_order_seq_cst);
+  if (ABSL_PREDICT_FALSE(writer_.load(std::memory_order_seq_cst))) {
+    // Wake the writer if it is waiting for the slots to drain.
+    drain_mu_.Lock();
+    drain_mu_.Unlock();
+  }
+}
+
+}  // namespace absl
@@ -0,0 +1,123 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// sharded_reader_mutex.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `ShardedReaderMutex`, a reader-writer lock for data
+// that is read very often and written rarely.
+//
+// `absl::Mutex::ReaderLock()` updates the mutex's single state word, so on a
+// machine with many CPUs concurrent readers contend for that word's cache line
+// even when no writer is present. A `ShardedReaderMutex` instead counts its
+// readers in a number of cache-line-sized slots, one of which is chosen per
+// thread, so that readers on different CPUs usually touch different cache
+// lines. In exchange:
+//
+//   * `Lock()` (the writer lock) must wait for the readers of every slot to
+//     leave, and is therefore considerably slower than `Mutex::Lock()`.
+//   * Each `ShardedReaderMutex` occupies a cache line per slot, up to several
+//     kilobytes on large machines.
+//
+// Use it only for data whose readers measurably contend on a `Mutex`; for
+// everything else `absl::Mutex` is the better choice.
+//
+// Example:
+//
+//   class Config {
+//    public:
+//     std::string Get(absl::string_view key) const {
+//       mu_.ReaderLock();
+//       std::string value = LookUp(values_, key);
+//       mu_.ReaderUnlock();
+//       return value;
+//     }
+//
+//    private:
+//     mutable absl::ShardedReaderMutex mu_;
+//     std::map<std::string, std::string> values_ GUARDED_BY(mu_);
+//   };
+//
+// Writers are not starved: once a writer is waiting, new readers wait for it.
+// Neither reader nor writer locks are reentrant.
+
+#ifndef ABSL_SYNCHRONIZATION_SHARDED_READER_MUTEX_H_
+#define ABSL_SYNCHRONIZATION_SHARDED_READER_MUTEX_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace absl {
+
+class LOCKABLE ShardedReaderMutex {
+ public:
+  ShardedReaderMutex();
+  ~ShardedReaderMutex();
+
+  ShardedReaderMutex(const ShardedReaderMutex&) = delete;
+  ShardedReaderMutex& operator=(const ShardedReaderMutex&) = delete;
+
+  // ShardedReaderMutex::Lock()
+  //
+  // Blocks the calling thread, if necessary, until this mutex is free, and
+  // then acquires it exclusively.
+  void Lock() EXCLUSIVE_LOCK_FUNCTION();
+
+  // ShardedReaderMutex::Unlock()
+  //
+  // Releases this mutex, which must be held exclusively by the calling thread.
+  void Unlock() UNLOCK_FUNCTION();
+
+  // ShardedReaderMutex::ReaderLock()
+  //
+  // Blocks the calling thread, if necessary, until this mutex is either free
+  // or held in shared mode, and then acquires a share of it. In the absence
+  // of writers this touches only the calling thread's slot.
+  void ReaderLock() SHARED_LOCK_FUNCTION();
+
+  // ShardedReaderMutex::ReaderUnlock()
+  //
+  // Releases a read share of this mutex, which must have been acquired by the
+  // calling thread.
+  void ReaderUnlock() UNLOCK_FUNCTION();
+
+  // Aliases for `ShardedReaderMutex::Lock()` and `Unlock()`, for symmetry
+  // with `ReaderLock()` and `ReaderUnlock()`.
+  void WriterLock() EXCLUSIVE_LOCK_FUNCTION() { this->Lock(); }
+  void WriterUnlock() UNLOCK_FUNCTION() { this->Unlock(); }
+
+ private:
+  struct Slot;
+
+  // Returns the slot that counts the calling thread's read shares.
+  Slot* SlotForCurrentThread() const;
+
+  // Returns true if no slot counts a reader.
+  bool NoReaders() const;
+
+  Slot* slots_;               // num_slots_ cache-line-aligned slots
+  char* slots_storage_;       // owns the memory of slots_
+  uint32_t slot_mask_;        // num_slots_ - 1; num_slots_ is a power of two
+  std::atomic<bool> writer_;  // a writer holds or is acquiring writer_mu_
+  Mutex writer_mu_;           // serializes writers, and blocks new readers
+  Mutex drain_mu_;            // a writer waits here for readers to leave
+};
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_SHARDED_READER_MUTEX_H_
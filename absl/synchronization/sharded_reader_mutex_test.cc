@@ -0,0 +1,119 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/sharded_reader_mutex.h"
+
+#include <atomic>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+// Two values that writers keep equal; readers check that they never see them
+// differ.
+struct Guarded {
+  absl::ShardedReaderMutex mu;
+  int a GUARDED_BY(mu) = 0;
+  int b GUARDED_BY(mu) = 0;
+};
+
+TEST(ShardedReaderMutex, ReadersAndWriters) {
+  constexpr int kReaders = 8;
+  constexpr int kWriters = 2;
+  constexpr int kIterations = 2000;
+  Guarded g;
+  std::atomic<int> mismatches(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kReaders; ++i) {
+    threads.push_back(std::thread([&g, &mismatches] {
+      for (int j = 0; j < kIterations; ++j) {
+        g.mu.ReaderLock();
+        if (g.a != g.b) mismatches.fetch_add(1, std::memory_order_relaxed);
+        g.mu.ReaderUnlock();
+      }
+    }));
+  }
+  for (int i = 0; i < kWriters; ++i) {
+    threads.push_back(std::thread([&g] {
+      for (int j = 0; j < kIterations; ++j) {
+        g.mu.Lock();
+        ++g.a;
+        std::this_thread::yield();
+        ++g.b;
+        g.mu.Unlock();
+      }
+    }));
+  }
+  for (std::thread& t : threads) t.join();
+
+  EXPECT_EQ(mismatches.load(), 0);
+  g.mu.ReaderLock();
+  EXPECT_EQ(g.a, kWriters * kIterations);
+  EXPECT_EQ(g.b, kWriters * kIterations);
+  g.mu.ReaderUnlock();
+}
+
+TEST(ShardedReaderMutex, ReadersShare) {
+  absl::ShardedReaderMutex mu;
+  mu.ReaderLock();
+  absl::Notification locked;
+  std::thread reader([&mu, &locked] {
+    mu.ReaderLock();
+    locked.Notify();
+    mu.ReaderUnlock();
+  });
+  // Would deadlock if the second reader were excluded by the first.
+  locked.WaitForNotification();
+  reader.join();
+  mu.ReaderUnlock();
+}
+
+TEST(ShardedReaderMutex, WriterWaitsForReaders) {
+  absl::ShardedReaderMutex mu;
+  std::atomic<bool> writer_done(false);
+  mu.ReaderLock();
+  std::thread writer([&mu, &writer_done] {
+    mu.Lock();
+    writer_done.store(true);
+    mu.Unlock();
+  });
+  absl::SleepFor(absl::Milliseconds(100));
+  EXPECT_FALSE(writer_done.load());
+  mu.ReaderUnlock();
+  writer.join();
+  EXPECT_TRUE(writer_done.load());
+}
+
+TEST(ShardedReaderMutex, ReaderWaitsForWriter) {
+  absl::ShardedReaderMutex mu;
+  std::atomic<bool> reader_done(false);
+  mu.Lock();
+  std::thread reader([&mu, &reader_done] {
+    mu.ReaderLock();
+    reader_done.store(true);
+    mu.ReaderUnlock();
+  });
+  absl::SleepFor(absl::Milliseconds(100));
+  EXPECT_FALSE(reader_done.load());
+  mu.Unlock();
+  reader.join();
+  EXPECT_TRUE(reader_done.load());
+}
+
+}  // namespace
@@ -0,0 +1,394 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Each worker owns a work-stealing queue (Chase and Lev, "Dynamic Circular
+// Work-Stealing Deque", SPAA 2005) of fixed capacity. Only the owner pushes
+// and pops at the bottom; any thread may steal from the top.
+//
+// Idle workers sleep on their PerThreadSem. A worker about to sleep sets its
+// `parked` flag and increments num_parked_, then looks for work once more; a
+// thread that schedules a task publishes it, then looks at num_parked_ and
+// wakes a parked worker by clearing its flag and posting its semaphore. The
+// sequentially consistent fences on both sides ensure that either the worker
+// sees the task or the scheduler sees the worker. Whoever clears a worker's
+// flag decrements num_parked_, so that each sleep is matched by one post.
+
+#include "absl/synchronization/thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/internal/per_thread_tls.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/create_thread_identity.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/internal/per_thread_sem.h"
+#include "absl/synchronization/notification.h"
+
+namespace absl {
+
+constexpr size_t ThreadPool::Task::kMaxSize;
+
+namespace {
+
+using synchronization_internal::KernelTimeout;
+using synchronization_internal::PerThreadSem;
+
+enum class StealResult { kEmpty, kLost, kStolen };
+
+// A bounded work-stealing queue of tasks. Push() and Pop() may only be called
+// by the owning worker; Steal() and Empty() by any thread.
+//
+// Unlike in the original algorithm, a thief claims a slot before moving the
+// task out of it, as tasks cannot be copied atomically. Each slot's `full`
+// flag tells the owner when a thief has finished with a slot that it wants
+// to reuse, and tells a thief when the owner has finished filling it.
+class WorkStealingQueue {
+ public:
+  WorkStealingQueue() : top_(0), bottom_(0) {}
+
+  // Moves `*task` into the queue and returns true, or returns false and
+  // leaves `*task` alone if the queue is full.
+  bool Push(ThreadPool::Task* task) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= kCapacity) return false;
+    Slot& slot = slots_[b & (kCapacity - 1)];
+    // A thief that claimed the task at `b - kCapacity` may still be moving it
+    // out.
+    while (slot.full.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    slot.task = std::move(*task);
+    slot.full.store(true, std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the most recently pushed task into `*task` and returns true, or
+  // returns false if the queue is empty.
+  bool Pop(ThreadPool::Task* task) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    if (t == b) {
+      // The last task; race thieves for it.
+      const bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      if (!won) return false;
+    }
+    Slot& slot = slots_[b & (kCapacity - 1)];
+    *task = std::move(slot.task);
+    slot.full.store(false, std::memory_order_release);
+    return true;
+  }
+
+  // Moves the least recently pushed task into `*task`. Returns kLost if
+  // another thread took that task first, in which case the queue may still
+  // hold others.
+  StealResult Steal(ThreadPool::Task* task) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return StealResult::kEmpty;
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return StealResult::kLost;
+    }
+    Slot& slot = slots_[t & (kCapacity - 1)];
+    while (!slot.full.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    *task = std::move(slot.task);
+    slot.full.store(false, std::memory_order_release);
+    return StealResult::kStolen;
+  }
+
+  bool Empty() const {
+    const int64_t t = top_.load(std::memory_order_acquire);
+    return t >= bottom_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr int64_t kCapacity = 256;  // must be a power of two
+
+  struct Slot {
+    Slot() : full(false) {}
+    std::atomic<bool> full;
+    ThreadPool::Task task;
+  };
+
+  std::atomic<int64_t> top_;
+  // Keeps thieves' updates of top_ off the owner's cache line.
+  char padding_[ABSL_CACHELINE_SIZE];
+  std::atomic<int64_t> bottom_;
+  Slot slots_[kCapacity];
+};
+
+// ParallelFor() cuts its range into about this many chunks per thread, so
+// that threads that finish early can take over work from slower ones.
+constexpr int64_t kChunksPerThread = 4;
+
+#if ABSL_PER_THREAD_TLS
+// The ThreadPool::Worker that is running on this thread, if any.
+ABSL_PER_THREAD_TLS_KEYWORD void* current_worker = nullptr;
+#endif
+
+}  // namespace
+
+struct ThreadPool::Worker {
+  Worker() : parked(false), identity(nullptr), pool(nullptr), rng(0) {}
+
+  WorkStealingQueue queue;
+  std::atomic<bool> parked;
+  base_internal::ThreadIdentity* identity;
+  ThreadPool* pool;
+  uint32_t rng;  // picks the first worker to steal from
+  std::thread thread;
+};
+
+struct ThreadPool::SharedQueue {
+  std::deque<Task> tasks;
+};
+
+struct ThreadPool::ParallelForState {
+  ParallelForState(void (*fn)(const void*, int64_t, int64_t), const void* arg,
+                   int64_t begin, int64_t end, int64_t grain, int refs)
+      : fn(fn),
+        arg(arg),
+        end(end),
+        grain(grain),
+        next(begin),
+        remaining(end - begin),
+        refs(refs) {}
+
+  // Runs chunks until none are left to claim.
+  void RunChunks() {
+    for (;;) {
+      const int64_t lo = next.fetch_add(grain, std::memory_order_relaxed);
+      if (lo >= end) return;
+      const int64_t hi = std::min(lo + grain, end);
+      fn(arg, lo, hi);
+      if (remaining.fetch_sub(hi - lo, std::memory_order_acq_rel) ==
+          hi - lo) {
+        done.Notify();
+      }
+    }
+  }
+
+  void Unref() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  void (*const fn)(const void*, int64_t, int64_t);
+  const void* const arg;
+  const int64_t end;
+  const int64_t grain;
+  std::atomic<int64_t> next;       // first iteration of the next chunk
+  std::atomic<int64_t> remaining;  // iterations that have not returned
+  std::atomic<int> refs;           // the caller and unfinished helper tasks
+  Notification done;               // notified when `remaining` reaches 0
+};
+
+ThreadPool::ThreadPool(int num_threads)
+    : num_threads_(num_threads),
+      workers_(new Worker[num_threads]),
+      shared_(new SharedQueue),
+      shared_size_(0),
+      num_parked_(0),
+      stopping_(false) {
+  assert(num_threads > 0);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_[i].pool = this;
+    workers_[i].rng = static_cast<uint32_t>(i) + 1;
+    workers_[i].thread = std::thread(&ThreadPool::WorkerLoop, this,
+                                     &workers_[i]);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  stopping_.store(true, std::memory_order_seq_cst);
+  WakeAll();
+  for (int i = 0; i < num_threads_; ++i) {
+    workers_[i].thread.join();
+  }
+  assert(shared_->tasks.empty());
+}
+
+void ThreadPool::Schedule(Task task) {
+  assert(task && "ThreadPool::Schedule() of an empty task");
+  Worker* w = nullptr;
+#if ABSL_PER_THREAD_TLS
+  w = static_cast<Worker*>(current_worker);
+#endif
+  if (w == nullptr || w->pool != this || !w->queue.Push(&task)) {
+    base_internal::SpinLockHolder l(&shared_lock_);
+    shared_->tasks.push_back(std::move(task));
+    shared_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_parked_.load(std::memory_order_relaxed) > 0) {
+    WakeOne();
+  }
+}
+
+void ThreadPool::ParallelForImpl(int64_t begin, int64_t end,
+                                 void (*fn)(const void*, int64_t, int64_t),
+                                 const void* arg) {
+  if (begin >= end) return;
+  const int64_t n = end - begin;
+  const int64_t grain = std::max(
+      int64_t{1}, n / ((num_threads_ + int64_t{1}) * kChunksPerThread));
+  const int64_t num_chunks = (n + grain - 1) / grain;
+  // The calling thread runs chunks too.
+  const int num_helpers = static_cast<int>(
+      std::min<int64_t>(num_threads_, num_chunks - 1));
+  if (num_helpers == 0) {
+    fn(arg, begin, end);
+    return;
+  }
+  // Helpers that start after all chunks have been claimed still refer to the
+  // state, so it is reference counted rather than on this stack.
+  ParallelForState* state =
+      new ParallelForState(fn, arg, begin, end, grain, num_helpers + 1);
+  for (int i = 0; i < num_helpers; ++i) {
+    Schedule([state] {
+      state->RunChunks();
+      state->Unref();
+    });
+  }
+  state->RunChunks();
+  state->done.WaitForNotification();
+  state->Unref();
+}
+
+void ThreadPool::WorkerLoop(Worker* w) {
+#if ABSL_PER_THREAD_TLS
+  current_worker = w;
+#endif
+  // Must be set before the worker first parks, so that it can be woken.
+  w->identity = synchronization_internal::GetOrCreateCurrentThreadIdentity();
+  Task task;
+  for (;;) {
+    if (FindTask(w, &task)) {
+      task();
+      task = Task();
+      continue;
+    }
+    // Tasks still queued elsewhere are run by the workers that own them.
+    if (stopping_.load(std::memory_order_acquire)) break;
+    Park(w);
+  }
+#if ABSL_PER_THREAD_TLS
+  current_worker = nullptr;
+#endif
+}
+
+bool ThreadPool::FindTask(Worker* w, Task* task) {
+  if (w->queue.Pop(task)) return true;
+  if (shared_size_.load(std::memory_order_relaxed) > 0) {
+    base_internal::SpinLockHolder l(&shared_lock_);
+    if (!shared_->tasks.empty()) {
+      *task = std::move(shared_->tasks.front());
+      shared_->tasks.pop_front();
+      shared_size_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  if (num_threads_ == 1) return false;
+  bool lost;
+  do {
+    lost = false;
+    // xorshift32
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 17;
+    w->rng ^= w->rng << 5;
+    const int start = static_cast<int>(w->rng % num_threads_);
+    for (int i = 0; i < num_threads_; ++i) {
+      Worker* victim = &workers_[(start + i) % num_threads_];
+      if (victim == w) continue;
+      switch (victim->queue.Steal(task)) {
+        case StealResult::kStolen:
+          return true;
+        case StealResult::kLost:
+          lost = true;
+          break;
+        case StealResult::kEmpty:
+          break;
+      }
+    }
+  } while (lost);
+  return false;
+}
+
+bool ThreadPool::HasWork() const {
+  if (shared_size_.load(std::memory_order_relaxed) > 0) return true;
+  for (int i = 0; i < num_threads_; ++i) {
+    if (!workers_[i].queue.Empty()) return true;
+  }
+  return false;
+}
+
+void ThreadPool::Park(Worker* w) {
+  w->parked.store(true, std::memory_order_seq_cst);
+  num_parked_.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const bool sleep = !HasWork() && !stopping_.load(std::memory_order_seq_cst);
+  if (sleep) {
+    PerThreadSem::Wait(KernelTimeout::Never());
+  }
+  if (w->parked.exchange(false, std::memory_order_acq_rel)) {
+    // No one woke this worker: it found work, or was woken spuriously.
+    num_parked_.fetch_sub(1, std::memory_order_relaxed);
+  } else if (!sleep) {
+    // A waker cleared the flag and posted the semaphore after this worker
+    // decided not to sleep; consume the post.
+    PerThreadSem::Wait(KernelTimeout::Never());
+  }
+}
+
+void ThreadPool::WakeOne() {
+  for (int i = 0; i < num_threads_; ++i) {
+    Worker& w = workers_[i];
+    bool expected = true;
+    if (w.parked.load(std::memory_order_relaxed) &&
+        w.parked.compare_exchange_strong(expected, false,
+                                         std::memory_order_acq_rel)) {
+      num_parked_.fetch_sub(1, std::memory_order_relaxed);
+      PerThreadSem::Post(w.identity);
+      return;
+    }
+  }
+}
+
+void ThreadPool::WakeAll() {
+  for (int i = 0; i < num_threads_; ++i) {
+    Worker& w = workers_[i];
+    if (w.parked.exchange(false, std::memory_order_acq_rel)) {
+      num_parked_.fetch_sub(1, std::memory_order_relaxed);
+      PerThreadSem::Post(w.identity);
+    }
+  }
+}
+
+}  // namespace absl
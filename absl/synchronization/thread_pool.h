@@ -0,0 +1,241 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// thread_pool.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::ThreadPool`, a fixed-size pool of worker
+// threads that run scheduled tasks, and `absl::ThreadPool::Task`, the
+// fixed-size callable type that it schedules.
+//
+// Each worker keeps its own queue of tasks. Tasks scheduled from a worker
+// thread go to that worker's queue, from which the worker takes the most
+// recently scheduled task first; idle workers steal the oldest tasks from
+// other workers' queues. Tasks scheduled from other threads go to a queue
+// shared by all workers. Workers with nothing to do sleep until a task is
+// scheduled.
+//
+// Example:
+//
+//   absl::ThreadPool pool(4);
+//   pool.Schedule([&counter] { counter.fetch_add(1); });
+//
+//   std::vector<double> v(1000000);
+//   pool.ParallelFor(0, v.size(), [&v](int64_t i) { v[i] = std::sqrt(i); });
+//
+// Tasks are run in no particular order. A task must not block waiting for
+// another task that has not yet started, as all workers may be blocked the
+// same way.
+
+#ifndef ABSL_SYNCHRONIZATION_THREAD_POOL_H_
+#define ABSL_SYNCHRONIZATION_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "absl/base/internal/spinlock.h"
+
+namespace absl {
+
+class ThreadPool {
+ public:
+  class Task;
+
+  // Starts `num_threads` worker threads, which must be positive.
+  explicit ThreadPool(int num_threads);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Waits for all scheduled tasks, including tasks that they schedule, to
+  // finish, and then stops the worker threads. No task may be scheduled
+  // from outside the pool once destruction has begun.
+  ~ThreadPool();
+
+  // ThreadPool::Schedule()
+  //
+  // Schedules `task`, which must not be empty, to be run on a worker thread.
+  // Any callable that fits into a `Task` converts to one implicitly:
+  //
+  //   pool.Schedule([this, i] { Process(i); });
+  void Schedule(Task task);
+
+  // ThreadPool::ParallelFor()
+  //
+  // Calls `f(i)` for each `i` in [begin, end), spreading the calls across the
+  // worker threads and the calling thread, and returns once all of them have
+  // returned. The calls for nearby values of `i` are usually made by the same
+  // thread, in increasing order. May be called from a worker thread.
+  template <typename F>
+  void ParallelFor(int64_t begin, int64_t end, const F& f);
+
+  // Returns the number of worker threads.
+  int NumThreads() const { return num_threads_; }
+
+ private:
+  struct Worker;
+  struct ParallelForState;
+
+  // Calls `fn(arg, lo, hi)` for subranges [lo, hi) covering [begin, end).
+  void ParallelForImpl(int64_t begin, int64_t end,
+                       void (*fn)(const void* arg, int64_t lo, int64_t hi),
+                       const void* arg);
+
+  void WorkerLoop(Worker* w);
+
+  // Takes a task from `w`'s own queue, the shared queue, or another worker's
+  // queue, in that order. Returns false if it found none.
+  bool FindTask(Worker* w, Task* task);
+
+  // Returns true if any queue appears to hold a task.
+  bool HasWork() const;
+
+  // Puts `w` to sleep until it is woken by WakeOne() or WakeAll(), unless
+  // there is work to do or the pool is stopping.
+  void Park(Worker* w);
+
+  // Wakes a sleeping worker, if there is one.
+  void WakeOne();
+  void WakeAll();
+
+  const int num_threads_;
+  std::unique_ptr<Worker[]> workers_;
+
+  // Tasks scheduled from outside the pool, and tasks that did not fit into a
+  // worker's queue. A SpinLock rather than a Mutex, because sleeping on a
+  // Mutex would consume the wakeups that this pool posts to its workers.
+  base_internal::SpinLock shared_lock_;
+  struct SharedQueue;
+  std::unique_ptr<SharedQueue> shared_;
+  std::atomic<int64_t> shared_size_;
+
+  std::atomic<int> num_parked_;
+  std::atomic<bool> stopping_;
+};
+
+// ThreadPool::Task
+//
+// A type-erased `void()` callable, like `std::function<void()>`, that stores
+// the callable inline instead of allocating it on the heap. Callables larger
+// than `Task::kMaxSize` bytes, or not nothrow move constructible, are rejected
+// at compile time; capture a pointer to larger state instead.
+//
+// Unlike `std::function`, a `Task` is move-only, and may therefore hold
+// move-only callables.
+class ThreadPool::Task {
+ public:
+  static constexpr size_t kMaxSize = 6 * sizeof(void*);
+
+  // Constructs an empty `Task`.
+  Task() noexcept : ops_(nullptr) {}
+
+  // Constructs a `Task` that calls a copy of `f`.
+  template <typename F, typename D = typename std::decay<F>::type,
+            typename = typename std::enable_if<
+                !std::is_same<D, Task>::value>::type>
+  Task(F&& f) : ops_(&OpsFor<D>::kOps) {  // NOLINT(runtime/explicit)
+    static_assert(sizeof(D) <= kMaxSize,
+                  "callable is too large for ThreadPool::Task");
+    static_assert(alignof(D) <= alignof(std::max_align_t),
+                  "callable is over-aligned for ThreadPool::Task");
+    static_assert(std::is_nothrow_move_constructible<D>::value,
+                  "callable must be nothrow move constructible");
+    new (&storage_) D(std::forward<F>(f));
+  }
+
+  Task(Task&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->relocate(&other.storage_, &storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      if (ops_ != nullptr) {
+        ops_->relocate(&other.storage_, &storage_);
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  ~Task() { Reset(); }
+
+  // Returns true if this `Task` holds a callable.
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  // Calls the held callable, which must exist.
+  void operator()() { ops_->invoke(&storage_); }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* f);
+    // Move-constructs the callable at `to` from the one at `from`, and
+    // destroys the latter.
+    void (*relocate)(void* from, void* to);
+    void (*destroy)(void* f);
+  };
+
+  template <typename D>
+  struct OpsFor {
+    static void Invoke(void* f) { (*static_cast<D*>(f))(); }
+    static void Relocate(void* from, void* to) {
+      D* src = static_cast<D*>(from);
+      new (to) D(std::move(*src));
+      src->~D();
+    }
+    static void Destroy(void* f) { static_cast<D*>(f)->~D(); }
+    static const Ops kOps;
+  };
+
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  const Ops* ops_;
+  typename std::aligned_storage<kMaxSize, alignof(std::max_align_t)>::type
+      storage_;
+};
+
+template <typename D>
+const ThreadPool::Task::Ops ThreadPool::Task::OpsFor<D>::kOps = {
+    &ThreadPool::Task::OpsFor<D>::Invoke,
+    &ThreadPool::Task::OpsFor<D>::Relocate,
+    &ThreadPool::Task::OpsFor<D>::Destroy};
+
+template <typename F>
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, const F& f) {
+  ParallelForImpl(begin, end,
+                  [](const void* arg, int64_t lo, int64_t hi) {
+                    const F& fn = *static_cast<const F*>(arg);
+                    for (int64_t i = lo; i < hi; ++i) fn(i);
+                  },
+                  &f);
+}
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_THREAD_POOL_H_
@@ -0,0 +1,89 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/base/internal/sysinfo.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/internal/thread_pool.h"
+#include "absl/synchronization/thread_pool.h"
+
+namespace {
+
+int NumWorkers() { return absl::base_internal::NumCPUs(); }
+
+// Schedules `state.range(0)` empty tasks from outside the pool and waits for
+// them to run.
+template <typename Pool>
+void BM_ScheduleBatch(benchmark::State& state) {
+  Pool pool(NumWorkers());
+  const int batch = state.range(0);
+  for (auto _ : state) {
+    absl::BlockingCounter done(batch);
+    for (int i = 0; i < batch; ++i) {
+      pool.Schedule([&done] { done.DecrementCount(); });
+    }
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK_TEMPLATE(BM_ScheduleBatch, absl::synchronization_internal::ThreadPool)
+    ->Arg(1)
+    ->Arg(1000)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleBatch, absl::ThreadPool)
+    ->Arg(1)
+    ->Arg(1000)
+    ->UseRealTime();
+
+// Each task schedules two more until `depth` reaches 0, so that almost all
+// tasks are scheduled from worker threads.
+void Fork(absl::ThreadPool* pool, int depth, absl::BlockingCounter* done) {
+  if (depth == 0) {
+    done->DecrementCount();
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    pool->Schedule([pool, depth, done] { Fork(pool, depth - 1, done); });
+  }
+}
+
+void BM_ForkTree(benchmark::State& state) {
+  absl::ThreadPool pool(NumWorkers());
+  const int depth = state.range(0);
+  for (auto _ : state) {
+    absl::BlockingCounter done(1 << depth);
+    Fork(&pool, depth, &done);
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * ((2 << depth) - 1));
+}
+BENCHMARK(BM_ForkTree)->Arg(10)->Arg(16)->UseRealTime();
+
+void BM_ParallelFor(benchmark::State& state) {
+  absl::ThreadPool pool(NumWorkers());
+  const int64_t n = state.range(0);
+  std::atomic<int64_t> sink(0);
+  for (auto _ : state) {
+    pool.ParallelFor(0, n, [&sink](int64_t i) {
+      if (i % 4096 == 0) sink.fetch_add(1, std::memory_order_relaxed);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ParallelFor)->Range(1 << 10, 1 << 20)->UseRealTime();
+
+}  // namespace
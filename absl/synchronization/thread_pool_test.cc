@@ -0,0 +1,178 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/thread_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+TEST(ThreadPoolTask, EmptyAndMove) {
+  int calls = 0;
+  absl::ThreadPool::Task empty;
+  EXPECT_FALSE(empty);
+
+  absl::ThreadPool::Task a([&calls] { ++calls; });
+  ASSERT_TRUE(a);
+  a();
+  EXPECT_EQ(calls, 1);
+
+  absl::ThreadPool::Task b(std::move(a));
+  EXPECT_FALSE(a);  // NOLINT(bugprone-use-after-move)
+  ASSERT_TRUE(b);
+  b();
+  EXPECT_EQ(calls, 2);
+
+  a = std::move(b);
+  a();
+  EXPECT_EQ(calls, 3);
+}
+
+TEST(ThreadPoolTask, DestroysCallable) {
+  auto counter = std::make_shared<int>(0);
+  {
+    absl::ThreadPool::Task task([counter] { ++*counter; });
+    EXPECT_EQ(counter.use_count(), 2);
+    absl::ThreadPool::Task moved(std::move(task));
+    EXPECT_EQ(counter.use_count(), 2);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+// A callable that can be moved but not copied.
+struct SetFromPointer {
+  void operator()() { *out = *in; }
+  std::unique_ptr<int> in;
+  int* out;
+};
+
+TEST(ThreadPoolTask, MoveOnlyCallable) {
+  int result = 0;
+  absl::ThreadPool::Task task(
+      SetFromPointer{std::unique_ptr<int>(new int(7)), &result});
+  absl::ThreadPool::Task moved(std::move(task));
+  moved();
+  EXPECT_EQ(result, 7);
+}
+
+TEST(ThreadPool, RunsScheduledTasks) {
+  constexpr int kTasks = 10000;
+  std::atomic<int> count(0);
+  absl::BlockingCounter done(kTasks);
+  absl::ThreadPool pool(4);
+  EXPECT_EQ(pool.NumThreads(), 4);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.Schedule([&count, &done] {
+      count.fetch_add(1, std::memory_order_relaxed);
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_EQ(count.load(), kTasks);
+}
+
+// Each task schedules two more until `depth` reaches 0, so that most tasks are
+// scheduled from worker threads, and many more of them than fit into a
+// worker's own queue.
+void Fork(absl::ThreadPool* pool, int depth, std::atomic<int>* leaves,
+          absl::BlockingCounter* done) {
+  if (depth == 0) {
+    leaves->fetch_add(1, std::memory_order_relaxed);
+    done->DecrementCount();
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    pool->Schedule([pool, depth, leaves, done] {
+      Fork(pool, depth - 1, leaves, done);
+    });
+  }
+}
+
+TEST(ThreadPool, TasksScheduleTasks) {
+  constexpr int kDepth = 14;
+  std::atomic<int> leaves(0);
+  absl::BlockingCounter done(1 << kDepth);
+  absl::ThreadPool pool(3);
+  Fork(&pool, kDepth, &leaves, &done);
+  done.Wait();
+  EXPECT_EQ(leaves.load(), 1 << kDepth);
+}
+
+TEST(ThreadPool, DestructorWaitsForTasks) {
+  constexpr int kDepth = 10;
+  std::atomic<int> leaves(0);
+  absl::BlockingCounter unused(1 << kDepth);
+  {
+    absl::ThreadPool pool(2);
+    Fork(&pool, kDepth, &leaves, &unused);
+  }
+  EXPECT_EQ(leaves.load(), 1 << kDepth);
+}
+
+TEST(ThreadPool, WakesSleepingWorkers) {
+  absl::ThreadPool pool(4);
+  for (int round = 0; round < 100; ++round) {
+    // Give the workers time to go to sleep every few rounds.
+    if (round % 10 == 0) absl::SleepFor(absl::Milliseconds(10));
+    absl::Notification ran;
+    pool.Schedule([&ran] { ran.Notify(); });
+    ran.WaitForNotification();
+  }
+}
+
+TEST(ThreadPool, ParallelFor) {
+  absl::ThreadPool pool(4);
+  for (int64_t n : {0, 1, 2, 7, 1000, 100000}) {
+    std::vector<std::atomic<int>> visits(n);
+    for (auto& v : visits) v.store(0);
+    pool.ParallelFor(0, n, [&visits](int64_t i) {
+      visits[i].fetch_add(1, std::memory_order_relaxed);
+    });
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(visits[i].load(), 1) << "n=" << n << " i=" << i;
+    }
+  }
+}
+
+TEST(ThreadPool, ParallelForOffsetRange) {
+  absl::ThreadPool pool(2);
+  std::atomic<int64_t> sum(0);
+  pool.ParallelFor(-500, 1500, [&sum](int64_t i) {
+    sum.fetch_add(i, std::memory_order_relaxed);
+  });
+  EXPECT_EQ(sum.load(), (1500 * 1499) / 2 - (500 * 501) / 2);
+}
+
+TEST(ThreadPool, NestedParallelFor) {
+  constexpr int kOuter = 16;
+  constexpr int kInner = 1000;
+  absl::ThreadPool pool(4);
+  std::atomic<int> count(0);
+  pool.ParallelFor(0, kOuter, [&pool, &count](int64_t) {
+    pool.ParallelFor(0, kInner, [&count](int64_t) {
+      count.fetch_add(1, std::memory_order_relaxed);
+    });
+  });
+  EXPECT_EQ(count.load(), kOuter * kInner);
+}
+
+}  // namespace
@@ -0,0 +1,269 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/wait_on_address.h"
+
+#include <errno.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "absl/base/internal/raw_logging.h"
+#include "absl/base/internal/spinlock.h"
+#include "absl/base/internal/thread_identity.h"
+#include "absl/base/optimization.h"
+#include "absl/synchronization/internal/futex.h"
+#include "absl/synchronization/internal/kernel_timeout.h"
+#include "absl/synchronization/internal/per_thread_sem.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace absl {
+namespace synchronization_internal {
+
+// ParkingLot holds the threads blocked on addresses that cannot be waited on
+// with a futex, in a fixed table of wait queues hashed by address. Each queue's
+// lock is held only to check the waited-on value and to link or unlink a
+// thread; the thread itself blocks on its PerThreadSem.
+class ParkingLot {
+ public:
+  // Blocks while `*address` is `expected`, until woken by Wake() or until `t`
+  // has passed. Returns false if `t` passed first.
+  template <typename T>
+  static bool Wait(const std::atomic<T>* address, T expected, KernelTimeout t);
+
+  // Wakes at most `count` threads blocked in Wait() on `address`.
+  static void Wake(const void* address, int count);
+
+ private:
+  // A thread blocked in Wait(), which lives on that thread's stack.
+  struct ParkedThread {
+    const void* address;
+    base_internal::ThreadIdentity* identity;
+    ParkedThread* prev;  // Guarded by the bucket's lock.
+    ParkedThread* next;  // Guarded by the bucket's lock.
+    bool queued;         // Guarded by the bucket's lock.
+    // Links the threads that Wake() has unlinked and will post.
+    ParkedThread* wake_next;
+    // Set by Wake() just before it posts this thread's semaphore, after which
+    // Wake() no longer touches this ParkedThread.
+    std::atomic<bool> woken;
+  };
+
+  struct ABSL_CACHELINE_ALIGNED Bucket {
+    // The buckets are zero-initialized statics that may be used before
+    // dynamic initialization, so this constructor must not write to them.
+    Bucket() : mu(base_internal::kLinkerInitialized) {}
+
+    base_internal::SpinLock mu;
+    // The number of threads in, or about to enter, this bucket's queue. It lets
+    // Wake() skip the lock when no thread can be waiting.
+    std::atomic<int> parked;
+    ParkedThread* head;
+    ParkedThread* tail;
+  };
+
+  static constexpr size_t kNumBuckets = 256;
+
+  static Bucket* BucketFor(const void* address) {
+    const uintptr_t a = reinterpret_cast<uintptr_t>(address);
+    return &buckets_[((a >> 3) ^ (a >> 11)) % kNumBuckets];
+  }
+
+  static void Unlink(Bucket* b, ParkedThread* p) {
+    (p->prev != nullptr ? p->prev->next : b->head) = p->next;
+    (p->next != nullptr ? p->next->prev : b->tail) = p->prev;
+    p->queued = false;
+    b->parked.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  static Bucket buckets_[kNumBuckets];
+};
+
+ParkingLot::Bucket ParkingLot::buckets_[ParkingLot::kNumBuckets];
+
+template <typename T>
+bool ParkingLot::Wait(const std::atomic<T>* address, T expected,
+                      KernelTimeout t) {
+  Bucket* b = BucketFor(address);
+  // Either Wake() sees this increment and takes the bucket's lock, or this
+  // thread sees the value stored before Wake() was called.
+  b->parked.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  ParkedThread self;
+  self.address = address;
+  self.identity = GetOrCreateCurrentThreadIdentity();
+  self.woken.store(false, std::memory_order_relaxed);
+  b->mu.Lock();
+  if (address->load(std::memory_order_relaxed) != expected) {
+    b->mu.Unlock();
+    b->parked.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  self.prev = b->tail;
+  self.next = nullptr;
+  self.queued = true;
+  (b->tail != nullptr ? b->tail->next : b->head) = &self;
+  b->tail = &self;
+  b->mu.Unlock();
+
+  do {
+    if (!PerThreadSem::Wait(t)) {
+      b->mu.Lock();
+      const bool queued = self.queued;
+      if (queued) Unlink(b, &self);
+      b->mu.Unlock();
+      if (queued) return false;
+      // A concurrent Wake() has unlinked this thread, and will post its
+      // semaphore, which must be consumed before returning.
+      t = KernelTimeout::Never();
+    }
+  } while (!self.woken.load(std::memory_order_acquire));
+  return true;
+}
+
+void ParkingLot::Wake(const void* address, int count) {
+  Bucket* b = BucketFor(address);
+  // Pairs with the fence in Wait().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (b->parked.load(std::memory_order_relaxed) == 0) return;
+
+  ParkedThread* to_wake = nullptr;
+  ParkedThread** last = &to_wake;
+  b->mu.Lock();
+  for (ParkedThread* p = b->head; p != nullptr && count > 0;) {
+    ParkedThread* next = p->next;
+    if (p->address == address) {
+      Unlink(b, p);
+      p->wake_next = nullptr;
+      *last = p;
+      last = &p->wake_next;
+      count--;
+    }
+    p = next;
+  }
+  b->mu.Unlock();
+
+  while (to_wake != nullptr) {
+    ParkedThread* next = to_wake->wake_next;
+    base_internal::ThreadIdentity* identity = to_wake->identity;
+    to_wake->woken.store(true, std::memory_order_release);
+    PerThreadSem::Post(identity);
+    to_wake = next;
+  }
+}
+
+namespace {
+
+#ifdef ABSL_INTERNAL_HAVE_FUTEX
+
+bool WaitUntil(const std::atomic<int32_t>* address, int32_t expected,
+               KernelTimeout t) {
+  // The futex only reads the word, despite taking a non-const pointer.
+  const int err = Futex::WaitUntil(
+      const_cast<std::atomic<int32_t>*>(address), expected, t);
+  if (err == -ETIMEDOUT) {
+    return false;
+  }
+  if (err != 0 && err != -EINTR && err != -EWOULDBLOCK) {
+    ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+  }
+  return true;
+}
+
+void Wake(const std::atomic<int32_t>* address, int count) {
+  const int err =
+      Futex::Wake(const_cast<std::atomic<int32_t>*>(address), count);
+  if (ABSL_PREDICT_FALSE(err < 0)) {
+    ABSL_RAW_LOG(FATAL, "Futex operation failed with error %d\n", err);
+  }
+}
+
+#else  // ABSL_INTERNAL_HAVE_FUTEX
+
+bool WaitUntil(const std::atomic<int32_t>* address, int32_t expected,
+               KernelTimeout t) {
+  return ParkingLot::Wait(address, expected, t);
+}
+
+void Wake(const std::atomic<int32_t>* address, int count) {
+  ParkingLot::Wake(address, count);
+}
+
+#endif  // ABSL_INTERNAL_HAVE_FUTEX
+
+bool WaitUntil(const std::atomic<int64_t>* address, int64_t expected,
+               KernelTimeout t) {
+  return ParkingLot::Wait(address, expected, t);
+}
+
+void Wake(const std::atomic<int64_t>* address, int count) {
+  ParkingLot::Wake(address, count);
+}
+
+}  // namespace
+}  // namespace synchronization_internal
+
+void WaitOnAddress(const std::atomic<int32_t>* address, int32_t expected) {
+  synchronization_internal::WaitUntil(
+      address, expected, synchronization_internal::KernelTimeout::Never());
+}
+
+void WaitOnAddress(const std::atomic<int64_t>* address, int64_t expected) {
+  synchronization_internal::WaitUntil(
+      address, expected, synchronization_internal::KernelTimeout::Never());
+}
+
+bool WaitOnAddressWithDeadline(const std::atomic<int32_t>* address,
+                               int32_t expected, absl::Time deadline) {
+  return synchronization_internal::WaitUntil(
+      address, expected, synchronization_internal::KernelTimeout(deadline));
+}
+
+bool WaitOnAddressWithDeadline(const std::atomic<int64_t>* address,
+                               int64_t expected, absl::Time deadline) {
+  return synchronization_internal::WaitUntil(
+      address, expected, synchronization_internal::KernelTimeout(deadline));
+}
+
+bool WaitOnAddressWithTimeout(const std::atomic<int32_t>* address,
+                              int32_t expected, absl::Duration timeout) {
+  return WaitOnAddressWithDeadline(address, expected, absl::Now() + timeout);
+}
+
+bool WaitOnAddressWithTimeout(const std::atomic<int64_t>* address,
+                              int64_t expected, absl::Duration timeout) {
+  return WaitOnAddressWithDeadline(address, expected, absl::Now() + timeout);
+}
+
+void WakeByAddress(const std::atomic<int32_t>* address, int count) {
+  synchronization_internal::Wake(address, count);
+}
+
+void WakeByAddress(const std::atomic<int64_t>* address, int count) {
+  synchronization_internal::Wake(address, count);
+}
+
+void WakeAllByAddress(const std::atomic<int32_t>* address) {
+  synchronization_internal::Wake(address, std::numeric_limits<int>::max());
+}
+
+void WakeAllByAddress(const std::atomic<int64_t>* address) {
+  synchronization_internal::Wake(address, std::numeric_limits<int>::max());
+}
+
+}  // namespace absl
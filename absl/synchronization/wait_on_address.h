@@ -0,0 +1,101 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// -----------------------------------------------------------------------------
+// wait_on_address.h
+// -----------------------------------------------------------------------------
+//
+// This header file defines `absl::WaitOnAddress()` and `absl::WakeByAddress()`,
+// which let a thread block until an atomic word changes, so that a lock or flag
+// that fits in one word can block efficiently without embedding a `Mutex`:
+//
+//   std::atomic<int32_t> done(0);
+//
+//   // Waiting thread:
+//   while (done.load(std::memory_order_acquire) == 0) {
+//     absl::WaitOnAddress(&done, 0);
+//   }
+//
+//   // Signalling thread:
+//   done.store(1, std::memory_order_release);
+//   absl::WakeAllByAddress(&done);
+//
+// Waits on a `std::atomic<int32_t>` use a futex where the platform has one.
+// Other waits block in a global table of wait queues hashed by address, whose
+// locks are held only to check the waited-on value and to link or unlink the
+// waiting thread.
+//
+// A wait may return spuriously, so callers re-check their condition in a loop.
+// Waking threads on an address that none waits on is cheap in the hashed table
+// but is a system call on a futex, so primitives built on these functions
+// usually keep a bit in their word saying whether any thread may be waiting,
+// as `absl::Latch` does.
+//
+// Memory ordering: these functions order nothing themselves. A thread that
+// returns from a wait must load the atomic word to learn what changed, with
+// whatever ordering the caller needs.
+
+#ifndef ABSL_SYNCHRONIZATION_WAIT_ON_ADDRESS_H_
+#define ABSL_SYNCHRONIZATION_WAIT_ON_ADDRESS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace absl {
+
+// WaitOnAddress()
+//
+// Blocks while `*address` is `expected`, until woken by `WakeByAddress()` or
+// `WakeAllByAddress()` on `address`. Returns at once if `*address` is not
+// `expected`, and may also return spuriously.
+void WaitOnAddress(const std::atomic<int32_t>* address, int32_t expected);
+void WaitOnAddress(const std::atomic<int64_t>* address, int64_t expected);
+
+// WaitOnAddressWithDeadline()
+//
+// Like `WaitOnAddress()`, but gives up once `deadline` has passed. Returns
+// false if it gave up, and true otherwise.
+bool WaitOnAddressWithDeadline(const std::atomic<int32_t>* address,
+                               int32_t expected, absl::Time deadline);
+bool WaitOnAddressWithDeadline(const std::atomic<int64_t>* address,
+                               int64_t expected, absl::Time deadline);
+
+// WaitOnAddressWithTimeout()
+//
+// Like `WaitOnAddress()`, but gives up once `timeout` has elapsed. Returns
+// false if it gave up, and true otherwise.
+bool WaitOnAddressWithTimeout(const std::atomic<int32_t>* address,
+                              int32_t expected, absl::Duration timeout);
+bool WaitOnAddressWithTimeout(const std::atomic<int64_t>* address,
+                              int64_t expected, absl::Duration timeout);
+
+// WakeByAddress()
+//
+// Wakes at most `count` of the threads waiting on `address`. A thread that
+// changes `*address` and then calls this wakes every thread that was waiting
+// for the old value, up to `count`.
+void WakeByAddress(const std::atomic<int32_t>* address, int count = 1);
+void WakeByAddress(const std::atomic<int64_t>* address, int count = 1);
+
+// WakeAllByAddress()
+//
+// Wakes all the threads waiting on `address`.
+void WakeAllByAddress(const std::atomic<int32_t>* address);
+void WakeAllByAddress(const std::atomic<int64_t>* address);
+
+}  // namespace absl
+
+#endif  // ABSL_SYNCHRONIZATION_WAIT_ON_ADDRESS_H_
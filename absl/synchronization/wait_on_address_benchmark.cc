@@ -0,0 +1,67 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <atomic>
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/wait_on_address.h"
+
+namespace {
+
+// A lock in one word: 0 if free, 1 if held, and 2 if held with waiters.
+template <typename T>
+class WordLock {
+ public:
+  void Lock() {
+    T s = 0;
+    if (word_.compare_exchange_strong(s, 1, std::memory_order_acquire)) return;
+    while (word_.exchange(2, std::memory_order_acquire) != 0) {
+      absl::WaitOnAddress(&word_, 2);
+    }
+  }
+
+  void Unlock() {
+    if (word_.exchange(0, std::memory_order_release) == 2) {
+      absl::WakeByAddress(&word_);
+    }
+  }
+
+ private:
+  std::atomic<T> word_{0};
+};
+
+// Every thread repeatedly takes the lock and does a little work under it.
+template <typename Lock>
+void BM_Contended(benchmark::State& state) {
+  static Lock* lock;
+  static int counter;
+  if (state.thread_index == 0) lock = new Lock;
+  for (auto _ : state) {
+    lock->Lock();
+    benchmark::DoNotOptimize(++counter);
+    lock->Unlock();
+  }
+  if (state.thread_index == 0) delete lock;
+}
+
+BENCHMARK_TEMPLATE(BM_Contended, absl::Mutex)->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contended, WordLock<int32_t>)->ThreadRange(1, 64)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contended, WordLock<int64_t>)->ThreadRange(1, 64)
+    ->UseRealTime();
+
+}  // namespace
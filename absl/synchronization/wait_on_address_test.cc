@@ -0,0 +1,161 @@
+// Copyright 2018 The Abseil Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "absl/synchronization/wait_on_address.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace {
+
+template <typename T>
+class WaitOnAddressTest : public ::testing::Test {};
+
+typedef ::testing::Types<int32_t, int64_t> WordTypes;
+TYPED_TEST_CASE(WaitOnAddressTest, WordTypes);
+
+TYPED_TEST(WaitOnAddressTest, ReturnsIfValueDiffers) {
+  std::atomic<TypeParam> word(1);
+  absl::WaitOnAddress(&word, 0);
+  EXPECT_TRUE(absl::WaitOnAddressWithTimeout(&word, 0, absl::Seconds(60)));
+  EXPECT_TRUE(absl::WaitOnAddressWithDeadline(&word, 0, absl::InfinitePast()));
+}
+
+TYPED_TEST(WaitOnAddressTest, TimesOut) {
+  std::atomic<TypeParam> word(0);
+  EXPECT_FALSE(absl::WaitOnAddressWithDeadline(&word, 0, absl::InfinitePast()));
+  absl::Time start = absl::Now();
+  EXPECT_FALSE(absl::WaitOnAddressWithTimeout(&word, 0, absl::Milliseconds(50)));
+  EXPECT_LE(start + absl::Milliseconds(50), absl::Now());
+}
+
+TYPED_TEST(WaitOnAddressTest, WakeWithoutWaiters) {
+  std::atomic<TypeParam> word(0);
+  absl::WakeByAddress(&word);
+  absl::WakeAllByAddress(&word);
+}
+
+TYPED_TEST(WaitOnAddressTest, WakesAllWaiters) {
+  constexpr int kWaiters = 8;
+  std::atomic<TypeParam> word(0);
+  std::atomic<int> done(0);
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < kWaiters; i++) {
+    waiters.emplace_back([&] {
+      while (word.load(std::memory_order_acquire) == 0) {
+        absl::WaitOnAddress(&word, 0);
+      }
+      done++;
+    });
+  }
+  absl::SleepFor(absl::Milliseconds(50));
+  EXPECT_EQ(done.load(), 0);
+  word.store(1, std::memory_order_release);
+  absl::WakeAllByAddress(&word);
+  for (std::thread& waiter : waiters) waiter.join();
+  EXPECT_EQ(done.load(), kWaiters);
+}
+
+// Waking one address must not lose the wakeups of others, even when they
+// share a wait queue.
+TYPED_TEST(WaitOnAddressTest, ManyAddresses) {
+  constexpr int kWords = 1024;
+  std::vector<std::atomic<TypeParam>> words(kWords);
+  for (auto& word : words) word.store(0);
+  std::vector<std::thread> waiters;
+  for (int i = 0; i < kWords; i += 37) {
+    waiters.emplace_back([&words, i] {
+      while (words[i].load(std::memory_order_acquire) == 0) {
+        absl::WaitOnAddress(&words[i], 0);
+      }
+    });
+  }
+  absl::SleepFor(absl::Milliseconds(10));
+  for (int i = 0; i < kWords; i++) {
+    words[i].store(1, std::memory_order_release);
+    absl::WakeByAddress(&words[i]);
+  }
+  for (std::thread& waiter : waiters) waiter.join();
+}
+
+// A lock in one word: 0 if free, 1 if held, and 2 if held with waiters.
+template <typename T>
+class WordLock {
+ public:
+  void Lock() {
+    T s = 0;
+    if (word_.compare_exchange_strong(s, 1, std::memory_order_acquire)) return;
+    while (word_.exchange(2, std::memory_order_acquire) != 0) {
+      absl::WaitOnAddress(&word_, 2);
+    }
+  }
+
+  void Unlock() {
+    if (word_.exchange(0, std::memory_order_release) == 2) {
+      absl::WakeByAddress(&word_);
+    }
+  }
+
+ private:
+  std::atomic<T> word_{0};
+};
+
+TYPED_TEST(WaitOnAddressTest, OneWordLock) {
+  constexpr int kThreads = 8;
+  constexpr int kIterations = 20000;
+  WordLock<TypeParam> lock;
+  int counter = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kIterations; j++) {
+        lock.Lock();
+        counter++;
+        lock.Unlock();
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  EXPECT_EQ(counter, kThreads * kIterations);
+}
+
+// Waiters that time out while others are being woken must neither lose a
+// wakeup nor leave a stale one behind.
+TYPED_TEST(WaitOnAddressTest, TimeoutsRaceWithWakes) {
+  constexpr int kThreads = 4;
+  constexpr int kIterations = 2000;
+  std::atomic<TypeParam> word(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&word] {
+      for (int j = 0; j < kIterations; j++) {
+        TypeParam s = word.load(std::memory_order_relaxed);
+        absl::WaitOnAddressWithTimeout(&word, s, absl::Microseconds(10));
+      }
+    });
+  }
+  for (int j = 0; j < kIterations; j++) {
+    word.fetch_add(1, std::memory_order_relaxed);
+    absl::WakeByAddress(&word, 2);
+  }
+  for (std::thread& thread : threads) thread.join();
+}
+
+}  // namespace
@@ -178,7 +178,9 @@ static int64_t GetCurrentTimeNanosFromKernel(uint64_t last_cycleclock,
 // value (either case suggests possible interference from a writer).
 // Here we use a spinlock to ensure only one writer at a time, rather than
 // spinning on the bottom bit of the word to benefit from SpinLock
-// spin-delay tuning.
+// spin-delay tuning.  absl::SeqLock (absl/synchronization/seqlock.h) packages
+// the same scheme for general use; it is not used here because
+// absl/synchronization depends on absl/time.
 
 // Acquire seqlock (*seq) and return the value to be written to unlock.
 static inline uint64_t SeqAcquire(std::atomic<uint64_t> *seq) {